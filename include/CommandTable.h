@@ -0,0 +1,341 @@
+#ifndef _COMMANDTABLE_H_
+#define _COMMANDTABLE_H_
+
+/**
+ * \class	CommandTable
+ * \brief	Used to look commands up by name in O(1), however many there
+ *		are. A perfect hash over the names of N entries, built
+ *		at compile time by hash-and-displace: every name falls into a
+ *		bucket, and each bucket (largest first) is given the smallest
+ *		displacement that moves all of its names to free slots. A
+ *		lookup hashes the name once, reads its bucket's displacement
+ *		and compares against the single name in the slot it lands on.
+ *		Building a table from duplicate names fails to compile
+ */
+template <size_t N>
+class CommandTable {
+
+
+
+public:
+
+	/**
+	 * \var		static const size_t NOT_FOUND
+	 * \brief	Returned by find for a name that is not in the table
+	 */
+	static constexpr size_t NOT_FOUND = N;
+
+	/**
+	 * \fn		Constructor
+	 * \param	const Entry (&entries)[N]
+	 * \return	N/A
+	 * \brief	Builds the table from the command member of each entry.
+	 *		Meant to initialize a constexpr variable, so the table is
+	 *		built by the compiler
+	 */
+	template <typename Entry>
+	constexpr CommandTable(const Entry (&entries)[N]) : names(), displacements(), slots() {
+		size_t sizes[BUCKETS] = {};
+		bool placed[BUCKETS] = {};
+		size_t bucket;
+
+		for (size_t i = 0; i < N; i++) {
+			names[i] = entries[i].command;
+
+			for (size_t j = 0; j < i; j++) {
+				if (names[i] == names[j]) {
+					throw "CommandTable: command registered twice";
+				}
+			}
+
+			sizes[hash(names[i]) & (BUCKETS - 1)]++;
+		}
+
+		for (size_t slot = 0; slot < SLOTS; slot++) {
+			slots[slot] = NOT_FOUND;
+		}
+
+		/**
+		 *	- Place the largest bucket left each round, while there are
+		 *	  still many free slots to choose from
+		 */
+		for (size_t round = 0; round < BUCKETS; round++) {
+			bucket = BUCKETS;
+			for (size_t i = 0; i < BUCKETS; i++) {
+				if (!placed[i] && (bucket == BUCKETS || sizes[i] > sizes[bucket])) {
+					bucket = i;
+				}
+			}
+
+			placed[bucket] = true;
+			if (sizes[bucket] == 0) {
+				break;
+			}
+
+			while (!place(bucket, displacements[bucket])) {
+				displacements[bucket]++;
+			}
+		}
+	}
+
+	/**
+	 * \fn		size_t find
+	 * \param	std::string_view name
+	 * \return	Returns the index of the entry named name, or NOT_FOUND
+	 * \brief	Looks name up with one hash and one comparison
+	 */
+	constexpr size_t find(std::string_view name) const {
+		size_t index;
+
+		index = probe(name);
+
+		if (index == NOT_FOUND || names[index] != name) {
+			return NOT_FOUND;
+		}
+
+		return index;
+	}
+
+	/**
+	 * \fn		size_t probe
+	 * \param	std::string_view name
+	 * \return	Returns the index of the entry in the slot name lands on,
+	 *		or NOT_FOUND if the slot is free
+	 * \brief	The lookup of find before the comparison. A name that is
+	 *		not in the table may land on another entry's slot
+	 */
+	constexpr size_t probe(std::string_view name) const {
+		uint64_t name_hash;
+
+		name_hash = hash(name);
+		return slots[get_slot(name_hash, displacements[name_hash & (BUCKETS - 1)])];
+	}
+
+
+
+private:
+
+	/**
+	 * \fn		size_t round_up
+	 * \param	size_t count
+	 * \return	Returns the smallest power of two of at least count
+	 * \brief	Sizes of the bucket and slot arrays, so they are indexed
+	 *		by masking
+	 */
+	static constexpr size_t round_up(size_t count) {
+		size_t size = 1;
+
+		while (size < count) {
+			size *= 2;
+		}
+
+		return size;
+	}
+
+	/**
+	 * \var		static const size_t BUCKETS, SLOTS
+	 * \brief	Number of buckets and slots. Twice as many slots as names
+	 *		keeps the search for displacements short
+	 */
+	static constexpr size_t BUCKETS = round_up(N);
+	static constexpr size_t SLOTS = round_up(2 * N);
+
+	/**
+	 * \fn		uint64_t hash
+	 * \param	std::string_view name
+	 * \return	Returns the FNV-1a hash of name
+	 * \brief	Picks the bucket of name, and is mixed with a displacement
+	 *		to pick its slot
+	 */
+	static constexpr uint64_t hash(std::string_view name) {
+		uint64_t name_hash = 14695981039346656037ULL;
+
+		for (char c : name) {
+			name_hash ^= (unsigned char)c;
+			name_hash *= 1099511628211ULL;
+		}
+
+		return name_hash;
+	}
+
+	/**
+	 * \fn		size_t get_slot
+	 * \param	uint64_t name_hash
+	 * \param	uint32_t displacement
+	 * \return	Returns the slot a name lands on
+	 * \brief	Mixes the displacement of the name's bucket into its hash
+	 *		(the finalizer of SplitMix64)
+	 */
+	static constexpr size_t get_slot(uint64_t name_hash, uint32_t displacement) {
+		uint64_t mixed = name_hash ^ ((displacement + 1ULL) * 0x9E3779B97F4A7C15ULL);
+
+		mixed = (mixed ^ (mixed >> 30)) * 0xBF58476D1CE4E5B9ULL;
+		mixed = (mixed ^ (mixed >> 27)) * 0x94D049BB133111EBULL;
+		mixed = mixed ^ (mixed >> 31);
+
+		return mixed & (SLOTS - 1);
+	}
+
+	/**
+	 * \fn		bool place
+	 * \param	size_t bucket
+	 * \param	uint32_t displacement
+	 * \return	Returns false, having changed nothing, if any two names of
+	 *		the bucket would share a slot or land on a taken one
+	 * \brief	Moves every name of bucket to its slot under displacement
+	 */
+	constexpr bool place(size_t bucket, uint32_t displacement) {
+		size_t taken[N] = {};
+		size_t count = 0;
+		size_t slot;
+
+		for (size_t i = 0; i < N; i++) {
+			if ((hash(names[i]) & (BUCKETS - 1)) != bucket) {
+				continue;
+			}
+
+			slot = get_slot(hash(names[i]), displacement);
+			if (slots[slot] != NOT_FOUND) {
+				return false;
+			}
+
+			for (size_t j = 0; j < count; j++) {
+				if (taken[j] == slot) {
+					return false;
+				}
+			}
+
+			taken[count++] = slot;
+		}
+
+		count = 0;
+		for (size_t i = 0; i < N; i++) {
+			if ((hash(names[i]) & (BUCKETS - 1)) == bucket) {
+				slots[taken[count++]] = i;
+			}
+		}
+
+		return true;
+	}
+
+	/**
+	 * \var		std::string_view names[N]
+	 * \brief	Name of each entry, to confirm a lookup
+	 */
+	std::string_view names[N];
+
+	/**
+	 * \var		uint32_t displacements[BUCKETS]
+	 * \brief	Displacement of each bucket
+	 */
+	uint32_t displacements[BUCKETS];
+
+	/**
+	 * \var		size_t slots[SLOTS]
+	 * \brief	Index of the entry in each slot, or NOT_FOUND
+	 */
+	size_t slots[SLOTS];
+};
+
+/**
+ * \struct	CommandTableCheck
+ * \brief	Entry of the tables the static assertions below are built from
+ */
+struct CommandTableCheck {
+	const char* command;
+};
+
+/**
+ * \var		COMMAND_TABLE_CHECK
+ * \brief	Names a table is built from to check CommandTable at compile
+ *		time, some of them prefixes or case variants of others
+ */
+static constexpr CommandTableCheck COMMAND_TABLE_CHECK[] = {
+	{ "GetPlayerInfo" },	{ "GetPlayerInfoEx" },	{ "GetPlayer" },	{ "getplayerinfo" },
+	{ "GetBalance" },	{ "SetBalance" },	{ "AddCredits" },	{ "RemoveCredits" },
+	{ "TransferCredits" },	{ "GetCardStatus" },	{ "LockCard" },	{ "UnlockCard" },
+	{ "ChangePIN" },	{ "ResetPIN" },		{ "GetSessions" },	{ "OpenSession" },
+	{ "CloseSession" },	{ "GetMachineInfo" },	{ "GetMachineStatus" },	{ "SetMachineStatus" },
+	{ "GetJackpot" },	{ "AwardJackpot" },	{ "GetPromotions" },	{ "RedeemPromotion" },
+	{ "GetTier" },		{ "SetTier" },		{ "GetPoints" },	{ "AddPoints" },
+	{ "RedeemPoints" },	{ "GetHistory" },	{ "Ping" },		{ "P" },
+	{ "" },			{ "Shutdown" },		{ "GetVersion" },	{ "GetStatistics" }
+};
+
+/**
+ * \var		COMMAND_TABLE_CHECK_COUNT
+ * \brief	Number of entries in COMMAND_TABLE_CHECK
+ */
+static constexpr size_t COMMAND_TABLE_CHECK_COUNT = sizeof(COMMAND_TABLE_CHECK) / sizeof(COMMAND_TABLE_CHECK[0]);
+
+/**
+ * \fn		bool check_command_table_members
+ * \param	N/A
+ * \return	Returns true if every name of COMMAND_TABLE_CHECK, and of
+ *		each of its prefixes, is found at its own index
+ * \brief	Checks tables of 1 to COMMAND_TABLE_CHECK_COUNT names, so
+ *		the bucket and slot arrays are of every size up to 64
+ */
+static constexpr bool check_command_table_members() {
+	bool found = true;
+
+	[&]<size_t... COUNTS>(std::index_sequence<COUNTS...>) {
+		([&] {
+			CommandTableCheck entries[COUNTS + 1] = {};
+
+			for (size_t i = 0; i <= COUNTS; i++) {
+				entries[i] = COMMAND_TABLE_CHECK[i];
+			}
+
+			CommandTable<COUNTS + 1> table(entries);
+
+			for (size_t i = 0; i <= COUNTS; i++) {
+				found = found && table.find(entries[i].command) == i;
+			}
+		}(), ...);
+	}(std::make_index_sequence<COMMAND_TABLE_CHECK_COUNT>());
+
+	return found;
+}
+
+/**
+ * \fn		bool check_command_table_non_members
+ * \param	N/A
+ * \return	Returns true if no name outside COMMAND_TABLE_CHECK is found
+ *		in its table, including names that land on the slot of one
+ *		that is, and some of those were tried
+ * \brief	Tries names that differ from members by one character or in
+ *		length, and a thousand made-up names (about half of which
+ *		land on a taken slot, as half the slots are taken)
+ */
+static constexpr bool check_command_table_non_members() {
+	constexpr CommandTable<COMMAND_TABLE_CHECK_COUNT> table(COMMAND_TABLE_CHECK);
+	constexpr const char* NEAR_MISSES[] = { "GetPlayerInf", "GetPlayerInfoE", "getPlayerInfo", "GETPLAYERINFO", "GetPlayerInfo ", " GetPlayerInfo", "Pi", "p", "Q", "ShutDown" };
+	char name[] = "X000";
+	size_t collisions = 0;
+
+	for (const char* near_miss : NEAR_MISSES) {
+		if (table.find(near_miss) != table.NOT_FOUND) {
+			return false;
+		}
+	}
+
+	for (int i = 0; i < 1000; i++) {
+		name[1] = '0' + i / 100;
+		name[2] = '0' + i / 10 % 10;
+		name[3] = '0' + i % 10;
+
+		if (table.find(name) != table.NOT_FOUND) {
+			return false;
+		}
+
+		collisions += table.probe(name) != table.NOT_FOUND;
+	}
+
+	return collisions > 0;
+}
+
+static_assert(check_command_table_members(), "CommandTable: a name was not found at its own index");
+static_assert(check_command_table_non_members(), "CommandTable: a name not in the table was found, or none landed on a taken slot");
+
+#endif
@@ -0,0 +1,220 @@
+#ifndef _CONNECTION_H_
+#define _CONNECTION_H_
+
+/**
+ * \brief	Connection drives the client through the server that owns it
+ */
+class SocketServer;
+class SocketClient;
+
+/**
+ * \class	Connection
+ * \brief	Used to write the handling of a client as a straight-line C++20
+ *		coroutine on top of the event loop. read_frame and write are
+ *		awaited instead of blocking, and the event loop resumes the
+ *		coroutine once the client socket is ready, so one thread drives
+ *		every connection without a stack per connection
+ */
+class Connection {
+
+
+
+public:
+
+	/**
+	 * \struct	Task
+	 * \brief	Return type of a connection coroutine. The coroutine starts
+	 *		running as soon as it is invoked and stays suspended once
+	 *		it has finished, until the Connection destroys it
+	 */
+	struct Task {
+		struct promise_type {
+			Task get_return_object() { return Task{ std::coroutine_handle<promise_type>::from_promise(*this) }; }
+			std::suspend_never initial_suspend() noexcept { return {}; }
+			std::suspend_always final_suspend() noexcept { return {}; }
+			void return_void() {}
+			void unhandled_exception() { std::terminate(); }
+		};
+
+		std::coroutine_handle<promise_type> handle;
+	};
+
+	/**
+	 * \struct	FrameAwaiter
+	 * \brief	Returned by read_frame. Completes at once if a request is
+	 *		already buffered. Otherwise flushes the queued responses and
+	 *		suspends until the event loop has received the rest
+	 */
+	struct FrameAwaiter {
+		Connection* connection;
+		bool await_ready();
+		bool await_suspend(std::coroutine_handle<> handle);
+		int await_resume();
+	};
+
+	/**
+	 * \struct	WriteAwaiter
+	 * \brief	Returned by write. Completes at once while few response
+	 *		bytes are pending. Otherwise flushes them and suspends until
+	 *		the client socket has taken them all
+	 */
+	struct WriteAwaiter {
+		Connection* connection;
+		bool await_ready();
+		bool await_suspend(std::coroutine_handle<> handle);
+		int await_resume();
+	};
+
+	/**
+	 * \fn		Constructor
+	 * \param	SocketServer *_server
+	 * \param	SocketClient *_source
+	 * \return	N/A
+	 * \brief	The connection drives source through _server
+	 */
+	Connection(SocketServer *_server, SocketClient *_source);
+
+	/**
+	 * \fn		Destructor
+	 * \param	N/A
+	 * \return	N/A
+	 * \brief	Destroys the coroutine wherever it is suspended
+	 */
+	~Connection();
+
+	/**
+	 * \brief	A Connection owns its coroutine, so it cannot be copied
+	 */
+	Connection(const Connection&) = delete;
+	Connection& operator=(const Connection&) = delete;
+
+	/**
+	 * \fn		void start
+	 * \param	Task _task
+	 * \return	N/A
+	 * \brief	Takes ownership of the coroutine, which has already run up
+	 *		to its first suspension
+	 */
+	void start(Task _task);
+
+	/**
+	 * \fn		FrameAwaiter read_frame
+	 * \param	char **_frame
+	 * \param	size_t *_length
+	 * \return	Returns an awaiter resuming with EXIT_SUCCESS (and frame
+	 *		and length set) once a complete request is buffered, or
+	 *		EXIT_FAILURE if the request is too large or the queued
+	 *		responses could not be sent
+	 * \brief	The frame points into the client's buffer and stays valid
+	 *		until the coroutine next suspends on read_frame
+	 */
+	FrameAwaiter read_frame(char **_frame, size_t *_length);
+
+	/**
+	 * \fn		WriteAwaiter write
+	 * \param	std::string *response
+	 * \return	Returns an awaiter resuming with EXIT_SUCCESS once the
+	 *		response is queued (and, if too many bytes are pending, sent),
+	 *		or EXIT_FAILURE if it could not be sent
+	 * \brief	The response is moved into the client's queue, the same as
+	 *		send_response_to_client, and left empty but holding a spare
+	 *		buffer of the queue if it has one, to build the next in
+	 */
+	WriteAwaiter write(std::string *response);
+
+	/**
+	 * \fn		void resume
+	 * \param	N/A
+	 * \return	N/A
+	 * \brief	Invoked by the event loop after receiving from or sending
+	 *		to the client. Resumes the coroutine if what it is waiting
+	 *		for is now available
+	 */
+	void resume();
+
+	/**
+	 * \fn		bool done
+	 * \param	N/A
+	 * \return	Returns true once the coroutine has finished
+	 * \brief	The event loop disconnects the client once this is true
+	 */
+	bool done();
+
+	/**
+	 * \fn		bool reading
+	 * \param	N/A
+	 * \return	Returns false while the coroutine waits for the client to
+	 *		take the responses pending for it
+	 * \brief	The event loop stops receiving from the client until this
+	 *		is true again, so a client that sends requests without
+	 *		reading their responses cannot make its input grow
+	 */
+	bool reading();
+
+
+
+private:
+
+	/**
+	 * \var		static const size_t MAX_PENDING_OUTPUT
+	 * \brief	Response bytes a write may leave queued without sending
+	 *		them, so pipelined responses still go out in batches
+	 */
+	static const size_t MAX_PENDING_OUTPUT = 64 * 1024;
+
+	/**
+	 * \enum	Waiting
+	 * \brief	What a suspended coroutine is waiting for
+	 */
+	enum Waiting {
+		WAITING_NONE,
+		WAITING_FRAME,
+		WAITING_WRITE
+	};
+
+	/**
+	 * \var		SocketServer* server
+	 * \brief	Server whose event loop drives the connection
+	 */
+	SocketServer* server;
+
+	/**
+	 * \var		SocketClient* source
+	 * \brief	The client the connection reads from and writes to
+	 */
+	SocketClient* source;
+
+	/**
+	 * \var		std::coroutine_handle<> handle
+	 * \brief	The coroutine, or NULL before start
+	 */
+	std::coroutine_handle<> handle;
+
+	/**
+	 * \var		Waiting waiting
+	 * \brief	What the coroutine is suspended on
+	 */
+	Waiting waiting;
+
+	/**
+	 * \var		char** frame
+	 * \var		size_t* length
+	 * \brief	Where read_frame hands the next request to
+	 */
+	char** frame;
+	size_t* length;
+
+	/**
+	 * \var		std::string* response
+	 * \brief	Response being written by write
+	 */
+	std::string* response;
+
+	/**
+	 * \var		int result
+	 * \brief	Result the awaited operation resumes with
+	 */
+	int result;
+};
+
+#endif
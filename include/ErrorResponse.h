@@ -0,0 +1,64 @@
+#ifndef _ERRORRESPONSE_H_
+#define _ERRORRESPONSE_H_
+
+/**
+ * \struct	ErrorResponse
+ * \brief	A complete, serialized error response of N - 1 bytes, built by
+ *		the compiler (see make_error_response) so that sending it takes
+ *		no XML building, serializing or escaping
+ */
+template <size_t N>
+struct ErrorResponse {
+	char text[N];
+
+	/**
+	 * \fn		std::string_view view
+	 * \param	N/A
+	 * \return	Returns the response, without its null terminator
+	 * \brief	The bytes to send
+	 */
+	constexpr std::string_view view() const {
+		return std::string_view(text, N - 1);
+	}
+};
+
+/**
+ * \var		ERROR_RESPONSE_HEAD, ERROR_RESPONSE_MIDDLE, ERROR_RESPONSE_TAIL
+ * \brief	The bytes of every error response around its Command node and
+ *		its ErrorMessage, as get_printable_xml would give them
+ */
+static constexpr char ERROR_RESPONSE_HEAD[] = "<Response>\n";
+static constexpr char ERROR_RESPONSE_MIDDLE[] = "\n<Status>Fail</Status>\n<Data>\n<Row Type=\"ErrorMessage\">";
+static constexpr char ERROR_RESPONSE_TAIL[] = "</Row>\n</Data>\n</Response>\n";
+
+/**
+ * \fn		ErrorResponse make_error_response
+ * \param	const char (&command)[C]
+ * \param	const char (&message)[M]
+ * \return	Returns the error response with command as its serialized
+ *		Command node and message as its ErrorMessage
+ * \brief	Meant to initialize a constexpr variable. message is copied
+ *		as it is, so one that would need escaping fails to compile
+ */
+template <size_t C, size_t M>
+constexpr ErrorResponse<sizeof(ERROR_RESPONSE_HEAD) + C + sizeof(ERROR_RESPONSE_MIDDLE) + M + sizeof(ERROR_RESPONSE_TAIL) - 4> make_error_response(const char (&command)[C], const char (&message)[M]) {
+	ErrorResponse<sizeof(ERROR_RESPONSE_HEAD) + C + sizeof(ERROR_RESPONSE_MIDDLE) + M + sizeof(ERROR_RESPONSE_TAIL) - 4> response = {};
+	const char* parts[] = { ERROR_RESPONSE_HEAD, command, ERROR_RESPONSE_MIDDLE, message, ERROR_RESPONSE_TAIL };
+	size_t offset = 0;
+
+	for (size_t i = 0; i < M - 1; i++) {
+		if (message[i] == '&' || message[i] == '<' || message[i] == '>' || (unsigned char)message[i] < 32) {
+			throw "make_error_response: message needs escaping";
+		}
+	}
+
+	for (const char* part : parts) {
+		for (size_t i = 0; part[i] != '\0'; i++) {
+			response.text[offset++] = part[i];
+		}
+	}
+
+	return response;
+}
+
+#endif
@@ -0,0 +1,204 @@
+#ifndef _FRAMEBUFFER_H_
+#define _FRAMEBUFFER_H_
+
+/**
+ * \enum	Framing
+ * \brief	How requests (and responses) are delimited on a connection
+ *	- FRAMING_NEWLINE: each request is a single line ending in "\n"
+ *	  (optionally "\r\n"), as typed into netcat. Each response ends in
+ *	  a null terminator
+ *	- FRAMING_LENGTH_PREFIX: each request and response is preceded by
+ *	  its length in bytes as a 4-byte unsigned integer in network byte
+ *	  order
+ *	- FRAMING_DOCUMENT: each request ends with the end tag of its root
+ *	  element, found by following the XML as it is received, so it may
+ *	  span lines and needs no delimiter. Each response ends in a null
+ *	  terminator
+ */
+enum Framing {
+	FRAMING_NEWLINE,
+	FRAMING_LENGTH_PREFIX,
+	FRAMING_DOCUMENT
+};
+
+/**
+ * \enum	FrameStatus
+ * \brief	Result of looking for the next frame in a FrameBuffer
+ */
+enum FrameStatus {
+	FRAME_COMPLETE,
+	FRAME_INCOMPLETE,
+	FRAME_TOO_LARGE,
+	FRAME_INVALID
+};
+
+/**
+ * \class	FrameBuffer
+ * \brief	Used to accumulate the bytes received from a client across
+ *		partial reads and split them into complete frames. Frames are
+ *		handed out in place, without being copied
+ */
+class FrameBuffer {
+
+
+
+public:
+
+	/**
+	 * \fn		Constructor
+	 * \param	N/A
+	 * \return	N/A
+	 * \brief	No parameters passed. The buffer starts empty and only
+	 *		allocates once data is received
+	 */
+	FrameBuffer();
+
+	/**
+	 * \fn		Destructor
+	 * \param	N/A
+	 * \return	N/A
+	 * \brief	Frees the buffer
+	 */
+	~FrameBuffer();
+
+	/**
+	 * \brief	A FrameBuffer owns its memory, so it cannot be copied
+	 */
+	FrameBuffer(const FrameBuffer&) = delete;
+	FrameBuffer& operator=(const FrameBuffer&) = delete;
+
+	/**
+	 * \fn		int set_framing
+	 * \param	Framing _framing
+	 * \param	size_t _max_frame_size
+	 * \return	Returns EXIT_SUCCESS
+	 * \brief	Setter for how frames are delimited and how large a single
+	 *		frame may grow before it is rejected
+	 */
+	int set_framing(Framing _framing, size_t _max_frame_size);
+
+	/**
+	 * \fn		char* reserve
+	 * \param	size_t size
+	 * \return	Returns where to write up to size more bytes, or NULL if
+	 *		the buffer could not grow
+	 * \brief	Makes room for size more bytes after the buffered ones,
+	 *		first by moving an incomplete frame to the front and only
+	 *		then by growing. Frames handed out earlier are invalidated
+	 */
+	char* reserve(size_t size);
+
+	/**
+	 * \fn		void commit
+	 * \param	size_t size
+	 * \return	N/A
+	 * \brief	Marks size bytes written after reserve as buffered
+	 */
+	void commit(size_t size);
+
+	/**
+	 * \fn		int append
+	 * \param	const char *bytes
+	 * \param	size_t size
+	 * \return	Returns EXIT_FAILURE if the buffer could not grow,
+	 *		and EXIT_SUCCESS otherwise
+	 * \brief	Copies bytes received elsewhere into the buffer
+	 */
+	int append(const char *bytes, size_t size);
+
+	/**
+	 * \fn		FrameStatus next_frame
+	 * \param	char **frame
+	 * \param	size_t *length
+	 * \return	Returns FRAME_COMPLETE (and sets frame and length) if a
+	 *		complete frame is buffered, FRAME_INCOMPLETE if more bytes
+	 *		are needed, FRAME_TOO_LARGE if the frame being received
+	 *		exceeds the max frame size, and FRAME_INVALID if it cannot
+	 *		be an XML document (with FRAMING_DOCUMENT)
+	 * \brief	Takes the next complete frame out of the buffer. The frame
+	 *		points into the buffer (without its delimiter or length
+	 *		prefix) and stays valid until the next reserve or append
+	 */
+	FrameStatus next_frame(char **frame, size_t *length);
+
+	/**
+	 * \fn		size_t get_length
+	 * \param	N/A
+	 * \return	Returns the number of buffered bytes not yet taken out
+	 *		as frames
+	 * \brief	Getter for buffered length
+	 */
+	size_t get_length();
+
+	/**
+	 * \fn		unsigned long long get_frames
+	 * \param	N/A
+	 * \return	Returns the number of complete frames taken out so far
+	 * \brief	Getter for frame count (tells a new request apart from
+	 *		the rest of one already being received)
+	 */
+	unsigned long long get_frames();
+
+
+
+private:
+
+	/**
+	 * \var		char* data
+	 * \brief	The buffer (NULL until the first reserve)
+	 */
+	char* data;
+
+	/**
+	 * \var		size_t capacity
+	 * \brief	Allocated size of data
+	 */
+	size_t capacity;
+
+	/**
+	 * \var		size_t start
+	 * \brief	Offset of the first byte not yet taken out as a frame
+	 */
+	size_t start;
+
+	/**
+	 * \var		size_t end
+	 * \brief	Offset just past the last buffered byte
+	 */
+	size_t end;
+
+	/**
+	 * \var		size_t scanned
+	 * \brief	Offset up to which the buffer is known to hold no newline
+	 *		(or has been fed to document), so bytes trickling in are
+	 *		never searched twice
+	 */
+	size_t scanned;
+
+	/**
+	 * \var		pugi::xml_incremental_parser document
+	 * \brief	Follows the XML of the frame being received, with
+	 *		FRAMING_DOCUMENT, to find where it ends
+	 */
+	pugi::xml_incremental_parser document;
+
+	/**
+	 * \var		Framing framing
+	 * \brief	How frames are delimited
+	 */
+	Framing framing;
+
+	/**
+	 * \var		size_t max_frame_size
+	 * \brief	Largest frame accepted
+	 */
+	size_t max_frame_size;
+
+	/**
+	 * \var		unsigned long long frames
+	 * \brief	Number of complete frames taken out so far
+	 */
+	unsigned long long frames;
+};
+
+#endif
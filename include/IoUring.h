@@ -0,0 +1,201 @@
+#ifndef _IOURING_H_
+#define _IOURING_H_
+
+/**
+ * \class	IoUring
+ * \brief	Used to abstract an io_uring instance (submission queue,
+ *		completion queue, and a kernel-provided buffer ring for recv)
+ *		on top of the raw io_uring system calls
+ */
+class IoUring {
+
+
+
+public:
+
+	/**
+	 * \fn		Constructor
+	 * \param	N/A
+	 * \return	N/A
+	 * \brief	No parameters passed
+	 */
+	IoUring();
+
+	/**
+	 * \fn		Destructor
+	 * \param	N/A
+	 * \return	N/A
+	 * \brief	Unmaps the rings and closes the io_uring file descriptor
+	 */
+	~IoUring();
+
+	/**
+	 * \fn		int setup
+	 * \param	unsigned entries
+	 * \return	Returns EXIT_FAILURE upon any failures encountered,
+	 *		and EXIT_SUCCESS otherwise
+	 * \brief	Creates the io_uring instance with room for the given
+	 *		number of submission queue entries and maps its rings
+	 */
+	int setup(unsigned entries);
+
+	/**
+	 * \fn		io_uring_sqe* get_sqe
+	 * \param	N/A
+	 * \return	Returns a zeroed submission queue entry to fill in, or
+	 *		NULL if the submission queue is full and cannot be submitted
+	 * \brief	Entries are only handed to the kernel by submit_and_wait,
+	 *		so everything prepared in between is submitted as one batch
+	 */
+	io_uring_sqe* get_sqe();
+
+	/**
+	 * \fn		int submit_and_wait
+	 * \param	unsigned wait_nr
+	 * \return	Returns the number of entries submitted, or -1 with errno
+	 *		set upon failure
+	 * \brief	Submits every prepared entry and waits until at least
+	 *		wait_nr completions are available, in a single system call
+	 */
+	int submit_and_wait(unsigned wait_nr);
+
+	/**
+	 * \fn		io_uring_cqe* peek_cqe
+	 * \param	N/A
+	 * \return	Returns the oldest unseen completion queue entry, or NULL
+	 *		if there is none
+	 * \brief	The entry stays valid until cqe_seen is invoked
+	 */
+	io_uring_cqe* peek_cqe();
+
+	/**
+	 * \fn		void cqe_seen
+	 * \param	N/A
+	 * \return	N/A
+	 * \brief	Hands the entry returned by peek_cqe back to the kernel
+	 */
+	void cqe_seen();
+
+	/**
+	 * \fn		int register_buffer_ring
+	 * \param	unsigned short group
+	 * \param	unsigned short entries
+	 * \param	unsigned size
+	 * \return	Returns EXIT_FAILURE upon any failures encountered,
+	 *		and EXIT_SUCCESS otherwise
+	 * \brief	Allocates entries buffers of size bytes each and provides
+	 *		them to the kernel as buffer group group. entries must be
+	 *		a power of 2
+	 */
+	int register_buffer_ring(unsigned short group, unsigned short entries, unsigned size);
+
+	/**
+	 * \fn		char* get_buffer
+	 * \param	unsigned short id
+	 * \return	Returns the provided buffer with the given id
+	 * \brief	Used to find the data of a completion that selected a buffer
+	 */
+	char* get_buffer(unsigned short id);
+
+	/**
+	 * \fn		void recycle_buffer
+	 * \param	unsigned short id
+	 * \return	N/A
+	 * \brief	Provides the buffer with the given id back to the kernel
+	 *		once its data has been consumed
+	 */
+	void recycle_buffer(unsigned short id);
+
+
+
+private:
+
+	/**
+	 * \var		int ring_file_descriptor
+	 * \brief	Identifier for the io_uring instance
+	 */
+	int ring_file_descriptor;
+
+	/**
+	 * \var		unsigned sq_entries
+	 * \brief	Number of entries in the submission queue
+	 */
+	unsigned sq_entries;
+
+	/**
+	 * \var		unsigned *sq_head, *sq_tail, *sq_mask, *sq_array
+	 * \brief	Submission queue ring fields shared with the kernel
+	 */
+	unsigned* sq_head;
+	unsigned* sq_tail;
+	unsigned* sq_mask;
+	unsigned* sq_array;
+
+	/**
+	 * \var		unsigned sqe_tail
+	 * \brief	Tail of the prepared (not yet submitted) entries
+	 */
+	unsigned sqe_tail;
+
+	/**
+	 * \var		io_uring_sqe* sqes
+	 * \brief	Submission queue entries shared with the kernel
+	 */
+	io_uring_sqe* sqes;
+
+	/**
+	 * \var		unsigned *cq_head, *cq_tail, *cq_mask
+	 * \brief	Completion queue ring fields shared with the kernel
+	 */
+	unsigned* cq_head;
+	unsigned* cq_tail;
+	unsigned* cq_mask;
+
+	/**
+	 * \var		io_uring_cqe* cqes
+	 * \brief	Completion queue entries shared with the kernel
+	 */
+	io_uring_cqe* cqes;
+
+	/**
+	 * \var		void *sq_ring, *cq_ring
+	 * \brief	Mappings of the submission and completion queue rings
+	 *		(the same mapping if the kernel supports a single mmap)
+	 */
+	void* sq_ring;
+	void* cq_ring;
+
+	/**
+	 * \var		size_t sq_ring_size, cq_ring_size, sqes_size
+	 * \brief	Sizes of the mappings
+	 */
+	size_t sq_ring_size;
+	size_t cq_ring_size;
+	size_t sqes_size;
+
+	/**
+	 * \var		io_uring_buf_ring* buffer_ring
+	 * \brief	Ring through which buffers are provided to the kernel
+	 */
+	io_uring_buf_ring* buffer_ring;
+
+	/**
+	 * \var		char* buffers
+	 * \brief	Memory backing every provided buffer
+	 */
+	char* buffers;
+
+	/**
+	 * \var		unsigned buffer_size
+	 * \brief	Size of each provided buffer
+	 */
+	unsigned buffer_size;
+
+	/**
+	 * \var		unsigned short buffer_entries
+	 * \brief	Number of provided buffers (and entries in buffer_ring)
+	 */
+	unsigned short buffer_entries;
+};
+
+#endif
@@ -0,0 +1,147 @@
+#ifndef _NAMERESOLVER_H_
+#define _NAMERESOLVER_H_
+
+/**
+ * \class	NameResolver
+ * \brief	Used to look up client host names off the accept path. Host
+ *		names are resolved on a thread of their own and cached per
+ *		IP address for a time to live, so accepting a client never
+ *		waits on DNS. Shared by every shard
+ */
+class NameResolver {
+
+
+
+public:
+
+	/**
+	 * \fn		Constructor
+	 * \param	N/A
+	 * \return	N/A
+	 * \brief	No parameters passed
+	 */
+	NameResolver();
+
+	/**
+	 * \fn		Destructor
+	 * \param	N/A
+	 * \return	N/A
+	 * \brief	Stops the resolver thread
+	 */
+	~NameResolver();
+
+	/**
+	 * \fn		int start
+	 * \param	int _ttl
+	 * \return	Returns EXIT_FAILURE upon any failures encountered,
+	 *		and EXIT_SUCCESS otherwise
+	 * \brief	Starts the resolver thread. Resolved host names are cached
+	 *		for _ttl seconds
+	 */
+	int start(int _ttl);
+
+	/**
+	 * \fn		void stop
+	 * \param	N/A
+	 * \return	N/A
+	 * \brief	Drops the lookups not started yet and joins the resolver
+	 *		thread
+	 */
+	void stop();
+
+	/**
+	 * \fn		int lookup
+	 * \param	const sockaddr_in *socket_address
+	 * \param	char *host_name
+	 * \param	size_t size
+	 * \return	Returns EXIT_SUCCESS (and copies the host name into
+	 *		host_name) if the IP address has a cached host name, and
+	 *		EXIT_FAILURE otherwise
+	 * \brief	Never blocks on DNS. On a miss the IP address is queued for
+	 *		the resolver thread (unless already queued), so later
+	 *		clients from it find its host name cached
+	 */
+	int lookup(const sockaddr_in *socket_address, char *host_name, size_t size);
+
+
+
+private:
+
+	/**
+	 * \var		static const size_t MAX_CACHE_ENTRIES
+	 * \brief	Max number of IP addresses cached. Expired entries are
+	 *		dropped once the cache is full
+	 */
+	static const size_t MAX_CACHE_ENTRIES = 65536;
+
+	/**
+	 * \struct	CacheEntry
+	 * \brief	Host name resolved for an IP address, and until when it
+	 *		may be used
+	 */
+	struct CacheEntry {
+		std::string host_name;
+		std::chrono::steady_clock::time_point expiry;
+	};
+
+	/**
+	 * \fn		void run_resolver
+	 * \param	N/A
+	 * \return	N/A
+	 * \brief	Body of the resolver thread. Resolves queued IP addresses
+	 *		until the resolver is stopped
+	 */
+	void run_resolver();
+
+	/**
+	 * \var		std::mutex cache_mutex
+	 * \brief	Guards cache, pending, queued and stopping
+	 */
+	std::mutex cache_mutex;
+
+	/**
+	 * \var		std::condition_variable lookups_available
+	 * \brief	Signalled whenever an IP address is queued or the resolver
+	 *		is stopped
+	 */
+	std::condition_variable lookups_available;
+
+	/**
+	 * \var		std::unordered_map<in_addr_t, CacheEntry> cache
+	 * \brief	Resolved host names, keyed by IP address
+	 */
+	std::unordered_map<in_addr_t, CacheEntry> cache;
+
+	/**
+	 * \var		std::deque<in_addr_t> pending
+	 * \brief	IP addresses waiting to be resolved, oldest first
+	 */
+	std::deque<in_addr_t> pending;
+
+	/**
+	 * \var		std::unordered_set<in_addr_t> queued
+	 * \brief	IP addresses in pending or being resolved, so a burst of
+	 *		clients from one IP address only resolves it once
+	 */
+	std::unordered_set<in_addr_t> queued;
+
+	/**
+	 * \var		std::thread thread
+	 * \brief	The resolver thread
+	 */
+	std::thread thread;
+
+	/**
+	 * \var		std::chrono::seconds ttl
+	 * \brief	How long a resolved host name is cached
+	 */
+	std::chrono::seconds ttl;
+
+	/**
+	 * \var		bool stopping
+	 * \brief	Set by stop to tell the resolver thread to exit
+	 */
+	bool stopping;
+};
+
+#endif
@@ -0,0 +1,175 @@
+#ifndef _OUTPUTQUEUE_H_
+#define _OUTPUTQUEUE_H_
+
+/**
+ * \class	OutputQueue
+ * \brief	Used to hold the responses waiting to be sent to a client and
+ *		gather them into a single sendmsg, so a batch of pipelined
+ *		requests is answered with one system call instead of one per
+ *		response. Responses are queued without being copied, and the
+ *		buffers of sent responses are kept to build later ones in, so
+ *		a client answered over and over stops allocating for output
+ */
+class OutputQueue {
+
+
+
+public:
+
+	/**
+	 * \fn		Constructor
+	 * \param	N/A
+	 * \return	N/A
+	 * \brief	No parameters passed. The queue starts empty
+	 */
+	OutputQueue();
+
+	/**
+	 * \brief	Gathered vectors point into the queue itself, so it
+	 *		cannot be copied
+	 */
+	OutputQueue(const OutputQueue&) = delete;
+	OutputQueue& operator=(const OutputQueue&) = delete;
+
+	/**
+	 * \fn		int set_framing
+	 * \param	Framing _framing
+	 * \return	Returns EXIT_SUCCESS
+	 * \brief	Setter for how responses are delimited
+	 */
+	int set_framing(Framing _framing);
+
+	/**
+	 * \fn		void push
+	 * \param	std::string *response
+	 * \return	N/A
+	 * \brief	Queues response behind anything still pending, framed the
+	 *		same way as requests: preceded by its length, or followed by
+	 *		a null terminator. The response is moved into the queue and
+	 *		left empty. Bytes already gathered are never moved, so a send
+	 *		in flight is unaffected
+	 */
+	void push(std::string *response);
+
+	/**
+	 * \fn		void reuse
+	 * \param	std::string *buffer
+	 * \return	N/A
+	 * \brief	Hands an empty buffer a spare one, if any: the buffer of a
+	 *		response already sent, cleared but keeping its capacity.
+	 *		Meant to be called before building a response into buffer
+	 */
+	void reuse(std::string *buffer);
+
+	/**
+	 * \fn		msghdr* gather
+	 * \param	bool *more
+	 * \return	Returns a message pointing at the pending bytes, up to
+	 *		MAX_GATHER vectors of them
+	 * \brief	Gathers the pending bytes for sendmsg. more is set if there
+	 *		are pending bytes past the gathered ones. The message stays
+	 *		valid until the next gather or consume
+	 */
+	msghdr* gather(bool *more);
+
+	/**
+	 * \fn		void consume
+	 * \param	size_t size
+	 * \return	N/A
+	 * \brief	Drops size bytes the client socket has taken from the front
+	 *		of the queue
+	 */
+	void consume(size_t size);
+
+	/**
+	 * \fn		bool empty
+	 * \param	N/A
+	 * \return	Returns true if nothing is waiting to be sent
+	 * \brief	Getter for whether the queue is empty
+	 */
+	bool empty();
+
+	/**
+	 * \fn		size_t get_length
+	 * \param	N/A
+	 * \return	Returns the number of bytes waiting to be sent
+	 * \brief	Getter for pending length (length prefixes and null
+	 *		terminators included)
+	 */
+	size_t get_length();
+
+
+
+private:
+
+	/**
+	 * \var		static const int MAX_GATHER
+	 * \brief	Max number of vectors gathered into a single sendmsg (two
+	 *		per response with FRAMING_LENGTH_PREFIX, one otherwise)
+	 */
+	static const int MAX_GATHER = 64;
+
+	/**
+	 * \var		static const size_t MAX_SPARES, MAX_SPARE_CAPACITY
+	 * \brief	Max number of spare buffers kept, and max capacity of each,
+	 *		so one burst of large responses does not pin its memory for
+	 *		the rest of the connection
+	 */
+	static const size_t MAX_SPARES = 64;
+	static const size_t MAX_SPARE_CAPACITY = 65536;
+
+	/**
+	 * \struct	Segment
+	 * \brief	A queued response along with its length prefix
+	 */
+	struct Segment {
+		uint32_t length_prefix;
+		std::string response;
+	};
+
+	/**
+	 * \var		std::deque<Segment> segments
+	 * \brief	Queued responses. A deque so pushing to the back never
+	 *		moves the segments in front
+	 */
+	std::deque<Segment> segments;
+
+	/**
+	 * \var		std::vector<std::string> spares
+	 * \brief	Cleared buffers of sent responses, handed out by reuse
+	 */
+	std::vector<std::string> spares;
+
+	/**
+	 * \var		size_t offset
+	 * \brief	How much of the front segment (length prefix included) has
+	 *		already been sent
+	 */
+	size_t offset;
+
+	/**
+	 * \var		size_t length
+	 * \brief	Bytes queued and not yet sent
+	 */
+	size_t length;
+
+	/**
+	 * \var		Framing framing
+	 * \brief	How responses are delimited
+	 */
+	Framing framing;
+
+	/**
+	 * \var		iovec vectors[MAX_GATHER]
+	 * \brief	Vectors filled in by gather
+	 */
+	iovec vectors[MAX_GATHER];
+
+	/**
+	 * \var		msghdr message
+	 * \brief	Message filled in by gather
+	 */
+	msghdr message;
+};
+
+#endif
@@ -0,0 +1,50 @@
+#ifndef _REQUESTCONTEXT_H_
+#define _REQUESTCONTEXT_H_
+
+/**
+ * \struct	RequestContext
+ * \brief	Used to hold the XML document a request is parsed into and
+ *		what validating it found. Every thread that processes requests
+ *		owns its own, so requests can be processed concurrently
+ */
+struct RequestContext {
+
+	/**
+	 * \var		pugi::xml_document request
+	 * \brief	Used to store request received from client
+	 *		as XML document (for parsing)
+	 */
+	pugi::xml_document request;
+
+	/**
+	 * \var		RequestReader reader
+	 * \brief	Used instead of request to read requests without building a
+	 *		document, if the server uses the streaming parser
+	 */
+	RequestReader reader;
+
+	/**
+	 * \var		bool request_validated
+	 * \brief	Flag that is set false by validate_request if
+	 *		XML request received from client is not
+	 *		formatted correctly
+	 */
+	bool request_validated;
+
+	/**
+	 * \var		const CommandSchema* command
+	 * \brief	Set by validate_request to the schema of the request's
+	 *		command, or NULL if the command is not known
+	 */
+	const CommandSchema* command;
+
+	/**
+	 * \var		std::string_view values[]
+	 * \brief	Set by validate_request to the text of each Row of the
+	 *		request, in the order of its command's schema. Views into
+	 *		the request buffer
+	 */
+	std::string_view values[RequestSchema::MAX_ROWS];
+};
+
+#endif
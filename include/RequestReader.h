@@ -0,0 +1,110 @@
+#ifndef _REQUESTREADER_H_
+#define _REQUESTREADER_H_
+
+/**
+ * \class	RequestReader
+ * \brief	Used to validate a request and extract its Rows straight from
+ *		the parser's events, without building a document. A small
+ *		state machine enforces the same envelope as RequestSchema as
+ *		each element is read, and stops the parser at the first thing
+ *		out of place. The Rows are then checked against the schema of
+ *		the command
+ */
+class RequestReader : public pugi::xml_sax_handler {
+
+
+
+public:
+
+	/**
+	 * \fn		Constructor
+	 * \param	N/A
+	 * \return	N/A
+	 * \brief	No parameters passed
+	 */
+	RequestReader();
+
+	/**
+	 * \fn		bool read
+	 * \param	char *data
+	 * \param	size_t size
+	 * \param	const CommandSchema **command
+	 * \param	std::string_view *values
+	 * \return	Returns true if the request is valid
+	 * \brief	Parses the request in place and validates it as
+	 *		RequestSchema::validate does a document, setting command
+	 *		and values the same way. values point into data
+	 */
+	bool read(char *data, size_t size, const CommandSchema **command, std::string_view *values);
+
+	/**
+	 * \brief	Callbacks of pugi::xml_sax_handler. Each returns false, which
+	 *		stops the parser, as soon as the request is known to be
+	 *		invalid
+	 */
+	bool start_element(const char *name) override;
+	bool attribute(const char *name, const char *value) override;
+	bool end_element(const char *name) override;
+	bool text(const char *value) override;
+	bool cdata(const char *value) override;
+
+
+
+private:
+
+	/**
+	 * \enum	Element
+	 * \brief	The innermost element open. Nothing may be nested deeper
+	 *		than a Row, so this is all the parser's position needs
+	 */
+	enum Element {
+		ELEMENT_NONE,
+		ELEMENT_REQUEST,
+		ELEMENT_COMMAND,
+		ELEMENT_DATA,
+		ELEMENT_ROW
+	};
+
+	/**
+	 * \var		Element element
+	 * \brief	The innermost element open
+	 */
+	Element element;
+
+	/**
+	 * \var		bool seen_request, seen_command, seen_data
+	 * \brief	Whether each element that may only appear once has
+	 */
+	bool seen_request;
+	bool seen_command;
+	bool seen_data;
+
+	/**
+	 * \var		const char* command_name
+	 * \brief	Text of the Command, or NULL until it has been read
+	 */
+	const char* command_name;
+
+	/**
+	 * \var		RowValue row
+	 * \brief	The Row open. Its type is NULL until its Type attribute has
+	 *		been read
+	 */
+	RowValue row;
+
+	/**
+	 * \var		bool row_has_text
+	 * \brief	Whether the Row open has had its text read
+	 */
+	bool row_has_text;
+
+	/**
+	 * \var		std::vector<RowValue> rows
+	 * \brief	Every Row read, in order. They are checked once the whole
+	 *		request has been, since Data may come before Command. Kept
+	 *		between requests, so it only grows to the most Rows seen
+	 */
+	std::vector<RowValue> rows;
+};
+
+#endif
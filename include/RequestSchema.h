@@ -0,0 +1,220 @@
+#ifndef _REQUESTSCHEMA_H_
+#define _REQUESTSCHEMA_H_
+
+/**
+ * \struct	RowSchema
+ * \brief	A Row that a command's Data node may hold, told apart by the
+ *		value of its Type attribute, and how many times it may appear
+ */
+struct RowSchema {
+	const char* type;
+	unsigned min_occurs;
+	unsigned max_occurs;
+};
+
+class SocketServer;
+struct RequestContext;
+
+/**
+ * \struct	CommandSchema
+ * \brief	A supported command: the Rows its Data node may hold (Rows not
+ *		listed are not allowed), and the method of SocketServer that
+ *		appends its response once the request is validated
+ */
+struct CommandSchema {
+	const char* command;
+	const RowSchema* rows;
+	size_t row_count;
+	void (SocketServer::*handler)(RequestContext*, std::string*);
+};
+
+/**
+ * \struct	RowValue
+ * \brief	A Row read from a request: the value of its Type attribute and
+ *		its text, both pointing into the request buffer
+ */
+struct RowValue {
+	const char* type;
+	std::string_view value;
+};
+
+/**
+ * \struct	GetPlayerInfoRequest
+ * \brief	A validated GetPlayerInfo request. Views into the request
+ *		buffer it was parsed from, so only valid while that is
+ */
+struct GetPlayerInfoRequest {
+	std::string_view card;
+	std::string_view pin;
+};
+
+/**
+ * \class	RequestSchema
+ * \brief	Used to validate requests against the schema of their command
+ *		(see COMMANDS in RequestSchema.cpp) in a single pass over the
+ *		request, without allocating. Every request shares the same
+ *		envelope:
+ *	- The document holds a single Request node
+ *	- Request holds exactly one Command node and exactly one Data node
+ *	- Command holds nothing but its text
+ *	- Data holds nothing but Row nodes, each with a Type attribute and
+ *	  nothing but its text
+ *	- None of Request, Command, Data may have attributes, and Row may
+ *	  have no attribute but Type
+ */
+class RequestSchema {
+
+
+
+public:
+
+	/**
+	 * \var		static const CommandSchema COMMANDS[]
+	 * \brief	Schema of every supported command. A command is supported
+	 *		once it has an entry here
+	 */
+	static const CommandSchema COMMANDS[];
+
+	/**
+	 * \var		static const size_t COMMAND_COUNT
+	 * \brief	Number of entries in COMMANDS
+	 */
+	static const size_t COMMAND_COUNT;
+
+	/**
+	 * \var		static const size_t MAX_ROWS
+	 * \brief	Max number of Rows a CommandSchema may list (each is counted
+	 *		on the stack while validating)
+	 */
+	static const size_t MAX_ROWS = 32;
+
+	/**
+	 * \fn		bool validate
+	 * \param	pugi::xml_node document
+	 * \param	const CommandSchema **command
+	 * \param	std::string_view *values
+	 * \return	Returns true if the request is valid
+	 * \brief	Checks the envelope, then the Rows against the schema of the
+	 *		command. command is set to that schema, or NULL if the
+	 *		command is not known, in which case the Rows are checked
+	 *		against GetPlayerInfo's (see get_schema), or if the request
+	 *		is invalid. values (MAX_ROWS long) is filled on the way with
+	 *		the text of each Row, in the order of the schema's Rows
+	 */
+	static bool validate(pugi::xml_node document, const CommandSchema **command, std::string_view *values);
+
+	/**
+	 * \fn		bool validate_rows
+	 * \param	const CommandSchema *command
+	 * \param	const RowValue *rows
+	 * \param	size_t count
+	 * \param	std::string_view *values
+	 * \return	Returns true if rows are valid for command (GetPlayerInfo's
+	 *		if command is NULL)
+	 * \brief	Checks Rows that were read without a document (see
+	 *		RequestReader) against the schema of their command, filling
+	 *		values as validate does. Their shape is left to the caller
+	 */
+	static bool validate_rows(const CommandSchema *command, const RowValue *rows, size_t count, std::string_view *values);
+
+	/**
+	 * \fn		GetPlayerInfoRequest get_player_info
+	 * \param	const std::string_view *values
+	 * \return	Returns the GetPlayerInfo request held in values
+	 * \brief	Names the values validate extracted from a GetPlayerInfo
+	 *		request
+	 */
+	static GetPlayerInfoRequest get_player_info(const std::string_view *values);
+
+	/**
+	 * \fn		const CommandSchema* find_command
+	 * \param	const char *name
+	 * \return	Returns the schema of the named command, or NULL if the
+	 *		command is not known
+	 * \brief	Looks a command up by name through a perfect hash built at
+	 *		compile time (see CommandTable), so the cost does not grow
+	 *		with the number of commands
+	 */
+	static const CommandSchema* find_command(const char *name);
+
+	/**
+	 * \fn		unsigned long long count_command
+	 * \param	const CommandSchema *command
+	 * \return	Returns how many requests for command have been counted,
+	 *		including this one
+	 * \brief	Counts a request for command. Each command has its own
+	 *		counter, shared by every thread
+	 */
+	static unsigned long long count_command(const CommandSchema *command);
+
+
+
+private:
+
+	/**
+	 * \fn		bool is_text_only
+	 * \param	pugi::xml_node node
+	 * \return	Returns true if node has no attributes and holds at most a
+	 *		single text field
+	 * \brief	Shape of Command, and of Row apart from its Type attribute
+	 */
+	static bool is_text_only(pugi::xml_node node);
+
+	/**
+	 * \fn		const CommandSchema* get_schema
+	 * \param	const CommandSchema *command
+	 * \return	Returns the schema the Rows of a request for command are
+	 *		checked against
+	 * \brief	command itself, or GetPlayerInfo's for a command that is
+	 *		not known (NULL)
+	 */
+	static const CommandSchema* get_schema(const CommandSchema *command);
+
+	/**
+	 * \fn		bool validate_data
+	 * \param	pugi::xml_node data
+	 * \param	const CommandSchema *command
+	 * \param	std::string_view *values
+	 * \return	Returns true if the Rows in data are valid for command
+	 *		(GetPlayerInfo's if command is NULL)
+	 * \brief	Checks the shape of each Row and counts it against the
+	 *		schema as it goes, then checks every count is within its
+	 *		bounds
+	 */
+	static bool validate_data(pugi::xml_node data, const CommandSchema *command, std::string_view *values);
+
+	/**
+	 * \fn		bool start_rows
+	 * \param	const CommandSchema *command
+	 * \param	unsigned *counts
+	 * \param	std::string_view *values
+	 * \return	Returns false if command lists more than MAX_ROWS Rows
+	 * \brief	Clears the count and value of each Row of command
+	 */
+	static bool start_rows(const CommandSchema *command, unsigned *counts, std::string_view *values);
+
+	/**
+	 * \fn		bool count_row
+	 * \param	const CommandSchema *command
+	 * \param	const char *type
+	 * \param	std::string_view text
+	 * \param	unsigned *counts
+	 * \param	std::string_view *values
+	 * \return	Returns false if command takes no Row of type, or not
+	 *		this many times
+	 * \brief	Counts a Row and keeps its text
+	 */
+	static bool count_row(const CommandSchema *command, const char *type, std::string_view text, unsigned *counts, std::string_view *values);
+
+	/**
+	 * \fn		bool check_counts
+	 * \param	const CommandSchema *command
+	 * \param	const unsigned *counts
+	 * \return	Returns false if a Row of command appeared fewer times
+	 *		than it must
+	 * \brief	Checks the counts once every Row has been counted
+	 */
+	static bool check_counts(const CommandSchema *command, const unsigned *counts);
+};
+
+#endif
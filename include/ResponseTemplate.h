@@ -0,0 +1,92 @@
+#ifndef _RESPONSETEMPLATE_H_
+#define _RESPONSETEMPLATE_H_
+
+/**
+ * \class	ResponseTemplate
+ * \brief	Used to build fixed-shape responses without a document. The
+ *		response is built and serialized once, with SLOT_MARKER as the
+ *		text of every node whose text varies, and split into the bytes
+ *		between those slots. Rendering appends those bytes with each
+ *		value escaped into its slot, so a response costs a handful of
+ *		copies into the output buffer
+ */
+class ResponseTemplate {
+
+
+
+public:
+
+	/**
+	 * \var		static const char* SLOT_MARKER
+	 * \brief	Text that marks a slot in the serialized skeleton. It
+	 *		is never escaped by pugixml. It is only looked for in the
+	 *		skeleton when compiled, so it must not appear in the
+	 *		skeleton's own text; values (where DEL is valid XML and
+	 *		passed through) are never scanned for it
+	 */
+	static constexpr const char* SLOT_MARKER = "\x7f";
+
+	/**
+	 * \fn		Constructor
+	 * \param	N/A
+	 * \return	N/A
+	 * \brief	No parameters passed. The template is empty until compiled
+	 */
+	ResponseTemplate();
+
+	/**
+	 * \fn		void compile
+	 * \param	const std::string &skeleton
+	 * \return	N/A
+	 * \brief	Splits the serialized skeleton at each SLOT_MARKER. Slots
+	 *		are numbered in the order they appear
+	 */
+	void compile(const std::string &skeleton);
+
+	/**
+	 * \fn		void render
+	 * \param	std::string *output
+	 * \param	const std::string_view *values
+	 * \return	N/A
+	 * \brief	Appends the response to output with values (one per slot)
+	 *		escaped into their slots
+	 */
+	void render(std::string *output, const std::string_view *values) const;
+
+	/**
+	 * \fn		size_t get_slot_count
+	 * \param	N/A
+	 * \return	Returns the number of slots in the template
+	 * \brief	Getter for the number of values render takes
+	 */
+	size_t get_slot_count() const;
+
+	/**
+	 * \fn		void append_escaped
+	 * \param	std::string *output
+	 * \param	std::string_view value
+	 * \return	N/A
+	 * \brief	Appends value to output escaped as pugixml escapes the text
+	 *		of a node, so a rendered response is byte for byte what
+	 *		serializing the same document would give
+	 */
+	static void append_escaped(std::string *output, std::string_view value);
+
+
+
+private:
+
+	/**
+	 * \var		std::string text
+	 * \brief	The serialized skeleton without its slot markers
+	 */
+	std::string text;
+
+	/**
+	 * \var		std::vector<size_t> slots
+	 * \brief	Offset in text of each slot
+	 */
+	std::vector<size_t> slots;
+};
+
+#endif
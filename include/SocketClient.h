@@ -27,14 +27,6 @@ public:
 	 */
 	char* get_host_name();
 
-	/**
-	 * \fn		char* get_service
-	 * \param	N/A
-	 * \return	Returns the client port
-	 * \brief	Getter for client port
-	 */
-	char* get_service();
-
 	/**
 	 * \fn		unsigned short get_sin_port
 	 * \param	N/A
@@ -43,15 +35,6 @@ public:
 	 */
 	unsigned short get_sin_port();
 
-	/**
-	 * \fn		int set_name_info
-	 * \param	N/A
-	 * \return	Returns EXIT_FAILURE upon any failures encountered,
-	 *		and EXIT_SUCCESS otherwise
-	 * \brief	Setter for client host name
-	 */
-	int set_name_info();
-
 	/**
 	 * \fn		int set_ipv4_info
 	 * \param	N/A
@@ -80,6 +63,11 @@ private:
 	 */
 	friend class SocketServer;
 
+	/**
+	 * \brief	Connection needs to access some private members of SocketClient
+	 */
+	friend class Connection;
+
 	/**
 	 * \var		socklen_t socket_address_length
 	 * \brief	Size of the client's socket address
@@ -106,10 +94,117 @@ private:
 	char host_name[NI_MAXHOST];
 
 	/**
-	 * \var		char service[NI_MAXSERV]
-	 * \brief	Port of the client's socket connection
+	 * \var		FrameBuffer input
+	 * \brief	Bytes received from the client that have not been handled
+	 *		yet, i.e. the start of a request whose rest has not arrived
+	 */
+	FrameBuffer input;
+
+	/**
+	 * \var		OutputQueue output
+	 * \brief	Responses waiting to be sent to the client (the client
+	 *		socket is non-blocking so a send may be partial)
+	 */
+	OutputQueue output;
+
+	/**
+	 * \var		bool send_in_flight
+	 * \brief	Whether a send from output is in flight under io_uring
+	 */
+	bool send_in_flight;
+
+	/**
+	 * \var		int pending_operations
+	 * \brief	Number of io_uring operations in flight for the client.
+	 *		The client is only forgotten once this drops to 0
+	 */
+	int pending_operations;
+
+	/**
+	 * \var		bool closing
+	 * \brief	Set once the client is being disconnected under io_uring
+	 *		while operations are still in flight
+	 */
+	bool closing;
+
+	/**
+	 * \var		unsigned long long id
+	 * \brief	Unique id given by the server on accept (unlike the file
+	 *		descriptor, never reused for a later client)
+	 */
+	unsigned long long id;
+
+	/**
+	 * \var		unsigned long long next_sequence
+	 * \brief	Sequence number to give the next request handed to a worker
+	 */
+	unsigned long long next_sequence;
+
+	/**
+	 * \var		unsigned long long next_response
+	 * \brief	Sequence number of the next response to send to the client
+	 */
+	unsigned long long next_response;
+
+	/**
+	 * \var		std::map<unsigned long long, std::string> finished_responses
+	 * \brief	Responses finished by workers ahead of an earlier response
+	 *		for the same client, keyed by sequence number
+	 */
+	std::map<unsigned long long, std::string> finished_responses;
+
+	/**
+	 * \var		Connection* connection
+	 * \brief	Coroutine serving the client, or NULL unless the server
+	 *		serves clients with coroutines
+	 */
+	Connection* connection;
+
+	/**
+	 * \var		Timer timer
+	 * \brief	The client's nearest deadline (idle, request or write) on
+	 *		the server's timer wheel
+	 */
+	Timer timer;
+
+	/**
+	 * \var		std::chrono::steady_clock::time_point last_activity
+	 * \brief	When data was last received from the client
+	 */
+	std::chrono::steady_clock::time_point last_activity;
+
+	/**
+	 * \var		std::chrono::steady_clock::time_point request_started
+	 * \brief	When the first bytes of the request being received arrived
+	 *		(only meaningful while request_pending)
+	 */
+	std::chrono::steady_clock::time_point request_started;
+
+	/**
+	 * \var		bool request_pending
+	 * \brief	Whether part of a request has been received but not all of it
+	 */
+	bool request_pending;
+
+	/**
+	 * \var		unsigned long long request_frames
+	 * \brief	Frame count of input when request_started was taken, so a
+	 *		request that completes while the next one starts is noticed
+	 */
+	unsigned long long request_frames;
+
+	/**
+	 * \var		std::chrono::steady_clock::time_point write_started
+	 * \brief	When responses started waiting to be sent (only meaningful
+	 *		while write_pending)
+	 */
+	std::chrono::steady_clock::time_point write_started;
+
+	/**
+	 * \var		bool write_pending
+	 * \brief	Whether responses are waiting to be sent
 	 */
-	char service[NI_MAXSERV];
+	bool write_pending;
 };
 
 #endif
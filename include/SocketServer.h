@@ -11,6 +11,14 @@ class SocketServer {
 
 public:
 
+	/**
+	 * \fn		Constructor
+	 * \param	N/A
+	 * \return	N/A
+	 * \brief	No parameters passed
+	 */
+	SocketServer();
+
 	/**
 	 * \fn		int set_address
 	 * \param	std::string _address
@@ -27,6 +35,105 @@ public:
 	 */
 	int set_port(int _port);
 
+	/**
+	 * \fn		int set_reuse_port
+	 * \param	bool _reuse_port
+	 * \return	Returns EXIT_SUCCESS
+	 * \brief	Setter for whether create_tcp_ipv4 sets SO_REUSEPORT so that
+	 *		several servers (shards) can bind the same IP address + port.
+	 *		Will be invoked by main
+	 */
+	int set_reuse_port(bool _reuse_port);
+
+	/**
+	 * \fn		int set_io_uring
+	 * \param	bool _use_io_uring
+	 * \return	Returns EXIT_SUCCESS
+	 * \brief	Setter for whether the event loop is driven by io_uring
+	 *		(multishot accept + multishot recv into a provided buffer
+	 *		ring, with batched submissions) instead of epoll. Will be
+	 *		invoked by main
+	 */
+	int set_io_uring(bool _use_io_uring);
+
+	/**
+	 * \fn		int set_framing
+	 * \param	Framing _framing
+	 * \return	Returns EXIT_SUCCESS
+	 * \brief	Setter for how requests and responses are delimited on
+	 *		every client connection. Will be invoked by main
+	 */
+	int set_framing(Framing _framing);
+
+	/**
+	 * \fn		int set_worker_pool
+	 * \param	WorkerPool *_workers
+	 * \return	Returns EXIT_SUCCESS
+	 * \brief	Setter for the worker pool requests are handed to. If NULL
+	 *		(the default), requests are handled on the event loop's
+	 *		thread. Will be invoked by main
+	 */
+	int set_worker_pool(WorkerPool *_workers);
+
+	/**
+	 * \fn		int set_coroutines
+	 * \param	bool _use_coroutines
+	 * \return	Returns EXIT_SUCCESS
+	 * \brief	Setter for whether each client is served by a coroutine
+	 *		(see serve_connection) on the epoll event loop. Will be
+	 *		invoked by main
+	 */
+	int set_coroutines(bool _use_coroutines);
+
+	/**
+	 * \fn		int set_streaming_parser
+	 * \param	bool _use_streaming_parser
+	 * \return	Returns EXIT_SUCCESS
+	 * \brief	Setter for whether requests are read with RequestReader
+	 *		straight from the parser's events instead of being parsed
+	 *		into a document first. Will be invoked by main
+	 */
+	int set_streaming_parser(bool _use_streaming_parser);
+
+	/**
+	 * \fn		int set_name_resolver
+	 * \param	NameResolver *_resolver
+	 * \return	Returns EXIT_SUCCESS
+	 * \brief	Setter for the resolver client host names are looked up
+	 *		through. If NULL (the default), host names are not looked up
+	 *		and clients are identified by IP address. Will be invoked
+	 *		by main
+	 */
+	int set_name_resolver(NameResolver *_resolver);
+
+	/**
+	 * \fn		int set_timeouts
+	 * \param	int _idle_timeout
+	 * \param	int _request_timeout
+	 * \param	int _write_timeout
+	 * \return	Returns EXIT_SUCCESS
+	 * \brief	Setter for how many seconds a client may go without
+	 *		sending anything, take to send the rest of a request once
+	 *		it has started, and take to read the responses waiting for
+	 *		it before it is disconnected. Zero disables a timeout. Will
+	 *		be invoked by main
+	 */
+	int set_timeouts(int _idle_timeout, int _request_timeout, int _write_timeout);
+
+	/**
+	 * \fn		int set_keepalive
+	 * \param	int _keepalive_idle
+	 * \param	int _keepalive_interval
+	 * \param	int _keepalive_count
+	 * \return	Returns EXIT_SUCCESS
+	 * \brief	Setter for TCP keepalive on client sockets: the first probe
+	 *		after _keepalive_idle seconds without traffic, then one every
+	 *		_keepalive_interval seconds, giving up after _keepalive_count
+	 *		unanswered probes. An idle of zero (the default) leaves
+	 *		keepalive off. Will be invoked by main
+	 */
+	int set_keepalive(int _keepalive_idle, int _keepalive_interval, int _keepalive_count);
+
 	/**
 	 * \fn		std::string get_address
 	 * \param	N/A
@@ -89,6 +196,18 @@ public:
 	 */
 	int mark_passive();
 
+	/**
+	 * \fn		int steer_to_incoming_cpu
+	 * \param	int shards
+	 * \return	Returns EXIT_FAILURE upon any failures encountered,
+	 *		and EXIT_SUCCESS otherwise
+	 * \brief	Attaches a classic BPF program to the SO_REUSEPORT group
+	 *		of the (passive) server that hands each new connection to
+	 *		the listener at index (receiving CPU % shards). Only needs
+	 *		to be invoked on one listener of the group
+	 */
+	int steer_to_incoming_cpu(int shards);
+
 	/**
 	 * \fn		int accept_client
 	 * \param	SocketClient *source
@@ -103,48 +222,322 @@ public:
 	 * \param	N/A
 	 * \return	Returns EXIT_FAILURE upon any failures encountered,
 	 *		and EXIT_SUCCESS otherwise
-	 * \brief	Closes the server file descriptor when socket connection
-	 *		to client has been established
+	 * \brief	Closes the server file descriptor when the server is
+	 *		shutting down
 	 */
 	int close_file_descriptor();
 
+	/**
+	 * \fn		int create_event_loop
+	 * \param	N/A
+	 * \return	Returns EXIT_FAILURE upon any failures encountered,
+	 *		and EXIT_SUCCESS otherwise
+	 * \brief	Creates the epoll instance and registers the (passive)
+	 *		server file descriptor with it as edge-triggered
+	 */
+	int create_event_loop();
+
+	/**
+	 * \fn		int run_event_loop
+	 * \param	N/A
+	 * \return	Returns EXIT_FAILURE if the epoll instance fails. Otherwise
+	 *		this method does not return
+	 * \brief	Waits for events on the server and every connected client,
+	 *		accepting new clients and serving requests from existing
+	 *		ones as their sockets become ready
+	 */
+	int run_event_loop();
+
+	/**
+	 * \fn		void accept_clients
+	 * \param	N/A
+	 * \return	N/A
+	 * \brief	Accepts every pending client connection until the backlog
+	 *		is drained and registers each client with the epoll instance
+	 */
+	void accept_clients();
+
+	/**
+	 * \fn		int identify_client
+	 * \param	SocketClient *source
+	 * \return	Returns EXIT_FAILURE upon any failures encountered,
+	 *		and EXIT_SUCCESS otherwise
+	 * \brief	Prints the host name (or IP address) + port of a newly
+	 *		accepted client. Only host names already cached by the
+	 *		resolver are used, so this never waits on DNS
+	 */
+	int identify_client(SocketClient *source);
+
+	/**
+	 * \fn		int tune_client_socket
+	 * \param	SocketClient *source
+	 * \return	Returns EXIT_FAILURE upon any failures encountered,
+	 *		and EXIT_SUCCESS otherwise
+	 * \brief	Applies the keepalive settings to a newly accepted client
+	 */
+	int tune_client_socket(SocketClient *source);
+
+	/**
+	 * \fn		void update_deadline
+	 * \param	SocketClient *source
+	 * \return	N/A
+	 * \brief	Reschedules the client's timer to its nearest deadline:
+	 *		idle since the last data received, request since part of a
+	 *		request arrived, and write since responses started waiting
+	 */
+	void update_deadline(SocketClient *source);
+
+	/**
+	 * \fn		void expire_clients
+	 * \param	N/A
+	 * \return	N/A
+	 * \brief	Advances the timer wheel to now and disconnects every client
+	 *		whose deadline has passed
+	 */
+	void expire_clients();
+
+	/**
+	 * \fn		void serve_client
+	 * \param	SocketClient *source
+	 * \return	N/A
+	 * \brief	Receives, validates, processes and responds to requests
+	 *		from client until its socket has no more data to read.
+	 *		Disconnects the client if it has hung up or on any error
+	 */
+	void serve_client(SocketClient *source);
+
+	/**
+	 * \fn		Connection::Task serve_connection
+	 * \param	Connection *connection
+	 * \return	Returns the coroutine, to be handed to connection->start
+	 * \brief	Coroutine that validates, processes and responds to every
+	 *		request from the connection's client in turn, suspending
+	 *		whenever the client socket is not ready. Finishes once a
+	 *		request is too large or a response cannot be sent
+	 */
+	Connection::Task serve_connection(Connection *connection);
+
+	/**
+	 * \fn		int create_uring_loop
+	 * \param	N/A
+	 * \return	Returns EXIT_FAILURE upon any failures encountered,
+	 *		and EXIT_SUCCESS otherwise
+	 * \brief	Used by create_event_loop in place of epoll when io_uring
+	 *		is set. Creates the ring and its provided buffers, and
+	 *		queues multishot accept on the (passive) server
+	 */
+	int create_uring_loop();
+
+	/**
+	 * \fn		int run_uring_loop
+	 * \param	N/A
+	 * \return	Returns EXIT_FAILURE if the ring fails. Otherwise this
+	 *		method does not return
+	 * \brief	Used by run_event_loop in place of epoll when io_uring is
+	 *		set. Submits queued operations and handles completions
+	 */
+	int run_uring_loop();
+
+	/**
+	 * \fn		void queue_accept
+	 * \param	N/A
+	 * \return	N/A
+	 * \brief	Queues a multishot accept on the server
+	 */
+	void queue_accept();
+
+	/**
+	 * \fn		void queue_completion_poll
+	 * \param	N/A
+	 * \return	N/A
+	 * \brief	Queues a multishot poll on the eventfd the workers signal
+	 */
+	void queue_completion_poll();
+
+	/**
+	 * \fn		void queue_timeout
+	 * \param	N/A
+	 * \return	N/A
+	 * \brief	Queues a timeout one timer wheel tick from now
+	 */
+	void queue_timeout();
+
+	/**
+	 * \fn		void queue_recv
+	 * \param	SocketClient *source
+	 * \return	N/A
+	 * \brief	Queues a multishot recv on the client into the provided
+	 *		buffer ring
+	 */
+	void queue_recv(SocketClient *source);
+
+	/**
+	 * \fn		void queue_send
+	 * \param	SocketClient *source
+	 * \return	N/A
+	 * \brief	Queues a sendmsg gathering the client's pending responses,
+	 *		unless a send for the client is already in flight
+	 */
+	void queue_send(SocketClient *source);
+
+	/**
+	 * \fn		void complete_accept
+	 * \param	int result
+	 * \param	unsigned flags
+	 * \return	N/A
+	 * \brief	Handles a completion of the multishot accept
+	 */
+	void complete_accept(int result, unsigned flags);
+
+	/**
+	 * \fn		void complete_recv
+	 * \param	int client_file_descriptor
+	 * \param	int result
+	 * \param	unsigned flags
+	 * \return	N/A
+	 * \brief	Handles a completion of a client's multishot recv
+	 */
+	void complete_recv(int client_file_descriptor, int result, unsigned flags);
+
+	/**
+	 * \fn		void complete_send
+	 * \param	int client_file_descriptor
+	 * \param	int result
+	 * \return	N/A
+	 * \brief	Handles a completion of a client's send
+	 */
+	void complete_send(int client_file_descriptor, int result);
+
+	/**
+	 * \fn		int flush_response_to_client
+	 * \param	SocketClient *source
+	 * \return	Returns EXIT_FAILURE upon any failures encountered,
+	 *		and EXIT_SUCCESS otherwise (including when the client
+	 *		socket is full and the rest must wait for EPOLLOUT)
+	 * \brief	Sends as much of the client's pending responses as its
+	 *		socket will currently accept, gathered into as few sendmsg
+	 *		calls as possible
+	 */
+	int flush_response_to_client(SocketClient *source);
+
+	/**
+	 * \fn		void disconnect_client
+	 * \param	SocketClient *source
+	 * \return	N/A
+	 * \brief	Closes the client file descriptor and forgets the client
+	 */
+	void disconnect_client(SocketClient *source);
+
 	/**
 	 * \fn		void receive_request_from_client
 	 * \param	SocketClient *source
 	 * \return	N/A
-	 * \brief	Waits in this function until data has been received from client
-	 *		via socket connection
+	 * \brief	Receives whatever data the client has sent so far into the
+	 *		client's buffer
 	 */
 	void receive_request_from_client(SocketClient *source);
 
 	/**
-	 * \fn		void validate_request
+	 * \fn		int process_frames
+	 * \param	SocketClient *source
+	 * \return	Returns EXIT_FAILURE if a response could not be sent or
+	 *		a request is too large, and EXIT_SUCCESS otherwise
+	 * \brief	Dispatches every complete request buffered for the client
+	 *		and then flushes all of their responses together
+	 */
+	int process_frames(SocketClient *source);
+
+	/**
+	 * \fn		void dispatch_request
+	 * \param	SocketClient *source
+	 * \param	char *data
+	 * \param	size_t size
+	 * \return	N/A
+	 * \brief	Handles a complete request from client on this thread and
+	 *		queues the response, or hands it to the worker pool if one
+	 *		is set. If the worker pool turns the request away, queues
+	 *		the pre-serialized Busy response instead
+	 */
+	void dispatch_request(SocketClient *source, char *data, size_t size);
+
+	/**
+	 * \fn		void handle_request
+	 * \param	RequestContext *context
+	 * \param	char *data
+	 * \param	size_t size
+	 * \param	std::string *response
+	 * \return	N/A
+	 * \brief	Parses, validates and processes a request in the given
+	 *		context and appends the serialized response. Safe to invoke
+	 *		from worker threads, each with its own context. The request
+	 *		is parsed in place, so data is overwritten and must outlive
+	 *		the use of context->request
+	 */
+	void handle_request(RequestContext *context, char *data, size_t size, std::string *response);
+
+	/**
+	 * \fn		void complete_job
+	 * \param	Job *job
+	 * \return	N/A
+	 * \brief	Invoked by a worker thread once a job's response is ready.
+	 *		Hands the job back to this server's event loop
+	 */
+	void complete_job(Job *job);
+
+	/**
+	 * \fn		void collect_completed_jobs
 	 * \param	N/A
 	 * \return	N/A
-	 * \brief	Validates the XML format of the request (see README.md for
-	 *		details of the expected XML format). If request is not
-	 *		valid format, the request_validated flag will be set false
+	 * \brief	Sends the responses of every job completed by the workers
+	 *		to their clients, in the order the requests were received.
+	 *		Each client is flushed once for the whole batch
+	 */
+	void collect_completed_jobs();
+
+	/**
+	 * \fn		void send_finished_responses
+	 * \param	SocketClient *source
+	 * \return	N/A
+	 * \brief	Queues every finished response for the client that no
+	 *		earlier response is still missing for, in request order
+	 */
+	void send_finished_responses(SocketClient *source);
+
+	/**
+	 * \fn		void validate_request
+	 * \param	RequestContext *context
+	 * \return	N/A
+	 * \brief	Validates the XML format of the request against the schema
+	 *		of its command (see README.md for details of the expected
+	 *		XML format). If request is not valid format, the
+	 *		request_validated flag will be set false. Also sets the
+	 *		command schema of the context
 	 */
-	void validate_request();
+	void validate_request(RequestContext *context);
 
 	/**
 	 * \fn		void process_request
-	 * \param	N/A
+	 * \param	RequestContext *context
+	 * \param	std::string *response
 	 * \return	N/A
 	 * \brief	Invoked directly after validate_request. This method will
 	 *		route the program to the correct method based on the
 	 *		request_validated flag combined with the command parsed
-	 *		from the request
+	 *		from the request. That method appends the serialized
+	 *		response to response
 	 */
-	void process_request();
+	void process_request(RequestContext *context, std::string *response);
 
 	/**
 	 * \fn		void send_response_to_client
 	 * \param	SocketClient *source
+	 * \param	std::string *response
 	 * \return	N/A
-	 * \brief	Sends the server's response to the client
+	 * \brief	Queues the server's serialized response for the client.
+	 *		The response is moved into the queue and left empty. It is
+	 *		sent by the next flush_response_to_client
 	 */
-	void send_response_to_client(SocketClient *source);
+	void send_response_to_client(SocketClient *source, std::string *response);
 
 	/**
 	 * \fn		std::string get_printable_xml
@@ -157,40 +550,51 @@ public:
 
 	/**
 	 * \fn		void command_getplayerinfo
-	 * \param	N/A
+	 * \param	RequestContext *context
+	 * \param	std::string *response
 	 * \return	N/A
 	 * \brief	Program gets routed here if the XML request is
 	 *		validated and the parsed command from the request
 	 *		is GetPlayerInfo. Server's response for this method
-	 *		is constructed here
+	 *		is rendered here from a template, using the values
+	 *		extracted while validating
 	 */
-	void command_getplayerinfo();
+	void command_getplayerinfo(RequestContext *context, std::string *response);
 
 	/**
 	 * \fn		void command_unknown
-	 * \param	N/A
+	 * \param	std::string *response
 	 * \return	N/A
 	 * \brief	Program gets routed here if the XML request is
 	 *		validated and the parsed command from the request
-	 *		is not supported. Server's response for this scenario
-	 *		is constructed here
+	 *		is not supported. Server sends a pre-serialized
+	 *		response for this scenario
 	 */
-	void command_unknown();
+	void command_unknown(std::string *response);
 
 	/**
-	 * \fn		void command_unknown
-	 * \param	N/A
+	 * \fn		void request_not_valid
+	 * \param	std::string *response
 	 * \return	N/A
 	 * \brief	Program gets routed here if the XML request is
-	 *		not validated. Server's response for this scenario
-	 *		is constructed here
+	 *		not validated. Server sends a pre-serialized
+	 *		response for this scenario
 	 */
-	void request_not_valid();
+	void request_not_valid(std::string *response);
 
 
 
 private:
 
+	/**
+	 * \fn		void build_templates
+	 * \param	N/A
+	 * \return	N/A
+	 * \brief	Builds and serializes the skeleton of every templated
+	 *		response once, and compiles it into its ResponseTemplate
+	 */
+	void build_templates();
+
 	/**
 	 * \brief	SocketClient needs to access some private members of SocketServer
 	 */
@@ -203,9 +607,66 @@ private:
 
 	/**
 	 * \var		static const int BUF_SIZE
-	 * \brief	Size of the buffer used to hold request from client
+	 * \brief	Max number of bytes read from a client at once
 	 */
-	static const int BUF_SIZE = 1024;
+	static const int BUF_SIZE = 4096;
+
+	/**
+	 * \var		static const size_t MAX_REQUEST_SIZE
+	 * \brief	Largest request accepted from a client. A client sending a
+	 *		larger one is disconnected
+	 */
+	static const size_t MAX_REQUEST_SIZE = 1024 * 1024;
+
+	/**
+	 * \var		static const int MAX_EVENTS
+	 * \brief	Max number of events returned by a single epoll_wait
+	 */
+	static const int MAX_EVENTS = 64;
+
+	/**
+	 * \var		static const unsigned URING_ENTRIES
+	 * \brief	Size of the io_uring submission queue
+	 */
+	static const unsigned URING_ENTRIES = 4096;
+
+	/**
+	 * \var		static const unsigned short URING_BUFFERS
+	 * \brief	Number of buffers (of BUF_SIZE each) provided to the
+	 *		kernel for multishot recv. Must be a power of 2
+	 */
+	static const unsigned short URING_BUFFERS = 1024;
+
+	/**
+	 * \var		static const unsigned short URING_BUFFER_GROUP
+	 * \brief	Buffer group id of the provided buffers
+	 */
+	static const unsigned short URING_BUFFER_GROUP = 0;
+
+	/**
+	 * \var		static const int URING_OPERATION_SHIFT
+	 * \brief	io_uring user data holds the UringOperation in the bits
+	 *		above this shift and the file descriptor below
+	 */
+	static const int URING_OPERATION_SHIFT = 32;
+
+	/**
+	 * \var		static const unsigned long long URING_FILE_DESCRIPTOR_MASK
+	 * \brief	Mask for the file descriptor held in io_uring user data
+	 */
+	static const unsigned long long URING_FILE_DESCRIPTOR_MASK = 0xFFFFFFFF;
+
+	/**
+	 * \enum	UringOperation
+	 * \brief	Kind of operation an io_uring completion belongs to
+	 */
+	enum UringOperation {
+		URING_ACCEPT = 1,
+		URING_RECV,
+		URING_SEND,
+		URING_COMPLETION_POLL,
+		URING_TIMEOUT
+	};
 
 	/**
 	 * \var		std::string address
@@ -219,6 +680,13 @@ private:
 	 */
 	int port;
 
+	/**
+	 * \var		bool reuse_port
+	 * \brief	Whether the server socket is created with SO_REUSEPORT.
+	 *		This is set by main
+	 */
+	bool reuse_port;
+
 	/**
 	 * \var		int file_descriptor
 	 * \brief	Identifier for the server
@@ -232,32 +700,136 @@ private:
 	sockaddr_in socket_address;
 
 	/**
-	 * \var		char buf[BUF_SIZE]
-	 * \brief	The buffer used to hold request from client
+	 * \var		int epoll_file_descriptor
+	 * \brief	Identifier for the epoll instance watching the server
+	 *		and all connected clients
+	 */
+	int epoll_file_descriptor;
+
+	/**
+	 * \var		std::unordered_map<int, SocketClient*> clients
+	 * \brief	Every connected client, keyed by its file descriptor
+	 */
+	std::unordered_map<int, SocketClient*> clients;
+
+	/**
+	 * \var		RequestContext context
+	 * \brief	Used to store requests received from clients when there
+	 *		is no worker pool
+	 */
+	RequestContext context;
+
+	/**
+	 * \var		bool use_io_uring
+	 * \brief	Whether the event loop is driven by io_uring instead of
+	 *		epoll. This is set by main
+	 */
+	bool use_io_uring;
+
+	/**
+	 * \var		IoUring* ring
+	 * \brief	The io_uring instance driving the event loop, or NULL
+	 *		if it is driven by epoll
+	 */
+	IoUring* ring;
+
+	/**
+	 * \var		Framing framing
+	 * \brief	How requests and responses are delimited. This is set
+	 *		by main
+	 */
+	Framing framing;
+
+	/**
+	 * \var		WorkerPool* workers
+	 * \brief	Worker pool requests are handed to, or NULL to handle
+	 *		requests on the event loop's thread. This is set by main
+	 */
+	WorkerPool* workers;
+
+	/**
+	 * \var		bool use_coroutines
+	 * \brief	Whether each client is served by a coroutine. This is set
+	 *		by main
+	 */
+	bool use_coroutines;
+
+	/**
+	 * \var		bool use_streaming_parser
+	 * \brief	Whether requests are read without building a document. This
+	 *		is set by main
+	 */
+	bool use_streaming_parser;
+
+	/**
+	 * \var		ResponseTemplate getplayerinfo_success
+	 * \brief	Template of the successful GetPlayerInfo response, built by
+	 *		build_templates when the server is created
+	 */
+	ResponseTemplate getplayerinfo_success;
+
+	/**
+	 * \var		NameResolver* resolver
+	 * \brief	Resolver client host names are looked up through, or NULL
+	 *		to identify clients by IP address. This is set by main
+	 */
+	NameResolver* resolver;
+
+	/**
+	 * \var		std::chrono::seconds idle_timeout, request_timeout, write_timeout
+	 * \brief	Timeouts of every client, or 0 if disabled. These are set
+	 *		by main
+	 */
+	std::chrono::seconds idle_timeout;
+	std::chrono::seconds request_timeout;
+	std::chrono::seconds write_timeout;
+
+	/**
+	 * \var		int keepalive_idle, keepalive_interval, keepalive_count
+	 * \brief	TCP keepalive settings of every client. These are set by main
+	 */
+	int keepalive_idle;
+	int keepalive_interval;
+	int keepalive_count;
+
+	/**
+	 * \var		TimerWheel timers
+	 * \brief	Deadline of every connected client
+	 */
+	TimerWheel timers;
+
+	/**
+	 * \var		__kernel_timespec timeout_interval
+	 * \brief	Interval of the io_uring timeout that advances the timer
+	 *		wheel (one tick)
+	 */
+	__kernel_timespec timeout_interval;
+
+	/**
+	 * \var		int completion_file_descriptor
+	 * \brief	eventfd the workers signal once they have completed jobs
+	 *		for this server
 	 */
-	char buf[BUF_SIZE];
+	int completion_file_descriptor;
 
 	/**
-	 * \var		pugi::xml_document request
-	 * \brief	Used to store request received from client
-	 *		as XML document (for parsing)
+	 * \var		std::mutex completed_jobs_mutex
+	 * \brief	Guards completed_jobs
 	 */
-	pugi::xml_document request;
+	std::mutex completed_jobs_mutex;
 
 	/**
-	 * \var		pugi::xml_document request
-	 * \brief	Used to store response to send to client
-	 *		as XML document (for easy building)
+	 * \var		std::vector<Job*> completed_jobs
+	 * \brief	Jobs completed by the workers that the event loop has not
+	 *		collected yet
 	 */
-	pugi::xml_document response;
+	std::vector<Job*> completed_jobs;
 
 	/**
-	 * \var		bool request_validated
-	 * \brief	Flag that is set false by validate_request if
-	 *		XML request received from client is not
-	 *		formatted correctly
+	 * \var		unsigned long long next_client_id
+	 * \brief	Id to give the next accepted client
 	 */
-	bool request_validated;
+	unsigned long long next_client_id;
 
 	/**
 	 * \var		int bytes_received
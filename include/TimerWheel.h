@@ -0,0 +1,160 @@
+#ifndef _TIMERWHEEL_H_
+#define _TIMERWHEEL_H_
+
+/**
+ * \struct	Timer
+ * \brief	A deadline scheduled on a TimerWheel. Embedded in whatever it
+ *		times (see SocketClient), so scheduling never allocates
+ */
+struct Timer {
+
+	/**
+	 * \var		unsigned long long expiry
+	 * \brief	Tick the timer expires on
+	 */
+	unsigned long long expiry;
+
+	/**
+	 * \var		Timer *prev, *next
+	 * \brief	Neighbours in the wheel slot the timer is in, or NULL if
+	 *		the timer is not scheduled
+	 */
+	Timer* prev;
+	Timer* next;
+
+	/**
+	 * \var		void* owner
+	 * \brief	What the timer times, handed back once it expires
+	 */
+	void* owner;
+};
+
+/**
+ * \class	TimerWheel
+ * \brief	Used to keep many deadlines with O(1) scheduling and
+ *		cancelling. A hierarchy of LEVELS wheels of SLOTS slots each:
+ *		a timer sits in the wheel whose range covers its time left, and
+ *		moves down a wheel each time the wheel below has gone around,
+ *		until it expires from the lowest one
+ */
+class TimerWheel {
+
+
+
+public:
+
+	/**
+	 * \fn		Constructor
+	 * \param	N/A
+	 * \return	N/A
+	 * \brief	No parameters passed. Ticks are counted from now
+	 */
+	TimerWheel();
+
+	/**
+	 * \brief	Slots point at themselves, so a TimerWheel cannot be copied
+	 */
+	TimerWheel(const TimerWheel&) = delete;
+	TimerWheel& operator=(const TimerWheel&) = delete;
+
+	/**
+	 * \fn		void schedule
+	 * \param	Timer *timer
+	 * \param	std::chrono::steady_clock::time_point deadline
+	 * \return	N/A
+	 * \brief	Schedules timer to expire at the first tick at or after
+	 *		deadline, moving it if it is already scheduled
+	 */
+	void schedule(Timer *timer, std::chrono::steady_clock::time_point deadline);
+
+	/**
+	 * \fn		void cancel
+	 * \param	Timer *timer
+	 * \return	N/A
+	 * \brief	Unschedules timer. Does nothing if it is not scheduled
+	 */
+	void cancel(Timer *timer);
+
+	/**
+	 * \fn		void advance
+	 * \param	std::chrono::steady_clock::time_point now
+	 * \param	std::vector<void*> *expired
+	 * \return	N/A
+	 * \brief	Moves the wheel up to now and appends the owner of every
+	 *		timer that expired on the way. Expired timers are
+	 *		unscheduled
+	 */
+	void advance(std::chrono::steady_clock::time_point now, std::vector<void*> *expired);
+
+	/**
+	 * \fn		int get_wait_timeout
+	 * \param	std::chrono::steady_clock::time_point now
+	 * \return	Returns the milliseconds until the next tick, or -1 if no
+	 *		timer is scheduled
+	 * \brief	How long an event loop may wait before advancing the wheel
+	 */
+	int get_wait_timeout(std::chrono::steady_clock::time_point now);
+
+	/**
+	 * \var		static const int TICK_MS
+	 * \brief	Length of a tick in milliseconds (the resolution of
+	 *		every deadline)
+	 */
+	static const int TICK_MS = 100;
+
+
+
+private:
+
+	/**
+	 * \var		static const int LEVELS, SLOT_BITS, SLOTS
+	 * \brief	Shape of the hierarchy. LEVELS wheels of SLOTS slots cover
+	 *		SLOTS ^ LEVELS ticks (about 19 days); later deadlines are
+	 *		brought in to the last tick covered
+	 */
+	static const int LEVELS = 4;
+	static const int SLOT_BITS = 6;
+	static const int SLOTS = 1 << SLOT_BITS;
+
+	/**
+	 * \fn		void place
+	 * \param	Timer *timer
+	 * \return	N/A
+	 * \brief	Links timer into the slot covering its expiry
+	 */
+	void place(Timer *timer);
+
+	/**
+	 * \fn		unsigned long long get_tick
+	 * \param	std::chrono::steady_clock::time_point time
+	 * \return	Returns the tick time falls in
+	 * \brief	Converts a time to ticks since the wheel was created
+	 */
+	unsigned long long get_tick(std::chrono::steady_clock::time_point time);
+
+	/**
+	 * \var		Timer slots[LEVELS][SLOTS]
+	 * \brief	Head of the circular list of timers in each slot
+	 */
+	Timer slots[LEVELS][SLOTS];
+
+	/**
+	 * \var		unsigned long long current_tick
+	 * \brief	The last tick the wheel has been advanced to
+	 */
+	unsigned long long current_tick;
+
+	/**
+	 * \var		size_t scheduled
+	 * \brief	Number of timers scheduled
+	 */
+	size_t scheduled;
+
+	/**
+	 * \var		std::chrono::steady_clock::time_point start
+	 * \brief	Time of tick 0
+	 */
+	std::chrono::steady_clock::time_point start;
+};
+
+#endif
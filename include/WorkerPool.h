@@ -0,0 +1,197 @@
+#ifndef _WORKERPOOL_H_
+#define _WORKERPOOL_H_
+
+/**
+ * \brief	Job needs to point back at the server that owns its client
+ */
+class SocketServer;
+
+/**
+ * \struct	Job
+ * \brief	A complete request handed from an event loop to a worker, and
+ *		the serialized response handed back
+ */
+struct Job {
+
+	/**
+	 * \var		SocketServer* server
+	 * \brief	Server whose event loop the request came from and the
+	 *		response goes back to
+	 */
+	SocketServer* server;
+
+	/**
+	 * \var		int file_descriptor
+	 * \brief	Identifier for the client that sent the request
+	 */
+	int file_descriptor;
+
+	/**
+	 * \var		unsigned long long client_id
+	 * \brief	Id of the client that sent the request, so a response is
+	 *		not sent to a later client that reuses the file descriptor
+	 */
+	unsigned long long client_id;
+
+	/**
+	 * \var		unsigned long long sequence
+	 * \brief	Position of the request among all requests from its client
+	 */
+	unsigned long long sequence;
+
+	/**
+	 * \var		std::chrono::steady_clock::time_point submitted
+	 * \brief	When the job was queued, to tell how long the oldest
+	 *		queued job has been waiting
+	 */
+	std::chrono::steady_clock::time_point submitted;
+
+	/**
+	 * \var		std::string request
+	 * \brief	The request as received from client (copied out of the
+	 *		client's buffer, which keeps filling up while the job waits).
+	 *		The worker parses it in place
+	 */
+	std::string request;
+
+	/**
+	 * \var		std::string response
+	 * \brief	The serialized response to send to client
+	 */
+	std::string response;
+};
+
+/**
+ * \class	WorkerPool
+ * \brief	Used to validate and process requests on a fixed set of
+ *		worker threads, separate from the threads doing socket IO
+ */
+class WorkerPool {
+
+
+
+public:
+
+	/**
+	 * \fn		Constructor
+	 * \param	N/A
+	 * \return	N/A
+	 * \brief	No parameters passed
+	 */
+	WorkerPool();
+
+	/**
+	 * \fn		Destructor
+	 * \param	N/A
+	 * \return	N/A
+	 * \brief	Stops the worker threads
+	 */
+	~WorkerPool();
+
+	/**
+	 * \fn		int start
+	 * \param	int _workers
+	 * \return	Returns EXIT_FAILURE upon any failures encountered,
+	 *		and EXIT_SUCCESS otherwise
+	 * \brief	Starts the given number of worker threads
+	 */
+	int start(int _workers);
+
+	/**
+	 * \fn		void stop
+	 * \param	N/A
+	 * \return	N/A
+	 * \brief	Lets the worker threads finish the jobs already submitted
+	 *		and then joins them
+	 */
+	void stop();
+
+	/**
+	 * \fn		int set_admission_limits
+	 * \param	size_t _max_queue_depth
+	 * \param	int _latency_budget
+	 * \return	Returns EXIT_SUCCESS
+	 * \brief	Setter for when submit turns jobs away: once
+	 *		_max_queue_depth jobs are queued, or once the oldest queued
+	 *		job has waited longer than _latency_budget milliseconds.
+	 *		Zero disables either limit
+	 */
+	int set_admission_limits(size_t _max_queue_depth, int _latency_budget);
+
+	/**
+	 * \fn		int submit
+	 * \param	Job *job
+	 * \return	Returns EXIT_FAILURE (without queuing the job) if the pool
+	 *		is over its admission limits, and EXIT_SUCCESS otherwise
+	 * \brief	Queues a job for the next idle worker. The job is handed
+	 *		back to job->server through complete_job once processed
+	 */
+	int submit(Job *job);
+
+	/**
+	 * \fn		int get_workers
+	 * \param	N/A
+	 * \return	Returns the number of worker threads
+	 * \brief	Getter for number of worker threads
+	 */
+	int get_workers();
+
+
+
+private:
+
+	/**
+	 * \fn		void run_worker
+	 * \param	N/A
+	 * \return	N/A
+	 * \brief	Body of each worker thread. Processes queued jobs with the
+	 *		thread's own RequestContext until the pool is stopped
+	 */
+	void run_worker();
+
+	/**
+	 * \var		std::mutex jobs_mutex
+	 * \brief	Guards jobs and stopping
+	 */
+	std::mutex jobs_mutex;
+
+	/**
+	 * \var		std::condition_variable jobs_available
+	 * \brief	Signalled whenever a job is queued or the pool is stopped
+	 */
+	std::condition_variable jobs_available;
+
+	/**
+	 * \var		std::deque<Job*> jobs
+	 * \brief	Jobs waiting for a worker, oldest first
+	 */
+	std::deque<Job*> jobs;
+
+	/**
+	 * \var		std::vector<std::thread> threads
+	 * \brief	The worker threads
+	 */
+	std::vector<std::thread> threads;
+
+	/**
+	 * \var		bool stopping
+	 * \brief	Set by stop to tell the worker threads to exit once the
+	 *		queue is empty
+	 */
+	bool stopping;
+
+	/**
+	 * \var		size_t max_queue_depth
+	 * \brief	Max number of queued jobs, or 0 for no limit
+	 */
+	size_t max_queue_depth;
+
+	/**
+	 * \var		std::chrono::milliseconds latency_budget
+	 * \brief	Max time the oldest queued job may have waited, or 0 for
+	 *		no limit
+	 */
+	std::chrono::milliseconds latency_budget;
+};
+
+#endif
@@ -49,6 +49,9 @@
 // Uncomment this to enable long long support
 // #define PUGIXML_HAS_LONG_LONG
 
+// Uncomment this to disable SSE2/AVX2 character scanning and use the scalar code only
+// #define PUGIXML_NO_SIMD
+
 #endif
 
 /**
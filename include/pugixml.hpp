@@ -213,6 +213,12 @@ namespace pugi
 	// This flag is off by default.
 	const unsigned int parse_embed_pcdata = 0x2000;
 
+	// This flag makes the parser stop at the end tag of the document element instead of the end of the buffer, so a buffer
+	// holding several documents back to back can be parsed one document at a time, looking at each byte once. On success,
+	// xml_parse_result::offset is then the number of characters the document took, i.e. where the next one starts; the rest
+	// of the buffer is neither parsed nor modified, even when parsing in place. This flag is off by default.
+	const unsigned int parse_stop_at_end = 0x4000;
+
 	// The default parsing mode.
 	// Elements, PCDATA and CDATA sections are added to the DOM tree, character/reference entities are expanded,
 	// End-of-Line characters are normalized, attribute values are normalized using CDATA normalization rules.
@@ -1000,7 +1006,9 @@ namespace pugi
 
 		status_append_invalid_root,	// Unable to append nodes since root type is not node_element or node_document (exclusive to xml_node::append_buffer)
 
-		status_no_document_element	// Parsing resulted in a document without element nodes
+		status_no_document_element,	// Parsing resulted in a document without element nodes
+
+		status_aborted				// A callback of xml_sax_handler stopped parsing (exclusive to parse_sax_inplace)
 	};
 
 	// Parsing result
@@ -1054,9 +1062,13 @@ namespace pugi
 		xml_document& operator=(xml_document&& rhs) PUGIXML_NOEXCEPT_IF_NOT_COMPACT;
 	#endif
 
-		// Removes all nodes, leaving the empty document
+		// Removes all nodes, leaving the empty document. Keeps memory pages if the last reset(bool) asked to
 		void reset();
 
+		// Removes all nodes, leaving the empty document. With keep_pages, the memory pages of the nodes are kept and reused
+		// by this document instead of being freed, until a reset(false) or destruction; loading a document resets it the same way
+		void reset(bool keep_pages);
+
 		// Removes all nodes, then copies the entire contents of the specified document
 		void reset(const xml_document& proto);
 
@@ -1437,6 +1449,79 @@ namespace pugi
 	std::basic_string<wchar_t, std::char_traits<wchar_t>, std::allocator<wchar_t> > PUGIXML_FUNCTION as_wide(const std::basic_string<char, std::char_traits<char>, std::allocator<char> >& str);
 #endif
 
+	// Callback interface for parse_sax_inplace, which reports the document as a stream of events instead of building a tree.
+	// Names and values are zero-terminated and point into the parsed buffer, so they stay valid as long as the buffer does,
+	// unless the buffer had to be converted to the native encoding, in which case they are only valid during the callback.
+	// Comments, declarations, processing instructions and the document type declaration are skipped, as if the options
+	// asking for them were not set.
+	// Returning false from any callback stops parsing with status_aborted.
+	class PUGIXML_CLASS xml_sax_handler
+	{
+	public:
+		virtual ~xml_sax_handler();
+
+		// Callback that is called for each start tag, before its attributes
+		virtual bool start_element(const char_t* name);
+
+		// Callback that is called for each attribute of the element that was started last
+		virtual bool attribute(const char_t* name, const char_t* value);
+
+		// Callback that is called for each end tag, or right after the attributes of an empty element
+		virtual bool end_element(const char_t* name);
+
+		// Callback that is called for each PCDATA section, following the same rules for whitespace as the tree parser
+		virtual bool text(const char_t* value);
+
+		// Callback that is called for each CDATA section, if parse_cdata is set
+		virtual bool cdata(const char_t* value);
+	};
+
+	// Parse the buffer as a stream of events sent to handler, without building a tree. The buffer is modified in place.
+	// Takes the same options as xml_document::load_buffer_inplace, but only elements, PCDATA and CDATA are ever reported.
+	xml_parse_result PUGIXML_FUNCTION parse_sax_inplace(void* contents, size_t size, xml_sax_handler& handler, unsigned int options = parse_default, xml_encoding encoding = encoding_auto);
+
+	// Result of feeding bytes to xml_incremental_parser
+	enum xml_incremental_status
+	{
+		incremental_more,		// The bytes fed so far do not hold a complete document yet
+		incremental_complete,	// The root element of the document has been closed
+		incremental_error		// The bytes fed so far cannot be the start of a document
+	};
+
+	// Push parser that finds where a document ends while it is received in chunks. It only follows the markup structure
+	// (tags, comments, CDATA sections, processing instructions and the document type declaration, and quotes inside them),
+	// keeping its state between calls, so every byte is looked at once however the document is split. The document is
+	// meant to be parsed (e.g. with xml_document::load_buffer_inplace or parse_sax_inplace) once it is complete, which
+	// catches any error this parser does not. Expects an encoding in which markup is ASCII, such as UTF-8 or Latin-1.
+	class PUGIXML_CLASS xml_incremental_parser
+	{
+	public:
+		// Default constructor, makes a parser waiting for the start of a document
+		xml_incremental_parser();
+
+		// Feeds the next size bytes of the document. Returns incremental_complete as soon as they close the root element,
+		// and sets consumed (if given) to the number of bytes up to and including the end of the root element; the rest
+		// belong to whatever follows the document. On incremental_error, consumed is the offset of the offending byte.
+		// Once the document is complete or in error, further bytes are not consumed until reset is called.
+		xml_incremental_status feed(const void* contents, size_t size, size_t* consumed = 0);
+
+		// Starts over, waiting for the start of the next document
+		void reset();
+
+		// Number of bytes consumed since the parser was constructed or reset
+		size_t length() const;
+
+		// Number of elements open at the current position
+		size_t depth() const;
+
+	private:
+		int _state;
+		unsigned int _count;
+		char _quote;
+		size_t _depth;
+		size_t _length;
+	};
+
 	// Memory allocation function interface; returns pointer to allocated memory or NULL on failure
 	typedef void* (*allocation_function)(size_t size);
 
@@ -0,0 +1,192 @@
+#include <arpa/inet.h>
+#include <chrono>
+#include <condition_variable>
+#include <coroutine>
+#include <cstdint>
+#include <cstdlib>
+#include <deque>
+#include <exception>
+#include <iostream>
+#include <linux/io_uring.h>
+#include <map>
+#include <mutex>
+#include <netdb.h>
+#include <string>
+#include <string_view>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "../include/pugiconfig.hpp"
+#include "../include/pugixml.hpp"
+#include "../include/Connection.h"
+#include "../include/FrameBuffer.h"
+#include "../include/IoUring.h"
+#include "../include/NameResolver.h"
+#include "../include/OutputQueue.h"
+#include "../include/RequestSchema.h"
+#include "../include/RequestReader.h"
+#include "../include/RequestContext.h"
+#include "../include/ResponseTemplate.h"
+#include "../include/TimerWheel.h"
+#include "../include/SocketClient.h"
+#include "../include/WorkerPool.h"
+#include "../include/SocketServer.h"
+
+Connection::Connection(SocketServer* _server, SocketClient* _source) {
+	server = _server;
+	source = _source;
+	handle = NULL;
+	waiting = WAITING_NONE;
+	frame = NULL;
+	length = NULL;
+	response = NULL;
+	result = EXIT_SUCCESS;
+}
+
+Connection::~Connection() {
+	if (handle) {
+		handle.destroy();
+	}
+}
+
+void Connection::start(Task _task) {
+	handle = _task.handle;
+}
+
+Connection::FrameAwaiter Connection::read_frame(char** _frame, size_t* _length) {
+	frame = _frame;
+	length = _length;
+
+	return FrameAwaiter{ this };
+}
+
+Connection::WriteAwaiter Connection::write(std::string* _response) {
+	response = _response;
+
+	return WriteAwaiter{ this };
+}
+
+bool Connection::FrameAwaiter::await_ready() {
+	FrameStatus status;
+
+	status = connection->source->input.next_frame(connection->frame, connection->length);
+
+	if (status == FRAME_INCOMPLETE) {
+		return false;
+	}
+	else if (status == FRAME_TOO_LARGE) {
+		std::cerr << "FAILURE: Request from client is too large" << std::endl;
+		connection->result = EXIT_FAILURE;
+		return true;
+	}
+	else if (status == FRAME_INVALID) {
+		std::cerr << "FAILURE: Request from client is not an XML document" << std::endl;
+		connection->result = EXIT_FAILURE;
+		return true;
+	}
+
+	connection->result = EXIT_SUCCESS;
+
+	return true;
+}
+
+bool Connection::FrameAwaiter::await_suspend(std::coroutine_handle<>) {
+	/**
+	 *	- Every buffered request has been handled, so send their responses
+	 *	  together before waiting for more
+	 */
+	if (connection->server->flush_response_to_client(connection->source) != EXIT_SUCCESS) {
+		std::cerr << "FAILURE: Error sending response to client" << std::endl;
+		connection->result = EXIT_FAILURE;
+		return false;
+	}
+
+	connection->waiting = WAITING_FRAME;
+
+	return true;
+}
+
+int Connection::FrameAwaiter::await_resume() {
+	return connection->result;
+}
+
+bool Connection::WriteAwaiter::await_ready() {
+	connection->server->send_response_to_client(connection->source, connection->response);
+	connection->source->output.reuse(connection->response);
+	connection->result = EXIT_SUCCESS;
+
+	return connection->source->output.get_length() < MAX_PENDING_OUTPUT;
+}
+
+bool Connection::WriteAwaiter::await_suspend(std::coroutine_handle<>) {
+	/**
+	 *	- Too much is pending, so send it now and only carry on once the
+	 *	  client socket has taken all of it
+	 */
+	if (connection->server->flush_response_to_client(connection->source) != EXIT_SUCCESS) {
+		std::cerr << "FAILURE: Error sending response to client" << std::endl;
+		connection->result = EXIT_FAILURE;
+		return false;
+	}
+
+	if (connection->source->output.empty()) {
+		return false;
+	}
+
+	connection->waiting = WAITING_WRITE;
+
+	return true;
+}
+
+int Connection::WriteAwaiter::await_resume() {
+	return connection->result;
+}
+
+void Connection::resume() {
+	FrameStatus status;
+
+	switch (waiting) {
+	case WAITING_FRAME:
+		status = source->input.next_frame(frame, length);
+		if (status == FRAME_INCOMPLETE) {
+			return;
+		}
+		else if (status == FRAME_TOO_LARGE) {
+			std::cerr << "FAILURE: Request from client is too large" << std::endl;
+			result = EXIT_FAILURE;
+			break;
+		}
+		else if (status == FRAME_INVALID) {
+			std::cerr << "FAILURE: Request from client is not an XML document" << std::endl;
+			result = EXIT_FAILURE;
+			break;
+		}
+
+		result = EXIT_SUCCESS;
+		break;
+	case WAITING_WRITE:
+		if (!source->output.empty()) {
+			return;
+		}
+
+		result = EXIT_SUCCESS;
+		break;
+	default:
+		return;
+	}
+
+	waiting = WAITING_NONE;
+	handle.resume();
+}
+
+bool Connection::done() {
+	return handle && handle.done();
+}
+
+bool Connection::reading() {
+	return waiting != WAITING_WRITE;
+}
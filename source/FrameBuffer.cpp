@@ -0,0 +1,230 @@
+#include <arpa/inet.h>
+#include <cctype>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+
+#include "../include/pugiconfig.hpp"
+#include "../include/pugixml.hpp"
+#include "../include/FrameBuffer.h"
+
+/**
+ * \def		LENGTH_PREFIX_SIZE
+ * \brief	Size of the length prefix of FRAMING_LENGTH_PREFIX
+ */
+#define LENGTH_PREFIX_SIZE	(sizeof(uint32_t))
+
+FrameBuffer::FrameBuffer() {
+	data = NULL;
+	capacity = 0;
+	start = 0;
+	end = 0;
+	scanned = 0;
+	framing = FRAMING_NEWLINE;
+	max_frame_size = 0;
+	frames = 0;
+}
+
+FrameBuffer::~FrameBuffer() {
+	free(data);
+}
+
+int FrameBuffer::set_framing(Framing _framing, size_t _max_frame_size) {
+	framing = _framing;
+	max_frame_size = _max_frame_size;
+
+	return EXIT_SUCCESS;
+}
+
+char* FrameBuffer::reserve(size_t size) {
+	char* grown;
+	size_t needed;
+
+	if (capacity - end >= size) {
+		return data + end;
+	}
+
+	/**
+	 *	- Only the incomplete frame at the back is ever moved, and only
+	 *	  when there is no room left behind it
+	 */
+	if (start > 0) {
+		memmove(data, data + start, end - start);
+		end -= start;
+		scanned -= start;
+		start = 0;
+
+		if (capacity - end >= size) {
+			return data + end;
+		}
+	}
+
+	needed = end + size;
+	if (needed < capacity * 2) {
+		needed = capacity * 2;
+	}
+
+	grown = (char*)realloc(data, needed);
+	if (grown == NULL) {
+		return NULL;
+	}
+
+	data = grown;
+	capacity = needed;
+
+	return data + end;
+}
+
+void FrameBuffer::commit(size_t size) {
+	end += size;
+}
+
+int FrameBuffer::append(const char* bytes, size_t size) {
+	char* destination;
+
+	destination = reserve(size);
+	if (destination == NULL) {
+		return EXIT_FAILURE;
+	}
+
+	memcpy(destination, bytes, size);
+	commit(size);
+
+	return EXIT_SUCCESS;
+}
+
+FrameStatus FrameBuffer::next_frame(char** frame, size_t* length) {
+	char* newline;
+	uint32_t prefix;
+	size_t consumed;
+	pugi::xml_incremental_status status;
+
+	while (start < end) {
+		/**
+		 *	- Length prefix: wait for the prefix, then for the whole frame
+		 */
+		if (framing == FRAMING_LENGTH_PREFIX) {
+			if (end - start < LENGTH_PREFIX_SIZE) {
+				return FRAME_INCOMPLETE;
+			}
+
+			memcpy(&prefix, data + start, LENGTH_PREFIX_SIZE);
+			prefix = ntohl(prefix);
+
+			if (prefix > max_frame_size) {
+				return FRAME_TOO_LARGE;
+			}
+
+			if (end - start - LENGTH_PREFIX_SIZE < prefix) {
+				return FRAME_INCOMPLETE;
+			}
+
+			*frame = data + start + LENGTH_PREFIX_SIZE;
+			*length = prefix;
+			start += LENGTH_PREFIX_SIZE + prefix;
+			scanned = start;
+			frames++;
+
+			return FRAME_COMPLETE;
+		}
+
+		/**
+		 *	- Document: feed only the bytes not fed before, so a request
+		 *	  ends the moment its root element is closed. Whitespace
+		 *	  between requests is skipped, like blank lines
+		 */
+		if (framing == FRAMING_DOCUMENT) {
+			if (document.length() == 0) {
+				while (start < end && isspace((unsigned char)data[start])) {
+					start++;
+				}
+
+				scanned = start;
+				if (start == end) {
+					break;
+				}
+			}
+
+			status = document.feed(data + scanned, end - scanned, &consumed);
+			scanned += consumed;
+
+			if (status == pugi::incremental_error) {
+				return FRAME_INVALID;
+			}
+
+			if (status == pugi::incremental_more) {
+				if (end - start > max_frame_size) {
+					return FRAME_TOO_LARGE;
+				}
+
+				return FRAME_INCOMPLETE;
+			}
+
+			*frame = data + start;
+			*length = scanned - start;
+			start = scanned;
+			document.reset();
+
+			if (*length > max_frame_size) {
+				return FRAME_TOO_LARGE;
+			}
+
+			frames++;
+			return FRAME_COMPLETE;
+		}
+
+		/**
+		 *	- Newline: search only the bytes not searched before. Drop a
+		 *	  carriage return before the newline and skip blank lines
+		 */
+		if (scanned < start) {
+			scanned = start;
+		}
+
+		newline = (char*)memchr(data + scanned, '\n', end - scanned);
+		if (newline == NULL) {
+			scanned = end;
+
+			if (end - start > max_frame_size) {
+				return FRAME_TOO_LARGE;
+			}
+
+			return FRAME_INCOMPLETE;
+		}
+
+		*frame = data + start;
+		*length = newline - *frame;
+		start = newline + 1 - data;
+		scanned = start;
+
+		if (*length > 0 && (*frame)[*length - 1] == '\r') {
+			(*length)--;
+		}
+
+		if (*length > max_frame_size) {
+			return FRAME_TOO_LARGE;
+		}
+
+		if (*length > 0) {
+			frames++;
+			return FRAME_COMPLETE;
+		}
+	}
+
+	/**
+	 *	- Everything has been taken out, so start over at the front
+	 */
+	start = 0;
+	end = 0;
+	scanned = 0;
+
+	return FRAME_INCOMPLETE;
+}
+
+size_t FrameBuffer::get_length() {
+	return end - start;
+}
+
+unsigned long long FrameBuffer::get_frames() {
+	return frames;
+}
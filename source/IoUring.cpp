@@ -0,0 +1,242 @@
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include "../include/IoUring.h"
+
+IoUring::IoUring() {
+	ring_file_descriptor = -1;
+	sq_entries = 0;
+	sqe_tail = 0;
+	sq_ring = MAP_FAILED;
+	cq_ring = MAP_FAILED;
+	sqes = (io_uring_sqe*)MAP_FAILED;
+	buffer_ring = (io_uring_buf_ring*)MAP_FAILED;
+	buffers = NULL;
+	buffer_size = 0;
+	buffer_entries = 0;
+}
+
+IoUring::~IoUring() {
+	if (buffer_ring != MAP_FAILED) {
+		munmap(buffer_ring, buffer_entries * sizeof(io_uring_buf));
+	}
+
+	free(buffers);
+
+	if (sqes != MAP_FAILED) {
+		munmap(sqes, sqes_size);
+	}
+
+	if (cq_ring != MAP_FAILED && cq_ring != sq_ring) {
+		munmap(cq_ring, cq_ring_size);
+	}
+
+	if (sq_ring != MAP_FAILED) {
+		munmap(sq_ring, sq_ring_size);
+	}
+
+	if (ring_file_descriptor >= 0) {
+		close(ring_file_descriptor);
+	}
+}
+
+int IoUring::setup(unsigned entries) {
+	io_uring_params params;
+
+	/**
+	 *	- Keep submitting the rest of a batch if one entry fails, and let
+	 *	  the kernel defer completion work until the event loop's thread
+	 *	  next enters it instead of interrupting the thread
+	 */
+	memset(&params, 0, sizeof(params));
+	params.flags = IORING_SETUP_SUBMIT_ALL | IORING_SETUP_COOP_TASKRUN;
+
+	ring_file_descriptor = syscall(__NR_io_uring_setup, entries, &params);
+
+	if (ring_file_descriptor < EXIT_SUCCESS) {
+		return EXIT_FAILURE;
+	}
+
+	/**
+	 *	- Map the submission queue ring, the completion queue ring (the
+	 *	  same mapping on kernels with IORING_FEAT_SINGLE_MMAP), and the
+	 *	  array of submission queue entries
+	 */
+	sq_entries = params.sq_entries;
+	sq_ring_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+	cq_ring_size = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+
+	if (params.features & IORING_FEAT_SINGLE_MMAP) {
+		if (cq_ring_size > sq_ring_size) {
+			sq_ring_size = cq_ring_size;
+		}
+		cq_ring_size = sq_ring_size;
+	}
+
+	sq_ring = mmap(NULL, sq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_file_descriptor, IORING_OFF_SQ_RING);
+
+	if (sq_ring == MAP_FAILED) {
+		return EXIT_FAILURE;
+	}
+
+	if (params.features & IORING_FEAT_SINGLE_MMAP) {
+		cq_ring = sq_ring;
+	}
+	else {
+		cq_ring = mmap(NULL, cq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_file_descriptor, IORING_OFF_CQ_RING);
+
+		if (cq_ring == MAP_FAILED) {
+			return EXIT_FAILURE;
+		}
+	}
+
+	sqes_size = params.sq_entries * sizeof(io_uring_sqe);
+	sqes = (io_uring_sqe*)mmap(NULL, sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_file_descriptor, IORING_OFF_SQES);
+
+	if (sqes == MAP_FAILED) {
+		return EXIT_FAILURE;
+	}
+
+	sq_head = (unsigned*)((char*)sq_ring + params.sq_off.head);
+	sq_tail = (unsigned*)((char*)sq_ring + params.sq_off.tail);
+	sq_mask = (unsigned*)((char*)sq_ring + params.sq_off.ring_mask);
+	sq_array = (unsigned*)((char*)sq_ring + params.sq_off.array);
+	cq_head = (unsigned*)((char*)cq_ring + params.cq_off.head);
+	cq_tail = (unsigned*)((char*)cq_ring + params.cq_off.tail);
+	cq_mask = (unsigned*)((char*)cq_ring + params.cq_off.ring_mask);
+	cqes = (io_uring_cqe*)((char*)cq_ring + params.cq_off.cqes);
+	sqe_tail = *sq_tail;
+
+	return EXIT_SUCCESS;
+}
+
+io_uring_sqe* IoUring::get_sqe() {
+	io_uring_sqe* sqe;
+
+	/**
+	 *	- If every entry is prepared but not submitted yet, submit them
+	 *	  now (without waiting) to make room
+	 */
+	if (sqe_tail - __atomic_load_n(sq_head, __ATOMIC_ACQUIRE) >= sq_entries) {
+		if (submit_and_wait(0) < EXIT_SUCCESS) {
+			return NULL;
+		}
+
+		if (sqe_tail - __atomic_load_n(sq_head, __ATOMIC_ACQUIRE) >= sq_entries) {
+			return NULL;
+		}
+	}
+
+	sqe = &sqes[sqe_tail & *sq_mask];
+	sq_array[sqe_tail & *sq_mask] = sqe_tail & *sq_mask;
+	sqe_tail++;
+	memset(sqe, 0, sizeof(*sqe));
+
+	return sqe;
+}
+
+int IoUring::submit_and_wait(unsigned wait_nr) {
+	unsigned to_submit;
+	int return_value;
+
+	/**
+	 *	- Publish the prepared entries to the kernel, then submit them
+	 *	  and wait for completions with one io_uring_enter
+	 */
+	to_submit = sqe_tail - *sq_tail;
+	__atomic_store_n(sq_tail, sqe_tail, __ATOMIC_RELEASE);
+
+	if (to_submit == 0 && wait_nr == 0) {
+		return 0;
+	}
+
+	return_value = syscall(__NR_io_uring_enter, ring_file_descriptor, to_submit, wait_nr, wait_nr > 0 ? IORING_ENTER_GETEVENTS : 0, NULL, 0);
+
+	return return_value;
+}
+
+io_uring_cqe* IoUring::peek_cqe() {
+	unsigned head;
+
+	head = *cq_head;
+
+	if (head == __atomic_load_n(cq_tail, __ATOMIC_ACQUIRE)) {
+		return NULL;
+	}
+
+	return &cqes[head & *cq_mask];
+}
+
+void IoUring::cqe_seen() {
+	__atomic_store_n(cq_head, *cq_head + 1, __ATOMIC_RELEASE);
+}
+
+int IoUring::register_buffer_ring(unsigned short group, unsigned short entries, unsigned size) {
+	io_uring_buf_reg registration;
+	int return_value;
+
+	/**
+	 *	- The ring must be page aligned, so map it rather than malloc it
+	 */
+	buffer_ring = (io_uring_buf_ring*)mmap(NULL, entries * sizeof(io_uring_buf), PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+	if (buffer_ring == MAP_FAILED) {
+		return EXIT_FAILURE;
+	}
+
+	buffers = (char*)malloc((size_t)entries * size);
+
+	if (buffers == NULL) {
+		return EXIT_FAILURE;
+	}
+
+	buffer_entries = entries;
+	buffer_size = size;
+
+	memset(&registration, 0, sizeof(registration));
+	registration.ring_addr = (unsigned long)buffer_ring;
+	registration.ring_entries = entries;
+	registration.bgid = group;
+
+	return_value = syscall(__NR_io_uring_register, ring_file_descriptor, IORING_REGISTER_PBUF_RING, &registration, 1);
+
+	if (return_value < EXIT_SUCCESS) {
+		return EXIT_FAILURE;
+	}
+
+	/**
+	 *	- Hand every buffer to the kernel
+	 */
+	buffer_ring->tail = 0;
+	for (unsigned short id = 0; id < entries; id++) {
+		recycle_buffer(id);
+	}
+
+	return EXIT_SUCCESS;
+}
+
+char* IoUring::get_buffer(unsigned short id) {
+	return buffers + (size_t)id * buffer_size;
+}
+
+void IoUring::recycle_buffer(unsigned short id) {
+	io_uring_buf* buffer;
+	unsigned short tail;
+
+	/**
+	 *	- Index the ring as a plain array of io_uring_buf. In C++ the
+	 *	  header's flexible bufs member sits behind an empty struct of
+	 *	  size 1, so it does not start at the ring's first byte
+	 */
+	tail = buffer_ring->tail;
+	buffer = (io_uring_buf*)buffer_ring + (tail & (buffer_entries - 1));
+	buffer->addr = (unsigned long)get_buffer(id);
+	buffer->len = buffer_size;
+	buffer->bid = id;
+	__atomic_store_n(&buffer_ring->tail, (unsigned short)(tail + 1), __ATOMIC_RELEASE);
+}
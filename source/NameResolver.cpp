@@ -0,0 +1,142 @@
+#include <arpa/inet.h>
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <string>
+#include <sys/socket.h>
+#include <system_error>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+
+#include "../include/NameResolver.h"
+
+/**
+ * \def		NI_NONE
+ * \brief	The value to send to getnameinfo for zero flags
+ */
+#define NI_NONE	(0)
+
+NameResolver::NameResolver() {
+	ttl = std::chrono::seconds(0);
+	stopping = false;
+}
+
+NameResolver::~NameResolver() {
+	stop();
+}
+
+int NameResolver::start(int _ttl) {
+	ttl = std::chrono::seconds(_ttl);
+
+	try {
+		thread = std::thread(&NameResolver::run_resolver, this);
+	}
+	catch (const std::system_error&) {
+		return EXIT_FAILURE;
+	}
+
+	return EXIT_SUCCESS;
+}
+
+void NameResolver::stop() {
+	cache_mutex.lock();
+	stopping = true;
+	pending.clear();
+	cache_mutex.unlock();
+	lookups_available.notify_all();
+
+	if (thread.joinable()) {
+		thread.join();
+	}
+}
+
+int NameResolver::lookup(const sockaddr_in* socket_address, char* host_name, size_t size) {
+	std::lock_guard<std::mutex> lock(cache_mutex);
+	std::unordered_map<in_addr_t, CacheEntry>::iterator entry;
+	in_addr_t ip_address;
+
+	ip_address = socket_address->sin_addr.s_addr;
+
+	entry = cache.find(ip_address);
+	if (entry != cache.end() && entry->second.expiry > std::chrono::steady_clock::now()) {
+		strncpy(host_name, entry->second.host_name.c_str(), size - 1);
+		host_name[size - 1] = '\0';
+		return EXIT_SUCCESS;
+	}
+
+	/**
+	 *	- Missing or expired: resolve it in the background and let this
+	 *	  client make do with its IP address
+	 */
+	if (!stopping && queued.insert(ip_address).second) {
+		pending.push_back(ip_address);
+		lookups_available.notify_one();
+	}
+
+	return EXIT_FAILURE;
+}
+
+void NameResolver::run_resolver() {
+	sockaddr_in socket_address;
+	char host_name[NI_MAXHOST];
+	in_addr_t ip_address;
+	int return_value;
+	std::chrono::steady_clock::time_point now;
+
+	memset(&socket_address, 0, sizeof(socket_address));
+	socket_address.sin_family = AF_INET;
+
+	while (1) {
+		{
+			std::unique_lock<std::mutex> lock(cache_mutex);
+			lookups_available.wait(lock, [this] { return stopping || !pending.empty(); });
+
+			if (stopping) {
+				return;
+			}
+
+			ip_address = pending.front();
+			pending.pop_front();
+		}
+
+		/**
+		 *	- Only this thread ever waits on the resolver. An IP address
+		 *	  without a host name is cached as itself, so it is not looked
+		 *	  up again until it expires
+		 */
+		socket_address.sin_addr.s_addr = ip_address;
+		return_value = getnameinfo((sockaddr*)&socket_address, sizeof(socket_address), host_name, NI_MAXHOST, NULL, 0, NI_NONE);
+
+		if (return_value != EXIT_SUCCESS) {
+			inet_ntop(AF_INET, &socket_address.sin_addr, host_name, NI_MAXHOST);
+		}
+
+		std::lock_guard<std::mutex> lock(cache_mutex);
+		now = std::chrono::steady_clock::now();
+
+		if (cache.size() >= MAX_CACHE_ENTRIES) {
+			for (std::unordered_map<in_addr_t, CacheEntry>::iterator entry = cache.begin(); entry != cache.end();) {
+				if (entry->second.expiry <= now) {
+					entry = cache.erase(entry);
+				}
+				else {
+					entry++;
+				}
+			}
+
+			if (cache.size() >= MAX_CACHE_ENTRIES) {
+				cache.clear();
+			}
+		}
+
+		cache[ip_address].host_name = host_name;
+		cache[ip_address].expiry = now + ttl;
+		queued.erase(ip_address);
+	}
+}
@@ -0,0 +1,133 @@
+#include <arpa/inet.h>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <string>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <vector>
+
+#include "../include/pugiconfig.hpp"
+#include "../include/pugixml.hpp"
+#include "../include/FrameBuffer.h"
+#include "../include/OutputQueue.h"
+
+/**
+ * \def		LENGTH_PREFIX_SIZE
+ * \brief	Size of the length prefix of FRAMING_LENGTH_PREFIX
+ */
+#define LENGTH_PREFIX_SIZE	(sizeof(uint32_t))
+
+OutputQueue::OutputQueue() {
+	offset = 0;
+	length = 0;
+	framing = FRAMING_NEWLINE;
+	memset(&message, 0, sizeof(message));
+	message.msg_iov = vectors;
+	spares.reserve(MAX_SPARES);
+}
+
+int OutputQueue::set_framing(Framing _framing) {
+	framing = _framing;
+
+	return EXIT_SUCCESS;
+}
+
+void OutputQueue::push(std::string *response) {
+	segments.emplace_back();
+
+	if (framing == FRAMING_LENGTH_PREFIX) {
+		segments.back().length_prefix = htonl(response->length());
+		length += LENGTH_PREFIX_SIZE;
+	}
+	else {
+		response->push_back('\0');
+	}
+
+	length += response->length();
+	segments.back().response.swap(*response);
+}
+
+void OutputQueue::reuse(std::string *buffer) {
+	if (!spares.empty() && buffer->empty() && buffer->capacity() < spares.back().capacity()) {
+		buffer->swap(spares.back());
+		spares.pop_back();
+	}
+}
+
+msghdr* OutputQueue::gather(bool *more) {
+	size_t skip;
+	size_t prefix_size;
+	int count;
+	std::deque<Segment>::iterator segment;
+
+	/**
+	 *	- Only the front segment may have been partly sent already
+	 */
+	count = 0;
+	skip = offset;
+	prefix_size = (framing == FRAMING_LENGTH_PREFIX) ? LENGTH_PREFIX_SIZE : 0;
+
+	for (segment = segments.begin(); segment != segments.end() && count < MAX_GATHER; segment++) {
+		if (skip < prefix_size) {
+			vectors[count].iov_base = (char*)&segment->length_prefix + skip;
+			vectors[count].iov_len = prefix_size - skip;
+			count++;
+			skip = prefix_size;
+
+			if (count == MAX_GATHER) {
+				break;
+			}
+		}
+
+		vectors[count].iov_base = (char*)segment->response.data() + (skip - prefix_size);
+		vectors[count].iov_len = segment->response.length() - (skip - prefix_size);
+		count++;
+		skip = 0;
+	}
+
+	*more = (segment != segments.end());
+	message.msg_iovlen = count;
+
+	return &message;
+}
+
+void OutputQueue::consume(size_t size) {
+	size_t prefix_size;
+	size_t remaining;
+
+	prefix_size = (framing == FRAMING_LENGTH_PREFIX) ? LENGTH_PREFIX_SIZE : 0;
+	length -= size;
+
+	while (size > 0 && !segments.empty()) {
+		remaining = prefix_size + segments.front().response.length() - offset;
+
+		if (size < remaining) {
+			offset += size;
+			return;
+		}
+
+		size -= remaining;
+
+		/**
+		 *	- Keep the buffer of the sent response as a spare
+		 */
+		if (spares.size() < MAX_SPARES && segments.front().response.capacity() <= MAX_SPARE_CAPACITY) {
+			segments.front().response.clear();
+			spares.emplace_back();
+			spares.back().swap(segments.front().response);
+		}
+
+		segments.pop_front();
+		offset = 0;
+	}
+}
+
+bool OutputQueue::empty() {
+	return segments.empty();
+}
+
+size_t OutputQueue::get_length() {
+	return length;
+}
@@ -0,0 +1,168 @@
+#include <cstdlib>
+#include <cstring>
+#include <string_view>
+#include <vector>
+
+#include "../include/pugiconfig.hpp"
+#include "../include/pugixml.hpp"
+#include "../include/RequestSchema.h"
+#include "../include/RequestReader.h"
+
+RequestReader::RequestReader() {
+	element = ELEMENT_NONE;
+	seen_request = false;
+	seen_command = false;
+	seen_data = false;
+	command_name = NULL;
+	row.type = NULL;
+	row_has_text = false;
+}
+
+bool RequestReader::read(char* data, size_t size, const CommandSchema** command, std::string_view* values) {
+	pugi::xml_parse_result result;
+
+	element = ELEMENT_NONE;
+	seen_request = false;
+	seen_command = false;
+	seen_data = false;
+	command_name = NULL;
+	rows.clear();
+
+	*command = NULL;
+
+	/**
+	 *	- Requests are read as UTF-8, so the parser never has to convert
+	 *	  them and everything it hands over points into data
+	 */
+	result = pugi::parse_sax_inplace(data, size, *this, pugi::parse_default, pugi::encoding_utf8);
+	if (!result) {
+		return false;
+	}
+
+	/**
+	 *	- The envelope checked out as it was read, so only the Rows are
+	 *	  left to check against the schema of the command
+	 */
+	*command = RequestSchema::find_command(command_name != NULL ? command_name : "");
+
+	if (!RequestSchema::validate_rows(*command, rows.data(), rows.size(), values)) {
+		*command = NULL;
+		return false;
+	}
+
+	return true;
+}
+
+bool RequestReader::start_element(const char* name) {
+	switch (element) {
+
+	/**
+	 *	- The document holds a single Request node
+	 */
+	case ELEMENT_NONE:
+		if (seen_request || strcmp(name, "Request") != 0) {
+			return false;
+		}
+		seen_request = true;
+		element = ELEMENT_REQUEST;
+		return true;
+
+	/**
+	 *	- Request holds exactly one Command node and exactly one Data node
+	 */
+	case ELEMENT_REQUEST:
+		if (!seen_command && strcmp(name, "Command") == 0) {
+			seen_command = true;
+			element = ELEMENT_COMMAND;
+			return true;
+		}
+		else if (!seen_data && strcmp(name, "Data") == 0) {
+			seen_data = true;
+			element = ELEMENT_DATA;
+			return true;
+		}
+		return false;
+
+	/**
+	 *	- Data holds nothing but Row nodes
+	 */
+	case ELEMENT_DATA:
+		if (strcmp(name, "Row") != 0) {
+			return false;
+		}
+		row.type = NULL;
+		row.value = std::string_view();
+		row_has_text = false;
+		element = ELEMENT_ROW;
+		return true;
+
+	/**
+	 *	- Command and Row hold nothing but their text
+	 */
+	default:
+		return false;
+	}
+}
+
+bool RequestReader::attribute(const char* name, const char* value) {
+	/**
+	 *	- Row has a Type attribute and nothing else. Nothing else may
+	 *	  have attributes
+	 */
+	if (element != ELEMENT_ROW || row.type != NULL || strcmp(name, "Type") != 0) {
+		return false;
+	}
+
+	row.type = value;
+
+	return true;
+}
+
+bool RequestReader::end_element(const char*) {
+	switch (element) {
+	case ELEMENT_ROW:
+		if (row.type == NULL) {
+			return false;
+		}
+		rows.push_back(row);
+		element = ELEMENT_DATA;
+		return true;
+
+	case ELEMENT_COMMAND:
+	case ELEMENT_DATA:
+		element = ELEMENT_REQUEST;
+		return true;
+
+	case ELEMENT_REQUEST:
+		element = ELEMENT_NONE;
+		return seen_command && seen_data;
+
+	default:
+		return false;
+	}
+}
+
+bool RequestReader::text(const char* value) {
+	/**
+	 *	- Command and Row hold at most a single text field. Nothing else
+	 *	  may hold text
+	 */
+	if (element == ELEMENT_COMMAND && command_name == NULL) {
+		command_name = value;
+		return true;
+	}
+	else if (element == ELEMENT_ROW && !row_has_text) {
+		row.value = value;
+		row_has_text = true;
+		return true;
+	}
+
+	return false;
+}
+
+bool RequestReader::cdata(const char*) {
+	/**
+	 *	- A CDATA section is never a valid text field
+	 */
+	return false;
+}
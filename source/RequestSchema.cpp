@@ -0,0 +1,270 @@
+#include <arpa/inet.h>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <coroutine>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <exception>
+#include <linux/io_uring.h>
+#include <map>
+#include <mutex>
+#include <netdb.h>
+#include <string>
+#include <string_view>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "../include/pugiconfig.hpp"
+#include "../include/pugixml.hpp"
+#include "../include/CommandTable.h"
+#include "../include/Connection.h"
+#include "../include/FrameBuffer.h"
+#include "../include/IoUring.h"
+#include "../include/NameResolver.h"
+#include "../include/OutputQueue.h"
+#include "../include/RequestSchema.h"
+#include "../include/RequestReader.h"
+#include "../include/RequestContext.h"
+#include "../include/ResponseTemplate.h"
+#include "../include/TimerWheel.h"
+#include "../include/SocketClient.h"
+#include "../include/WorkerPool.h"
+#include "../include/SocketServer.h"
+
+/**
+ * \var		GETPLAYERINFO_ROWS
+ * \brief	GetPlayerInfo takes the card number and PIN of the player (in
+ *		this order, see get_player_info)
+ */
+static const RowSchema GETPLAYERINFO_ROWS[] = {
+	{ "CardNumber",	1,	1 },
+	{ "PIN",	1,	1 }
+};
+
+constexpr CommandSchema RequestSchema::COMMANDS[] = {
+	{ "GetPlayerInfo",	GETPLAYERINFO_ROWS,	sizeof(GETPLAYERINFO_ROWS) / sizeof(GETPLAYERINFO_ROWS[0]),	&SocketServer::command_getplayerinfo }
+};
+
+constexpr size_t RequestSchema::COMMAND_COUNT = sizeof(COMMANDS) / sizeof(COMMANDS[0]);
+
+/**
+ * \var		COMMAND_TABLE
+ * \brief	Perfect hash of the names in COMMANDS, built by the compiler
+ */
+static constexpr CommandTable<RequestSchema::COMMAND_COUNT> COMMAND_TABLE(RequestSchema::COMMANDS);
+
+/**
+ * \var		command_counts
+ * \brief	Number of requests counted for each entry in COMMANDS
+ */
+static std::atomic<unsigned long long> command_counts[RequestSchema::COMMAND_COUNT];
+
+bool RequestSchema::validate(pugi::xml_node document, const CommandSchema** command, std::string_view* values) {
+	pugi::xml_node request;
+	pugi::xml_node command_node;
+	pugi::xml_node data;
+
+	*command = NULL;
+
+	/**
+	 *	- The document holds a single Request node
+	 */
+	request = document.first_child();
+	if (request.type() != pugi::node_element || strcmp(request.name(), "Request") != 0 || request.next_sibling()) {
+		return false;
+	}
+
+	if (request.first_attribute()) {
+		return false;
+	}
+
+	/**
+	 *	- Request holds exactly one Command node and exactly one Data node
+	 */
+	for (pugi::xml_node node = request.first_child(); node; node = node.next_sibling()) {
+		if (node.type() != pugi::node_element) {
+			return false;
+		}
+		else if (strcmp(node.name(), "Command") == 0 && !command_node) {
+			command_node = node;
+		}
+		else if (strcmp(node.name(), "Data") == 0 && !data) {
+			data = node;
+		}
+		else {
+			return false;
+		}
+	}
+
+	if (!command_node || !data || !is_text_only(command_node)) {
+		return false;
+	}
+
+	/**
+	 *	- Check the Rows against the command's schema
+	 */
+	*command = find_command(command_node.child_value());
+
+	if (!validate_data(data, *command, values)) {
+		*command = NULL;
+		return false;
+	}
+
+	return true;
+}
+
+GetPlayerInfoRequest RequestSchema::get_player_info(const std::string_view* values) {
+	GetPlayerInfoRequest request;
+
+	request.card = values[0];
+	request.pin = values[1];
+
+	return request;
+}
+
+const CommandSchema* RequestSchema::find_command(const char* name) {
+	size_t index;
+
+	index = COMMAND_TABLE.find(name);
+	if (index == COMMAND_TABLE.NOT_FOUND) {
+		return NULL;
+	}
+
+	return &COMMANDS[index];
+}
+
+unsigned long long RequestSchema::count_command(const CommandSchema* command) {
+	return command_counts[command - COMMANDS].fetch_add(1, std::memory_order_relaxed) + 1;
+}
+
+bool RequestSchema::is_text_only(pugi::xml_node node) {
+	pugi::xml_node child;
+
+	if (node.first_attribute()) {
+		return false;
+	}
+
+	child = node.first_child();
+
+	return !child || (child.type() == pugi::node_pcdata && !child.next_sibling());
+}
+
+bool RequestSchema::validate_rows(const CommandSchema* command, const RowValue* rows, size_t count, std::string_view* values) {
+	unsigned counts[MAX_ROWS];
+
+	command = get_schema(command);
+	if (!start_rows(command, counts, values)) {
+		return false;
+	}
+
+	for (size_t i = 0; i < count; i++) {
+		if (!count_row(command, rows[i].type, rows[i].value, counts, values)) {
+			return false;
+		}
+	}
+
+	return check_counts(command, counts);
+}
+
+bool RequestSchema::validate_data(pugi::xml_node data, const CommandSchema* command, std::string_view* values) {
+	unsigned counts[MAX_ROWS];
+	pugi::xml_attribute type;
+	pugi::xml_node text;
+
+	command = get_schema(command);
+	if (data.first_attribute() || !start_rows(command, counts, values)) {
+		return false;
+	}
+
+	for (pugi::xml_node node = data.first_child(); node; node = node.next_sibling()) {
+		/**
+		 *	- A Row with a Type attribute and nothing else, holding
+		 *	  nothing but its text
+		 */
+		if (node.type() != pugi::node_element || strcmp(node.name(), "Row") != 0) {
+			return false;
+		}
+
+		type = node.first_attribute();
+		if (!type || strcmp(type.name(), "Type") != 0 || type.next_attribute()) {
+			return false;
+		}
+
+		text = node.first_child();
+		if (text && (text.type() != pugi::node_pcdata || text.next_sibling())) {
+			return false;
+		}
+
+		if (!count_row(command, type.value(), text ? text.value() : "", counts, values)) {
+			return false;
+		}
+	}
+
+	return check_counts(command, counts);
+}
+
+const CommandSchema* RequestSchema::get_schema(const CommandSchema* command) {
+	/**
+	 *	- Requests have always been held to the Rows of GetPlayerInfo
+	 *	  before their command was looked at, so one with a command that
+	 *	  is not known is only answered Invalid Command if its Rows are
+	 *	  those of GetPlayerInfo, and Invalid Request Format otherwise
+	 */
+	if (command == NULL) {
+		return &COMMANDS[0];
+	}
+
+	return command;
+}
+
+bool RequestSchema::start_rows(const CommandSchema* command, unsigned* counts, std::string_view* values) {
+	if (command->row_count > MAX_ROWS) {
+		return false;
+	}
+
+	for (size_t row = 0; row < command->row_count; row++) {
+		counts[row] = 0;
+		values[row] = std::string_view();
+	}
+
+	return true;
+}
+
+bool RequestSchema::count_row(const CommandSchema* command, const char* type, std::string_view text, unsigned* counts, std::string_view* values) {
+	size_t row;
+
+	/**
+	 *	- Of a Type the command takes, and no more often than allowed.
+	 *	  Keep its text, which points into the request buffer
+	 */
+	for (row = 0; row < command->row_count; row++) {
+		if (strcmp(command->rows[row].type, type) == 0) {
+			break;
+		}
+	}
+
+	if (row == command->row_count || ++counts[row] > command->rows[row].max_occurs) {
+		return false;
+	}
+
+	values[row] = text;
+
+	return true;
+}
+
+bool RequestSchema::check_counts(const CommandSchema* command, const unsigned* counts) {
+	for (size_t row = 0; row < command->row_count; row++) {
+		if (counts[row] < command->rows[row].min_occurs) {
+			return false;
+		}
+	}
+
+	return true;
+}
@@ -0,0 +1,104 @@
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "../include/ResponseTemplate.h"
+
+ResponseTemplate::ResponseTemplate() {
+}
+
+void ResponseTemplate::compile(const std::string& skeleton) {
+	size_t start;
+	size_t marker;
+
+	text.clear();
+	slots.clear();
+
+	start = 0;
+	marker = skeleton.find(SLOT_MARKER);
+	while (marker != std::string::npos) {
+		text.append(skeleton, start, marker - start);
+		slots.push_back(text.size());
+
+		start = marker + strlen(SLOT_MARKER);
+		marker = skeleton.find(SLOT_MARKER, start);
+	}
+
+	text.append(skeleton, start, std::string::npos);
+}
+
+void ResponseTemplate::render(std::string* output, const std::string_view* values) const {
+	size_t start;
+	size_t length;
+
+	/**
+	 *	- Reserve for the common case of values that need no escaping,
+	 *	  so the output grows at most once
+	 */
+	length = text.size();
+	for (size_t slot = 0; slot < slots.size(); slot++) {
+		length += values[slot].size();
+	}
+	output->reserve(output->size() + length);
+
+	start = 0;
+	for (size_t slot = 0; slot < slots.size(); slot++) {
+		output->append(text, start, slots[slot] - start);
+		append_escaped(output, values[slot]);
+		start = slots[slot];
+	}
+
+	output->append(text, start, std::string::npos);
+}
+
+size_t ResponseTemplate::get_slot_count() const {
+	return slots.size();
+}
+
+void ResponseTemplate::append_escaped(std::string* output, std::string_view value) {
+	size_t start;
+	unsigned char character;
+	char reference[6];
+
+	start = 0;
+	for (size_t i = 0; i < value.size(); i++) {
+		character = (unsigned char)value[i];
+
+		/**
+		 *	- Copy runs that need no escaping as they are. Like pugixml,
+		 *	  escape &, < and >, and control characters other than tab,
+		 *	  CR and LF as two-digit character references
+		 */
+		if (character >= 32 ? (character != '&' && character != '<' && character != '>') : (character == '\t' || character == '\r' || character == '\n')) {
+			continue;
+		}
+
+		output->append(value, start, i - start);
+		start = i + 1;
+
+		switch (character) {
+		case '&':
+			output->append("&amp;");
+			break;
+		case '<':
+			output->append("&lt;");
+			break;
+		case '>':
+			output->append("&gt;");
+			break;
+		default:
+			reference[0] = '&';
+			reference[1] = '#';
+			reference[2] = (char)('0' + character / 10);
+			reference[3] = (char)('0' + character % 10);
+			reference[4] = ';';
+			reference[5] = '\0';
+			output->append(reference);
+			break;
+		}
+	}
+
+	output->append(value, start, std::string_view::npos);
+}
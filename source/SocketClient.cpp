@@ -1,53 +1,55 @@
 #include <arpa/inet.h>
+#include <chrono>
+#include <coroutine>
+#include <cstdint>
 #include <cstdlib>
 #include <cstring>
+#include <deque>
+#include <exception>
+#include <map>
 #include <netdb.h>
 #include <string>
 #include <sys/socket.h>
 #include <sys/types.h>
+#include <sys/uio.h>
 #include <unistd.h>
-
+#include <vector>
+
+#include "../include/pugiconfig.hpp"
+#include "../include/pugixml.hpp"
+#include "../include/Connection.h"
+#include "../include/FrameBuffer.h"
+#include "../include/OutputQueue.h"
+#include "../include/TimerWheel.h"
 #include "../include/SocketClient.h"
 
-/**
- * \def		NI_NONE
- * \brief	The value to send to getnameinfo for zero flags
- */
-#define NI_NONE	(0)
-
 SocketClient::SocketClient() {
 	socket_address_length = sizeof(socket_address);
 	memset(host_name, 0, NI_MAXHOST);
-	memset(service, 0, NI_MAXSERV);
+	send_in_flight = false;
+	pending_operations = 0;
+	closing = false;
+	id = 0;
+	next_sequence = 0;
+	next_response = 0;
+	connection = NULL;
+	timer.prev = NULL;
+	timer.next = NULL;
+	timer.owner = this;
+	last_activity = std::chrono::steady_clock::now();
+	request_pending = false;
+	request_frames = 0;
+	write_pending = false;
 }
 
 char* SocketClient::get_host_name() {
 	return host_name;
 }
 
-char* SocketClient::get_service() {
-	return service;
-}
-
 unsigned short SocketClient::get_sin_port() {
 	return ntohs(socket_address.sin_port);
 }
 
-int SocketClient::set_name_info() {
-	int return_value;
-
-	return_value = getnameinfo((sockaddr*)&socket_address, socket_address_length, host_name, NI_MAXHOST, service, NI_MAXSERV, NI_NONE);
-
-	if (return_value != EXIT_SUCCESS) {
-		return_value = EXIT_FAILURE;
-	}
-	else {
-		return_value = EXIT_SUCCESS;
-	}
-
-	return return_value;
-}
-
 int SocketClient::set_ipv4_info() {
 	char* temp;
 	int return_value;
@@ -1,16 +1,49 @@
 #include <arpa/inet.h>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <coroutine>
+#include <cstdint>
 #include <cstdlib>
 #include <cstring>
+#include <deque>
+#include <exception>
 #include <iostream>
+#include <linux/filter.h>
+#include <linux/io_uring.h>
+#include <map>
+#include <mutex>
 #include <netdb.h>
+#include <netinet/tcp.h>
+#include <poll.h>
 #include <string>
+#include <string_view>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
 #include <sys/socket.h>
 #include <sys/types.h>
+#include <sys/uio.h>
+#include <thread>
 #include <unistd.h>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
 
 #include "../include/pugiconfig.hpp"
 #include "../include/pugixml.hpp"
+#include "../include/Connection.h"
+#include "../include/FrameBuffer.h"
+#include "../include/IoUring.h"
+#include "../include/NameResolver.h"
+#include "../include/OutputQueue.h"
+#include "../include/RequestSchema.h"
+#include "../include/RequestReader.h"
+#include "../include/RequestContext.h"
+#include "../include/ResponseTemplate.h"
+#include "../include/ErrorResponse.h"
+#include "../include/TimerWheel.h"
 #include "../include/SocketClient.h"
+#include "../include/WorkerPool.h"
 #include "../include/SocketServer.h"
 
 /**
@@ -33,6 +66,35 @@
 #define TEST_CARD_STATE			("NV")
 #define TEST_CARD_ZIP_CODE		("55555")
 
+/**
+ * \var		PLAYER_INFO_ROWS
+ * \brief	Type of each Row of a successful GetPlayerInfo response, in
+ *		order
+ */
+static const char* const PLAYER_INFO_ROWS[] = { "CardNumber", "FirstName", "LastName", "Address", "City", "State", "ZipCode" };
+
+/**
+ * \var		INVALID_REQUEST_FORMAT_RESPONSE, INVALID_COMMAND_RESPONSE,
+ *		INVALID_PIN_RESPONSE, INVALID_CARD_NUMBER_RESPONSE
+ * \brief	Error responses, serialized by the compiler. None of them
+ *		varies, so sending one is a single copy from static storage.
+ *		The first two keep the empty Command node the server has always
+ *		answered with
+ */
+static constexpr auto INVALID_REQUEST_FORMAT_RESPONSE = make_error_response("<Command />", "Invalid Request Format");
+static constexpr auto INVALID_COMMAND_RESPONSE = make_error_response("<Command />", "Invalid Command");
+static constexpr auto INVALID_PIN_RESPONSE = make_error_response("<Command>GetPlayerInfo</Command>", "Invalid PIN");
+static constexpr auto INVALID_CARD_NUMBER_RESPONSE = make_error_response("<Command>GetPlayerInfo</Command>", "Invalid Card Number");
+
+/**
+ * \var		BUSY_RESPONSE
+ * \brief	Response sent in place of processing a request while the worker
+ *		pool is over its admission limits, so turning a request away
+ *		costs no parsing or XML building. It has the same shape as
+ *		Invalid Request Format, empty Command node included
+ */
+static constexpr auto BUSY_RESPONSE = make_error_response("<Command />", "Busy");
+
 /**
  * \struct	xml_string_writer
  * \brief	Used for printing XML trees. Referenced from
@@ -48,6 +110,37 @@ struct xml_string_writer : pugi::xml_writer
 	}
 };
 
+SocketServer::SocketServer() {
+	reuse_port = false;
+	file_descriptor = -1;
+	epoll_file_descriptor = -1;
+	completion_file_descriptor = -1;
+	next_client_id = 0;
+	workers = NULL;
+	use_coroutines = false;
+	use_streaming_parser = false;
+	resolver = NULL;
+	idle_timeout = std::chrono::seconds(0);
+	request_timeout = std::chrono::seconds(0);
+	write_timeout = std::chrono::seconds(0);
+	keepalive_idle = 0;
+	keepalive_interval = 0;
+	keepalive_count = 0;
+	timeout_interval.tv_sec = 0;
+	timeout_interval.tv_nsec = TimerWheel::TICK_MS * 1000000LL;
+	use_io_uring = false;
+	ring = NULL;
+	framing = FRAMING_NEWLINE;
+
+	/**
+	 *	- Requests parsed on the event loop reuse the memory pages of the
+	 *	  ones before them
+	 */
+	context.request.reset(true);
+
+	build_templates();
+}
+
 std::string SocketServer::get_address() {
 	return address;
 }
@@ -68,6 +161,64 @@ int SocketServer::set_port(int _port) {
 	return EXIT_SUCCESS;
 }
 
+int SocketServer::set_reuse_port(bool _reuse_port) {
+	reuse_port = _reuse_port;
+
+	return EXIT_SUCCESS;
+}
+
+int SocketServer::set_io_uring(bool _use_io_uring) {
+	use_io_uring = _use_io_uring;
+
+	return EXIT_SUCCESS;
+}
+
+int SocketServer::set_framing(Framing _framing) {
+	framing = _framing;
+
+	return EXIT_SUCCESS;
+}
+
+int SocketServer::set_worker_pool(WorkerPool* _workers) {
+	workers = _workers;
+
+	return EXIT_SUCCESS;
+}
+
+int SocketServer::set_coroutines(bool _use_coroutines) {
+	use_coroutines = _use_coroutines;
+
+	return EXIT_SUCCESS;
+}
+
+int SocketServer::set_streaming_parser(bool _use_streaming_parser) {
+	use_streaming_parser = _use_streaming_parser;
+
+	return EXIT_SUCCESS;
+}
+
+int SocketServer::set_name_resolver(NameResolver* _resolver) {
+	resolver = _resolver;
+
+	return EXIT_SUCCESS;
+}
+
+int SocketServer::set_timeouts(int _idle_timeout, int _request_timeout, int _write_timeout) {
+	idle_timeout = std::chrono::seconds(_idle_timeout);
+	request_timeout = std::chrono::seconds(_request_timeout);
+	write_timeout = std::chrono::seconds(_write_timeout);
+
+	return EXIT_SUCCESS;
+}
+
+int SocketServer::set_keepalive(int _keepalive_idle, int _keepalive_interval, int _keepalive_count) {
+	keepalive_idle = _keepalive_idle;
+	keepalive_interval = _keepalive_interval;
+	keepalive_count = _keepalive_count;
+
+	return EXIT_SUCCESS;
+}
+
 int SocketServer::get_bytes_received() {
 	return bytes_received;
 }
@@ -83,19 +234,35 @@ int SocketServer::create_tcp_ipv4() {
 	 *	- Domain of AF_INET for IPv4 Internet protocols
 	 *	- Type of SOCK_STREAM for TCP (sequenced, reliable, two-way
 	 *	  connection-based byte streams)
+	 *	- SOCK_NONBLOCK so the edge-triggered event loop can accept
+	 *	  until the backlog is drained without blocking
 	 *	- If socket is successful, socket file descriptor will be returned
 	 */
-	return_value = socket(AF_INET, SOCK_STREAM, TCP_PROTOCOL);
+	return_value = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK, TCP_PROTOCOL);
 
 	if (return_value < EXIT_SUCCESS) {
-		return_value = EXIT_FAILURE;
+		return EXIT_FAILURE;
 	}
-	else {
-		file_descriptor = return_value;
-		return_value = EXIT_SUCCESS;
+
+	file_descriptor = return_value;
+
+	/**
+	 *	- SO_REUSEPORT lets every shard bind its own socket to the same
+	 *	  IP address + port, and the kernel load-balances incoming
+	 *	  connections across them
+	 */
+	if (reuse_port) {
+		return_value = 1;
+		return_value = setsockopt(file_descriptor, SOL_SOCKET, SO_REUSEPORT, &return_value, sizeof(return_value));
+
+		if (return_value < EXIT_SUCCESS) {
+			close(file_descriptor);
+			file_descriptor = -1;
+			return EXIT_FAILURE;
+		}
 	}
 
-	return return_value;
+	return EXIT_SUCCESS;
 }
 
 int SocketServer::bind_tcp_ipv4() {
@@ -148,10 +315,41 @@ int SocketServer::mark_passive() {
 	return return_value;
 }
 
+int SocketServer::steer_to_incoming_cpu(int shards) {
+	int return_value;
+
+	/**
+	 *	- Load the CPU the connection was received on, take it modulo the
+	 *	  number of shards, and return that as the index of the listener
+	 *	  within the SO_REUSEPORT group
+	 */
+	sock_filter code[] = {
+		{ BPF_LD | BPF_W | BPF_ABS, 0, 0, (__u32)(SKF_AD_OFF + SKF_AD_CPU) },
+		{ BPF_ALU | BPF_MOD | BPF_K, 0, 0, (__u32)shards },
+		{ BPF_RET | BPF_A, 0, 0, 0 }
+	};
+	sock_fprog program = { sizeof(code) / sizeof(code[0]), code };
+
+	return_value = setsockopt(file_descriptor, SOL_SOCKET, SO_ATTACH_REUSEPORT_CBPF, &program, sizeof(program));
+
+	if (return_value < EXIT_SUCCESS) {
+		return_value = EXIT_FAILURE;
+	}
+	else {
+		return_value = EXIT_SUCCESS;
+	}
+
+	return return_value;
+}
+
 int SocketServer::accept_client(SocketClient* source) {
 	int return_value;
 
-	return_value = accept(file_descriptor, (sockaddr*)(&source->socket_address), &source->socket_address_length);
+	/**
+	 *	- SOCK_NONBLOCK so that serving one client never blocks the
+	 *	  event loop for the rest
+	 */
+	return_value = accept4(file_descriptor, (sockaddr*)(&source->socket_address), &source->socket_address_length, SOCK_NONBLOCK);
 
 	if (return_value < EXIT_SUCCESS) {
 		return_value = EXIT_FAILURE;
@@ -179,170 +377,1101 @@ int SocketServer::close_file_descriptor() {
 	return return_value;
 }
 
-void SocketServer::receive_request_from_client(SocketClient* source) {
+int SocketServer::create_event_loop() {
+	int return_value;
+	epoll_event event;
+
+	if (use_io_uring) {
+		return create_uring_loop();
+	}
+
+	return_value = epoll_create1(0);
+
+	if (return_value < EXIT_SUCCESS) {
+		return EXIT_FAILURE;
+	}
+
+	epoll_file_descriptor = return_value;
+
 	/**
-	 *	- Clear the buffer that holds the request 
-	 *	- Waits in this function until data has been received from client
-	 *	  via socket connection
-	 *	- If valid number of bytes have been received, store and print the request
+	 *	- Edge-triggered, so accept_clients must drain the backlog every
+	 *	  time the server becomes readable
 	 */
-	memset(buf, 0, BUF_SIZE);
-	bytes_received = recv(source->file_descriptor, buf, BUF_SIZE, 0);
+	event.events = EPOLLIN | EPOLLET;
+	event.data.fd = file_descriptor;
+	return_value = epoll_ctl(epoll_file_descriptor, EPOLL_CTL_ADD, file_descriptor, &event);
 
-	if (bytes_received > 0) {
-		request.load_buffer(buf, bytes_received);
-		std::cout << "Received XML Request: " << std::endl;
-		std::cout << std::endl << get_printable_xml(&request) << std::endl << std::endl;
+	if (return_value < EXIT_SUCCESS) {
+		return EXIT_FAILURE;
 	}
+
+	/**
+	 *	- Worker threads signal this eventfd once they have finished jobs
+	 *	  for this server, so the event loop can send the responses
+	 */
+	return_value = eventfd(0, EFD_NONBLOCK);
+
+	if (return_value < EXIT_SUCCESS) {
+		return EXIT_FAILURE;
+	}
+
+	completion_file_descriptor = return_value;
+	event.events = EPOLLIN;
+	event.data.fd = completion_file_descriptor;
+	return_value = epoll_ctl(epoll_file_descriptor, EPOLL_CTL_ADD, completion_file_descriptor, &event);
+
+	if (return_value < EXIT_SUCCESS) {
+		return_value = EXIT_FAILURE;
+	}
+	else {
+		return_value = EXIT_SUCCESS;
+	}
+
+	return return_value;
 }
 
-void SocketServer::validate_request() {
-	int attributes;
-	int children;
-	request_validated = true;
+int SocketServer::run_event_loop() {
+	int ready;
+	std::unordered_map<int, SocketClient*>::iterator client;
+	epoll_event events[MAX_EVENTS];
+	bool resumed;
+
+	if (ring != NULL) {
+		return run_uring_loop();
+	}
+
+	while (1) {
+		/**
+		 *	- Wake up in time for the next timer wheel tick while any
+		 *	  client has a deadline
+		 */
+		ready = epoll_wait(epoll_file_descriptor, events, MAX_EVENTS, timers.get_wait_timeout(std::chrono::steady_clock::now()));
+
+		if (ready < EXIT_SUCCESS) {
+			if (errno == EINTR) {
+				continue;
+			}
+
+			return EXIT_FAILURE;
+		}
+
+		for (int i = 0; i < ready; i++) {
+			if (events[i].data.fd == file_descriptor) {
+				accept_clients();
+				continue;
+			}
+			else if (events[i].data.fd == completion_file_descriptor) {
+				collect_completed_jobs();
+				continue;
+			}
+
+			client = clients.find(events[i].data.fd);
+			if (client == clients.end()) {
+				continue;
+			}
+
+			/**
+			 *	- Finish any response the client socket could not take
+			 *	  earlier before reading new requests from it
+			 *	- Hang-ups and errors are reported through recv, so they
+			 *	  are handled by serve_client along with regular reads
+			 *	- A coroutine that was waiting for its responses to be
+			 *	  taken stopped serve_client from reading, so read what
+			 *	  has arrived since once it carries on (no new EPOLLIN
+			 *	  edge would report it)
+			 */
+			resumed = false;
+			if (events[i].events & EPOLLOUT) {
+				if (flush_response_to_client(client->second) != EXIT_SUCCESS) {
+					std::cerr << "FAILURE: Error sending response to client" << std::endl;
+					disconnect_client(client->second);
+					continue;
+				}
+
+				if (client->second->connection != NULL) {
+					client->second->connection->resume();
+					if (client->second->connection->done()) {
+						disconnect_client(client->second);
+						continue;
+					}
+
+					resumed = client->second->connection->reading();
+				}
+			}
+
+			if (resumed || (events[i].events & (EPOLLIN | EPOLLRDHUP | EPOLLHUP | EPOLLERR))) {
+				serve_client(client->second);
+			}
+
+			/**
+			 *	- serve_client may have disconnected the client
+			 */
+			client = clients.find(events[i].data.fd);
+			if (client != clients.end()) {
+				update_deadline(client->second);
+			}
+		}
+
+		expire_clients();
+	}
+}
+
+void SocketServer::accept_clients() {
+	int return_code;
+	SocketClient* source;
+	epoll_event event;
+
+	while (1) {
+		source = new SocketClient();
+		return_code = accept_client(source);
+
+		if (return_code != EXIT_SUCCESS) {
+			delete source;
+
+			if (errno == EINTR || errno == ECONNABORTED) {
+				continue;
+			}
+			else if (errno != EAGAIN && errno != EWOULDBLOCK) {
+				std::cerr << "FAILURE: Found a client but could not accept connection" << std::endl;
+			}
+
+			return;
+		}
+
+		return_code = identify_client(source);
+		if (return_code != EXIT_SUCCESS) {
+			source->close_file_descriptor();
+			delete source;
+			continue;
+		}
+
+		if (tune_client_socket(source) != EXIT_SUCCESS) {
+			std::cerr << "FAILURE: Could not set keepalive on client" << std::endl;
+		}
+
+		/**
+		 *	- Edge-triggered for both directions: EPOLLIN once new data
+		 *	  arrives, EPOLLOUT once a full socket has room again
+		 */
+		event.events = EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLET;
+		event.data.fd = source->file_descriptor;
+		return_code = epoll_ctl(epoll_file_descriptor, EPOLL_CTL_ADD, source->file_descriptor, &event);
+
+		if (return_code < EXIT_SUCCESS) {
+			std::cerr << "FAILURE: Could not watch client for events" << std::endl;
+			source->close_file_descriptor();
+			delete source;
+			continue;
+		}
+
+		source->id = next_client_id++;
+		source->input.set_framing(framing, MAX_REQUEST_SIZE);
+		source->output.set_framing(framing);
+		clients[source->file_descriptor] = source;
+		update_deadline(source);
+
+		/**
+		 *	- The coroutine runs up to its first read_frame right away
+		 *	  and is resumed by serve_client from then on
+		 */
+		if (use_coroutines) {
+			source->connection = new Connection(this, source);
+			source->connection->start(serve_connection(source->connection));
+			if (source->connection->done()) {
+				disconnect_client(source);
+			}
+		}
+	}
+}
+
+int SocketServer::identify_client(SocketClient* source) {
+	int return_code;
+
+	std::cout << "Server has accepted a client connection!" << std::endl;
 
 	/**
-	 *	Validate that Request, Command, and Date nodes exist
+	 *	- Grab the hostname + port number the client is connecting from if
+	 *	  the resolver has its hostname cached. Otherwise use its IP
+	 *	  address: the resolver looks the hostname up in the background
+	 *	  for later clients from the same IP address
 	 */
-	if (request.child("Request") == NULL
-		|| request.child("Request").child("Command") == NULL
-		|| request.child("Request").child("Data") == NULL) {
-		request_validated = false;
-		return;
+	if (resolver != NULL) {
+		return_code = resolver->lookup(&source->socket_address, source->host_name, NI_MAXHOST);
+		if (return_code == EXIT_SUCCESS) {
+			std::cout << "Established TCP socket connection to client " << source->get_host_name() << ":" << source->get_sin_port() << std::endl;
+			return EXIT_SUCCESS;
+		}
+	}
+
+	return_code = source->set_ipv4_info();
+
+	if (return_code != EXIT_SUCCESS) {
+		std::cerr << "FAILURE: Could not establish TCP socket connection to client" << std::endl;
+		return EXIT_FAILURE;
+	}
+	else {
+		std::cout << "Established TCP socket connection to client " << source->get_host_name() << ":" << source->get_sin_port() << std::endl;
 	}
 
+	return EXIT_SUCCESS;
+}
+
+int SocketServer::tune_client_socket(SocketClient* source) {
+	int return_value;
+
 	/**
-	 *	Validate that Request, Command, and Date nodes have no attributes
+	 *	- Keepalive catches peers that vanished without closing, which
+	 *	  the idle timeout would otherwise only catch much later
 	 */
-	if (request.child("Request").first_attribute() != NULL
-		|| request.child("Request").child("Command").first_attribute() != NULL
-		|| request.child("Request").child("Data").first_attribute() != NULL) {
-		request_validated = false;
+	if (keepalive_idle <= 0) {
+		return EXIT_SUCCESS;
+	}
+
+	return_value = 1;
+	if (setsockopt(source->file_descriptor, SOL_SOCKET, SO_KEEPALIVE, &return_value, sizeof(return_value)) < EXIT_SUCCESS
+		|| setsockopt(source->file_descriptor, IPPROTO_TCP, TCP_KEEPIDLE, &keepalive_idle, sizeof(keepalive_idle)) < EXIT_SUCCESS
+		|| (keepalive_interval > 0 && setsockopt(source->file_descriptor, IPPROTO_TCP, TCP_KEEPINTVL, &keepalive_interval, sizeof(keepalive_interval)) < EXIT_SUCCESS)
+		|| (keepalive_count > 0 && setsockopt(source->file_descriptor, IPPROTO_TCP, TCP_KEEPCNT, &keepalive_count, sizeof(keepalive_count)) < EXIT_SUCCESS)) {
+		return EXIT_FAILURE;
+	}
+
+	return EXIT_SUCCESS;
+}
+
+void SocketServer::update_deadline(SocketClient* source) {
+	std::chrono::steady_clock::time_point now;
+	std::chrono::steady_clock::time_point deadline;
+	bool armed;
+
+	if (source->closing) {
 		return;
 	}
 
+	now = std::chrono::steady_clock::now();
+	armed = false;
+
+	if (idle_timeout.count() > 0) {
+		deadline = source->last_activity + idle_timeout;
+		armed = true;
+	}
+
 	/**
-	 *	Validate that a Row node exists with attribute Type, value CardNumber
-	 *	Validate that a Row node exists with attribute Type, value PIN
+	 *	- A request deadline starts with the first bytes of each request,
+	 *	  so trickling a request in byte by byte does not keep it alive
 	 */
-	if (request.child("Request").child("Data").find_child_by_attribute("Row", "Type", "CardNumber") == NULL
-		|| request.child("Request").child("Data").find_child_by_attribute("Row", "Type", "PIN") == NULL) {
-		request_validated = false;
-		return;
+	if (source->input.get_length() > 0) {
+		if (!source->request_pending || source->request_frames != source->input.get_frames()) {
+			source->request_pending = true;
+			source->request_frames = source->input.get_frames();
+			source->request_started = now;
+		}
+
+		if (request_timeout.count() > 0 && (!armed || source->request_started + request_timeout < deadline)) {
+			deadline = source->request_started + request_timeout;
+			armed = true;
+		}
+	}
+	else {
+		source->request_pending = false;
+	}
+
+	/**
+	 *	- A write deadline starts once responses are left waiting, and
+	 *	  only ends once the client has read all of them
+	 */
+	if (!source->output.empty()) {
+		if (!source->write_pending) {
+			source->write_pending = true;
+			source->write_started = now;
+		}
+
+		if (write_timeout.count() > 0 && (!armed || source->write_started + write_timeout < deadline)) {
+			deadline = source->write_started + write_timeout;
+			armed = true;
+		}
 	}
+	else {
+		source->write_pending = false;
+	}
+
+	if (armed) {
+		timers.schedule(&source->timer, deadline);
+	}
+	else {
+		timers.cancel(&source->timer);
+	}
+}
+
+void SocketServer::expire_clients() {
+	std::vector<void*> expired;
 
+	timers.advance(std::chrono::steady_clock::now(), &expired);
+
+	for (void* owner : expired) {
+		std::cout << "Client timed out! Closing client file descriptor..." << std::endl;
+		disconnect_client((SocketClient*)owner);
+	}
+}
+
+void SocketServer::serve_client(SocketClient* source) {
 	/**
-	 *	Validate that each Row node has exactly 1 attribute named Type
+	 *	- The client socket is edge-triggered, so keep receiving until
+	 *	  recv reports there is nothing left to read
+	 *	- If client has hung up or the connection failed then disconnect it.
+	 *	  Otherwise, server will validate and process each request and then
+	 *	  send the response to the client
+	 *	- Stop receiving while the client's coroutine waits for it to take
+	 *	  its responses. Its input stays bounded by the socket buffers,
+	 *	  and the event loop reads on once the coroutine carries on
 	 */
-	for (pugi::xml_node node = request.child("Request").child("Data").first_child(); node; node = node.next_sibling()) {
-		attributes = 0;
-		for (pugi::xml_attribute attribute = node.first_attribute(); attribute; attribute = attribute.next_attribute(), attributes++) {
-			if (attributes > 0 || (std::string)attribute.name() != "Type") {
-				request_validated = false;
+	while (1) {
+		if (source->connection != NULL && !source->connection->reading()) {
+			return;
+		}
+
+		receive_request_from_client(source);
+
+		if (bytes_received < EXIT_SUCCESS) {
+			if (errno == EINTR) {
+				continue;
+			}
+			else if (errno == EAGAIN || errno == EWOULDBLOCK) {
 				return;
 			}
+
+			std::cerr << "FAILURE: Error receiving request from client" << std::endl;
+			disconnect_client(source);
+			return;
+		}
+		else if (bytes_received == EXIT_SUCCESS) {
+			std::cout << "Connection to client lost! Closing client file descriptor..." << std::endl;
+			disconnect_client(source);
+			return;
+		}
+
+		source->last_activity = std::chrono::steady_clock::now();
+
+		if (source->connection != NULL) {
+			source->connection->resume();
+			if (source->connection->done()) {
+				disconnect_client(source);
+				return;
+			}
+		}
+		else if (process_frames(source) != EXIT_SUCCESS) {
+			disconnect_client(source);
+			return;
 		}
 	}
-	
+}
+
+Connection::Task SocketServer::serve_connection(Connection* connection) {
+	char* frame;
+	size_t length;
+	std::string response;
+
 	/**
-	 *	Validate Request is the only node at its level
+	 *	- Reads as if blocking, but each co_await hands the thread back
+	 *	  to the event loop until the client socket is ready
+	 *	- read_frame sends the responses to every request handled so far
+	 *	  before waiting for more, so pipelined requests are still
+	 *	  answered in batches
 	 */
-	for (pugi::xml_node node = request.first_child(); node; node = node.next_sibling()) {
-		if ((std::string)node.name() != "Request") {
-			request_validated = false;
-			return;
+	while (co_await connection->read_frame(&frame, &length) == EXIT_SUCCESS) {
+		handle_request(&context, frame, length, &response);
+
+		std::cout << "Sending response to client..." << std::endl;
+		if (co_await connection->write(&response) != EXIT_SUCCESS) {
+			break;
 		}
 	}
+}
+
+int SocketServer::process_frames(SocketClient* source) {
+	char* frame;
+	size_t length;
+	FrameStatus status;
 
 	/**
-	 *	Validate Command + Data are the only nodes at their level
+	 *	- Handle every complete request buffered for the client, in order.
+	 *	  Each request is handed out in place from the client's buffer
+	 *	- A request that outgrows MAX_REQUEST_SIZE can never complete, so
+	 *	  the client is disconnected. So is one that cannot be an XML
+	 *	  document with FRAMING_DOCUMENT, as there is no telling where
+	 *	  the next request would start
 	 */
-	for (pugi::xml_node node = request.child("Request").first_child(); node; node = node.next_sibling()) {
-		if ((std::string)node.name() != "Command"
-			&& (std::string)node.name() != "Data") {
-			request_validated = false;
-			return;
+	while ((status = source->input.next_frame(&frame, &length)) == FRAME_COMPLETE) {
+		dispatch_request(source, frame, length);
+	}
+
+	/**
+	 *	- Responses to pipelined requests are only queued while handling
+	 *	  them, so the whole batch goes out together in as few sends as
+	 *	  the client socket allows
+	 */
+	if (flush_response_to_client(source) != EXIT_SUCCESS) {
+		std::cerr << "FAILURE: Error sending response to client" << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	if (status == FRAME_TOO_LARGE) {
+		std::cerr << "FAILURE: Request from client exceeds " << MAX_REQUEST_SIZE << " bytes" << std::endl;
+		return EXIT_FAILURE;
+	}
+	else if (status == FRAME_INVALID) {
+		std::cerr << "FAILURE: Request from client is not an XML document" << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	return EXIT_SUCCESS;
+}
+
+void SocketServer::dispatch_request(SocketClient* source, char* data, size_t size) {
+	Job* job;
+	std::string response;
+	std::string* busy;
+
+	/**
+	 *	- Every response is built in a spare buffer of the client's
+	 *	  output queue, if it has one, so it is serialized once into
+	 *	  memory that is already allocated
+	 *	- Without a worker pool, handle the request on this thread and
+	 *	  queue the response right away
+	 *	- Otherwise copy the request into a job and hand it to a worker.
+	 *	  The response comes back through complete_job, tagged with the
+	 *	  client's sequence number so responses stay in request order
+	 */
+	if (workers == NULL) {
+		source->output.reuse(&response);
+		handle_request(&context, data, size, &response);
+
+		std::cout << "Sending response to client..." << std::endl;
+		send_response_to_client(source, &response);
+		return;
+	}
+
+	job = new Job();
+	job->server = this;
+	job->file_descriptor = source->file_descriptor;
+	job->client_id = source->id;
+	job->sequence = source->next_sequence++;
+	job->request.assign(data, size);
+	source->output.reuse(&job->response);
+
+	if (workers->submit(job) == EXIT_SUCCESS) {
+		return;
+	}
+
+	/**
+	 *	- The workers are over their admission limits, so answer with the
+	 *	  Busy response right away, in its place among the responses
+	 */
+	std::cout << "Server is busy! Turning request from client away..." << std::endl;
+	busy = &source->finished_responses[job->sequence];
+	source->output.reuse(busy);
+	busy->assign(BUSY_RESPONSE.view());
+	delete job;
+
+	send_finished_responses(source);
+}
+
+void SocketServer::send_finished_responses(SocketClient* source) {
+	std::map<unsigned long long, std::string>::iterator next;
+
+	next = source->finished_responses.find(source->next_response);
+	while (next != source->finished_responses.end()) {
+		std::cout << "Sending response to client..." << std::endl;
+		send_response_to_client(source, &next->second);
+		source->finished_responses.erase(next);
+		next = source->finished_responses.find(++source->next_response);
+	}
+}
+
+void SocketServer::handle_request(RequestContext* context, char* data, size_t size, std::string* response) {
+	bool parsed;
+
+	/**
+	 *	- Print the request as received. This has to come first, since
+	 *	  parsing in place writes into data
+	 *	- Parse the request in place: names and values in the request
+	 *	  document point straight into data, so the request bytes are not
+	 *	  copied again after being received. The document keeps its
+	 *	  memory pages between requests, so parsing allocates nothing
+	 *	  once the pages of the largest request so far are in place
+	 *	- Validate and process it, and then serialize the response. A
+	 *	  request that is not well-formed is invalid, however much of
+	 *	  the document was built before the error
+	 *	- With the streaming parser, validate the request as it is
+	 *	  parsed, without a request document
+	 *	- Only context is touched, so worker threads may run this
+	 *	  concurrently as long as each uses its own context
+	 */
+	std::cout << "Received XML Request: " << std::endl;
+	std::cout << std::endl << std::string_view(data, size) << std::endl << std::endl;
+
+	if (use_streaming_parser) {
+		std::cout << "Validating request from client..." << std::endl;
+		context->request_validated = context->reader.read(data, size, &context->command, context->values);
+	}
+	else {
+		parsed = context->request.load_buffer_inplace(data, size);
+
+		std::cout << "Validating request from client..." << std::endl;
+		if (parsed) {
+			validate_request(context);
+		}
+		else {
+			context->request_validated = false;
 		}
 	}
-	
+
+	std::cout << "Processing request from client..." << std::endl;
+	process_request(context, response);
+}
+
+void SocketServer::complete_job(Job* job) {
+	bool was_empty;
+
 	/**
-	 *	Validate Command node has exactly 1 text field and no child nodes
+	 *	- Invoked on a worker thread. Queue the finished job for the event
+	 *	  loop and wake it up, unless it has already been woken up for an
+	 *	  earlier job it has not collected yet
 	 */
-	children = 0;
-	for (pugi::xml_node node = request.child("Request").child("Command").first_child(); node; node = node.next_sibling(), children++) {
-		if (children > 0 || node.type() != pugi::node_pcdata) {
-			request_validated = false;
-			return;
+	completed_jobs_mutex.lock();
+	was_empty = completed_jobs.empty();
+	completed_jobs.push_back(job);
+	completed_jobs_mutex.unlock();
+
+	if (was_empty) {
+		eventfd_write(completion_file_descriptor, 1);
+	}
+}
+
+void SocketServer::collect_completed_jobs() {
+	eventfd_t value;
+	std::vector<Job*> jobs;
+	std::vector<std::pair<int, unsigned long long> > ready_clients;
+	std::unordered_map<int, SocketClient*>::iterator client;
+	SocketClient* source;
+
+	eventfd_read(completion_file_descriptor, &value);
+
+	completed_jobs_mutex.lock();
+	jobs.swap(completed_jobs);
+	completed_jobs_mutex.unlock();
+
+	for (Job* job : jobs) {
+		/**
+		 *	- Drop the response if its client has disconnected in the
+		 *	  meantime (its file descriptor may already be reused)
+		 *	- Responses finished out of order wait until every earlier
+		 *	  response for the same client has been sent
+		 */
+		client = clients.find(job->file_descriptor);
+		if (client == clients.end() || client->second->id != job->client_id || client->second->closing) {
+			delete job;
+			continue;
+		}
+
+		source = client->second;
+		source->finished_responses[job->sequence].swap(job->response);
+		delete job;
+
+		if (source->finished_responses.count(source->next_response) > 0) {
+			ready_clients.emplace_back(source->file_descriptor, source->id);
+			send_finished_responses(source);
 		}
 	}
 
 	/**
-	 *	Validate Data node has exactly 0 text fields and 2 child nodes
+	 *	- Flush each client once for the whole batch of collected jobs,
+	 *	  so its queued responses go out together
 	 */
-	children = 0;
-	for (pugi::xml_node node = request.child("Request").child("Data").first_child(); node; node = node.next_sibling(), children++) {
-		if (children > 1 || node.type() == pugi::node_pcdata) {
-			request_validated = false;
-			return;
+	for (std::pair<int, unsigned long long>& ready : ready_clients) {
+		client = clients.find(ready.first);
+		if (client == clients.end() || client->second->id != ready.second || client->second->closing) {
+			continue;
+		}
+
+		if (flush_response_to_client(client->second) != EXIT_SUCCESS) {
+			std::cerr << "FAILURE: Error sending response to client" << std::endl;
+			disconnect_client(client->second);
+			continue;
+		}
+
+		update_deadline(client->second);
+	}
+}
+
+int SocketServer::create_uring_loop() {
+	int return_value;
+
+	ring = new IoUring();
+
+	return_value = ring->setup(URING_ENTRIES);
+
+	if (return_value != EXIT_SUCCESS) {
+		return EXIT_FAILURE;
+	}
+
+	/**
+	 *	- Multishot recv picks a buffer from this group for every
+	 *	  completion, so no buffer is tied up by idle clients
+	 */
+	return_value = ring->register_buffer_ring(URING_BUFFER_GROUP, URING_BUFFERS, BUF_SIZE);
+
+	if (return_value != EXIT_SUCCESS) {
+		return EXIT_FAILURE;
+	}
+
+	return_value = eventfd(0, EFD_NONBLOCK);
+
+	if (return_value < EXIT_SUCCESS) {
+		return EXIT_FAILURE;
+	}
+
+	completion_file_descriptor = return_value;
+
+	queue_accept();
+	queue_completion_poll();
+
+	if (idle_timeout.count() > 0 || request_timeout.count() > 0 || write_timeout.count() > 0) {
+		queue_timeout();
+	}
+
+	return EXIT_SUCCESS;
+}
+
+int SocketServer::run_uring_loop() {
+	int return_value;
+	io_uring_cqe* cqe;
+	unsigned long long user_data;
+	int result;
+	unsigned flags;
+
+	while (1) {
+		/**
+		 *	- Submit everything queued while handling the last batch of
+		 *	  completions and wait for the next one, in one system call
+		 */
+		return_value = ring->submit_and_wait(1);
+
+		if (return_value < EXIT_SUCCESS && errno != EINTR && errno != EAGAIN && errno != EBUSY) {
+			return EXIT_FAILURE;
+		}
+
+		while ((cqe = ring->peek_cqe()) != NULL) {
+			user_data = cqe->user_data;
+			result = cqe->res;
+			flags = cqe->flags;
+			ring->cqe_seen();
+
+			switch (user_data >> URING_OPERATION_SHIFT) {
+			case URING_ACCEPT:
+				complete_accept(result, flags);
+				break;
+			case URING_RECV:
+				complete_recv((int)(user_data & URING_FILE_DESCRIPTOR_MASK), result, flags);
+				break;
+			case URING_SEND:
+				complete_send((int)(user_data & URING_FILE_DESCRIPTOR_MASK), result);
+				break;
+			case URING_COMPLETION_POLL:
+				collect_completed_jobs();
+				if (!(flags & IORING_CQE_F_MORE)) {
+					queue_completion_poll();
+				}
+				break;
+			case URING_TIMEOUT:
+				expire_clients();
+				queue_timeout();
+				break;
+			}
 		}
 	}
+}
+
+void SocketServer::queue_accept() {
+	io_uring_sqe* sqe;
+
+	/**
+	 *	- Multishot accept stays armed and posts one completion per
+	 *	  accepted client
+	 */
+	sqe = ring->get_sqe();
+	if (sqe == NULL) {
+		std::cerr << "FAILURE: Submission queue is full" << std::endl;
+		return;
+	}
+
+	sqe->opcode = IORING_OP_ACCEPT;
+	sqe->fd = file_descriptor;
+	sqe->ioprio = IORING_ACCEPT_MULTISHOT;
+	sqe->accept_flags = SOCK_NONBLOCK;
+	sqe->user_data = (unsigned long long)URING_ACCEPT << URING_OPERATION_SHIFT;
+}
+
+void SocketServer::queue_completion_poll() {
+	io_uring_sqe* sqe;
+
+	/**
+	 *	- Multishot poll on the eventfd the workers signal, in place of
+	 *	  registering it with epoll
+	 */
+	sqe = ring->get_sqe();
+	if (sqe == NULL) {
+		std::cerr << "FAILURE: Submission queue is full" << std::endl;
+		return;
+	}
+
+	sqe->opcode = IORING_OP_POLL_ADD;
+	sqe->fd = completion_file_descriptor;
+	sqe->poll32_events = POLLIN;
+	sqe->len = IORING_POLL_ADD_MULTI;
+	sqe->user_data = (unsigned long long)URING_COMPLETION_POLL << URING_OPERATION_SHIFT;
+}
+
+void SocketServer::queue_timeout() {
+	io_uring_sqe* sqe;
 
 	/**
-	 *	Validate Row node with Type=CardNumber attribute has exactly 1 text field and no child nodes
+	 *	- Completes once a tick has passed, to advance the timer wheel
 	 */
-	children = 0;
-	for (pugi::xml_node node = request.child("Request").child("Data").find_child_by_attribute("Row", "Type", "CardNumber").first_child(); node; node = node.next_sibling(), children++) {
-		if (children > 0 || node.type() != pugi::node_pcdata) {
-			request_validated = false;
+	sqe = ring->get_sqe();
+	if (sqe == NULL) {
+		std::cerr << "FAILURE: Submission queue is full" << std::endl;
+		return;
+	}
+
+	sqe->opcode = IORING_OP_TIMEOUT;
+	sqe->fd = -1;
+	sqe->addr = (unsigned long)&timeout_interval;
+	sqe->len = 1;
+	sqe->user_data = (unsigned long long)URING_TIMEOUT << URING_OPERATION_SHIFT;
+}
+
+void SocketServer::queue_recv(SocketClient* source) {
+	io_uring_sqe* sqe;
+
+	/**
+	 *	- Multishot recv stays armed and posts one completion per chunk
+	 *	  of data, each in a buffer the kernel picks from the buffer ring
+	 */
+	sqe = ring->get_sqe();
+	if (sqe == NULL) {
+		std::cerr << "FAILURE: Submission queue is full" << std::endl;
+		disconnect_client(source);
+		return;
+	}
+
+	sqe->opcode = IORING_OP_RECV;
+	sqe->fd = source->file_descriptor;
+	sqe->ioprio = IORING_RECV_MULTISHOT;
+	sqe->flags = IOSQE_BUFFER_SELECT;
+	sqe->buf_group = URING_BUFFER_GROUP;
+	sqe->user_data = ((unsigned long long)URING_RECV << URING_OPERATION_SHIFT) | (unsigned)source->file_descriptor;
+	source->pending_operations++;
+}
+
+void SocketServer::queue_send(SocketClient* source) {
+	io_uring_sqe* sqe;
+	msghdr* message;
+	bool more;
+
+	/**
+	 *	- Only one send per client is in flight at a time. Responses
+	 *	  queued meanwhile collect in output and go out together next
+	 *	- Every pending response is gathered into a single sendmsg. The
+	 *	  gathered bytes are not moved or dropped until the send completes
+	 */
+	if (source->send_in_flight || source->closing || source->output.empty()) {
+		return;
+	}
+
+	sqe = ring->get_sqe();
+	if (sqe == NULL) {
+		std::cerr << "FAILURE: Submission queue is full" << std::endl;
+		disconnect_client(source);
+		return;
+	}
+
+	message = source->output.gather(&more);
+
+	sqe->opcode = IORING_OP_SENDMSG;
+	sqe->fd = source->file_descriptor;
+	sqe->addr = (unsigned long)message;
+	sqe->len = 1;
+	sqe->msg_flags = MSG_NOSIGNAL | (more ? MSG_MORE : 0);
+	sqe->user_data = ((unsigned long long)URING_SEND << URING_OPERATION_SHIFT) | (unsigned)source->file_descriptor;
+	source->send_in_flight = true;
+	source->pending_operations++;
+}
+
+void SocketServer::complete_accept(int result, unsigned flags) {
+	SocketClient* source;
+
+	if (!(flags & IORING_CQE_F_MORE)) {
+		queue_accept();
+	}
+
+	if (result < EXIT_SUCCESS) {
+		std::cerr << "FAILURE: Found a client but could not accept connection" << std::endl;
+		return;
+	}
+
+	source = new SocketClient();
+	source->file_descriptor = result;
+	getpeername(source->file_descriptor, (sockaddr*)(&source->socket_address), &source->socket_address_length);
+
+	if (identify_client(source) != EXIT_SUCCESS) {
+		source->close_file_descriptor();
+		delete source;
+		return;
+	}
+
+	if (tune_client_socket(source) != EXIT_SUCCESS) {
+		std::cerr << "FAILURE: Could not set keepalive on client" << std::endl;
+	}
+
+	source->id = next_client_id++;
+	source->input.set_framing(framing, MAX_REQUEST_SIZE);
+	source->output.set_framing(framing);
+	clients[source->file_descriptor] = source;
+	update_deadline(source);
+	queue_recv(source);
+}
+
+void SocketServer::complete_recv(int client_file_descriptor, int result, unsigned flags) {
+	std::unordered_map<int, SocketClient*>::iterator client;
+	SocketClient* source;
+	unsigned short buffer_id;
+
+	client = clients.find(client_file_descriptor);
+	if (client == clients.end()) {
+		return;
+	}
+
+	source = client->second;
+	if (!(flags & IORING_CQE_F_MORE)) {
+		source->pending_operations--;
+	}
+
+	/**
+	 *	- Add the data to the client's buffer, give the provided buffer
+	 *	  straight back to the kernel, and handle every complete request
+	 *	- Ran out of provided buffers: simply re-arm once some are back
+	 *	- A result of 0 means the client has hung up
+	 */
+	if (result > 0) {
+		buffer_id = flags >> IORING_CQE_BUFFER_SHIFT;
+		if (!source->closing && source->input.append(ring->get_buffer(buffer_id), result) != EXIT_SUCCESS) {
+			std::cerr << "FAILURE: Error receiving request from client" << std::endl;
+			ring->recycle_buffer(buffer_id);
+			disconnect_client(source);
 			return;
 		}
+		ring->recycle_buffer(buffer_id);
+		source->last_activity = std::chrono::steady_clock::now();
+
+		if (!source->closing && process_frames(source) != EXIT_SUCCESS) {
+			disconnect_client(source);
+			return;
+		}
+	}
+	else if (result == EXIT_SUCCESS) {
+		if (!source->closing) {
+			std::cout << "Connection to client lost! Closing client file descriptor..." << std::endl;
+		}
+		disconnect_client(source);
+		return;
+	}
+	else if (result != -ENOBUFS) {
+		if (!source->closing) {
+			std::cerr << "FAILURE: Error receiving request from client" << std::endl;
+		}
+		disconnect_client(source);
+		return;
+	}
+
+	if (source->closing) {
+		disconnect_client(source);
+		return;
+	}
+
+	update_deadline(source);
+
+	if (!(flags & IORING_CQE_F_MORE)) {
+		queue_recv(source);
+	}
+}
+
+void SocketServer::complete_send(int client_file_descriptor, int result) {
+	std::unordered_map<int, SocketClient*>::iterator client;
+	SocketClient* source;
+
+	client = clients.find(client_file_descriptor);
+	if (client == clients.end()) {
+		return;
+	}
+
+	source = client->second;
+	source->pending_operations--;
+	source->send_in_flight = false;
+
+	if (result < EXIT_SUCCESS || source->closing) {
+		if (!source->closing) {
+			std::cerr << "FAILURE: Error sending response to client" << std::endl;
+		}
+		disconnect_client(source);
+		return;
 	}
 
+	source->output.consume(result);
+	update_deadline(source);
+	queue_send(source);
+}
+
+int SocketServer::flush_response_to_client(SocketClient* source) {
+	int return_value;
+	msghdr* message;
+	bool more;
+
+	/**
+	 *	- With io_uring the send is only queued here. It is submitted
+	 *	  along with everything else at the top of the event loop
+	 */
+	if (ring != NULL) {
+		bytes_sent = 0;
+		queue_send(source);
+		return EXIT_SUCCESS;
+	}
+
+	/**
+	 *	- Gather every pending response into one sendmsg. MSG_MORE (like
+	 *	  TCP_CORK) while there are more responses than fit in one gather,
+	 *	  so the kernel packs them into full segments
+	 *	- MSG_NOSIGNAL so a client that hung up mid-response is reported
+	 *	  as an error instead of raising SIGPIPE
+	 *	- Stop once the client socket is full. The remainder is sent when
+	 *	  epoll reports EPOLLOUT
+	 */
+	bytes_sent = 0;
+	while (!source->output.empty()) {
+		message = source->output.gather(&more);
+		return_value = sendmsg(source->file_descriptor, message, MSG_NOSIGNAL | (more ? MSG_MORE : 0));
+
+		if (return_value < EXIT_SUCCESS) {
+			if (errno == EINTR) {
+				continue;
+			}
+			else if (errno == EAGAIN || errno == EWOULDBLOCK) {
+				return EXIT_SUCCESS;
+			}
+
+			bytes_sent = return_value;
+			return EXIT_FAILURE;
+		}
+
+		source->output.consume(return_value);
+		bytes_sent += return_value;
+	}
+
+	return EXIT_SUCCESS;
+}
+
+void SocketServer::disconnect_client(SocketClient* source) {
 	/**
-	 *	Validate Row node with Type=PIN attribute has exactly 1 text field and no child nodes
+	 *	- With io_uring, operations still in flight may point at the
+	 *	  client's buffers. Shut the socket down so they complete, and
+	 *	  only close and forget the client once the last one has
+	 *	- Closing the file descriptor also removes it from the epoll instance
 	 */
-	children = 0;
-	for (pugi::xml_node node = request.child("Request").child("Data").find_child_by_attribute("Row", "Type", "PIN").first_child(); node; node = node.next_sibling(), children++) {
-		if (children > 0 || node.type() != pugi::node_pcdata) {
-			request_validated = false;
+	timers.cancel(&source->timer);
+
+	if (ring != NULL) {
+		if (!source->closing) {
+			source->closing = true;
+			shutdown(source->file_descriptor, SHUT_RDWR);
+		}
+
+		if (source->pending_operations > 0) {
 			return;
 		}
 	}
 
+	if (source->close_file_descriptor() != EXIT_SUCCESS) {
+		std::cerr << "FAILURE: Could not close the client file descriptor" << std::endl;
+	}
+
+	clients.erase(source->file_descriptor);
+	delete source->connection;
+	delete source;
+}
+
+void SocketServer::receive_request_from_client(SocketClient* source) {
+	/**
+	 *	- Receive whatever data the client has sent so far straight into
+	 *	  the client's buffer, after any incomplete request already in it.
+	 *	  The client socket is non-blocking, so this returns -1 with errno
+	 *	  EAGAIN if there is none
+	 */
+	char* destination;
+
+	destination = source->input.reserve(BUF_SIZE);
+	if (destination == NULL) {
+		errno = ENOMEM;
+		bytes_received = -1;
+		return;
+	}
+
+	bytes_received = recv(source->file_descriptor, destination, BUF_SIZE, 0);
+
+	if (bytes_received > 0) {
+		source->input.commit(bytes_received);
+	}
 }
 
-void SocketServer::process_request() {
+void SocketServer::validate_request(RequestContext* context) {
+	/**
+	 *	- Check the whole request in one pass against the schema of its
+	 *	  command (see RequestSchema.cpp), keeping the text of its Rows
+	 *	  on the way so the request is not walked again
+	 */
+	context->request_validated = RequestSchema::validate(context->request, &context->command, context->values);
+}
+
+void SocketServer::process_request(RequestContext* context, std::string* response) {
 	/**
-	 *	- Clear the response XML tree
 	 *	- If request is not validated then construct the response for bad XML format
-	 *	- Otherwise, parse the command from the request and route to the
-	 *	  respective method to construct the correct response
+	 *	- Otherwise, route the command validate_request found to the
+	 *	  method registered for it in COMMANDS (see RequestSchema.cpp)
+	 *	  and count it
+	 *	- Each method appends its serialized response to response
 	 */
-	response.reset();
-	if (request_validated) {
-		if ((std::string)request.child("Request").child("Command").child_value() == "GetPlayerInfo") {
-			command_getplayerinfo();
+	if (context->request_validated) {
+		if (context->command != NULL) {
+			std::cout << "Processing " << context->command->command << " request #" << RequestSchema::count_command(context->command) << "..." << std::endl;
+			(this->*context->command->handler)(context, response);
 		}
 		else {
-			command_unknown();
+			command_unknown(response);
 		}
 	}
 	else {
-		request_not_valid();
+		request_not_valid(response);
 	}
 }
 
-void SocketServer::send_response_to_client(SocketClient* source) {
+void SocketServer::send_response_to_client(SocketClient* source, std::string* response) {
 	/**
-	 *	- Send the response to the client and if successful, have the server
-	 *	  print the response
+	 *	- Have the server print the response, then queue it behind anything
+	 *	  still pending for the client. It is sent by the next
+	 *	  flush_response_to_client, along with the rest of its batch
 	 */
-	bytes_sent = send(source->file_descriptor, get_printable_xml(&response).c_str(), get_printable_xml(&response).length() + 1, 0);
+	std::cout << std::endl << "Sending XML Response:" << std::endl;
+	std::cout << std::endl << *response << std::endl << std::endl;
 
-	if (bytes_sent > 0) {
-		std::cout << std::endl << "Sent XML Response:" << std::endl;
-		std::cout << std::endl << get_printable_xml(&response) << std::endl << std::endl;
-	}
+	source->output.push(response);
 }
 
 std::string SocketServer::get_printable_xml(pugi::xml_document* xml) {
@@ -359,71 +1488,65 @@ std::string SocketServer::get_printable_xml(pugi::xml_document* xml) {
 	return writer.result;
 }
 
-void SocketServer::command_getplayerinfo() {
+void SocketServer::build_templates() {
 	/**
-	 *	- Used to hold the Row node that was just appended to the response
+	 *	- Used to build each skeleton once, with a slot marker wherever the
+	 *	  response varies
 	 */
+	pugi::xml_document skeleton;
+	pugi::xml_node data;
 	pugi::xml_node row;
 
 	/**
-	 *	- Clear the response XML tree
-	 *	- Create root node as Response
-	 *	- Build out Command node and set the text field to the method name
-	 *	- Build out Status node but don't set the text field until data is verified
-	 *	  against test player
+	 *	- GetPlayerInfo success: a slot for each demographic Row, in the
+	 *	  order of PLAYER_INFO_ROWS
+	 */
+	skeleton.append_child("Response");
+	skeleton.child("Response").append_child("Command").append_child(pugi::node_pcdata).set_value("GetPlayerInfo");
+	skeleton.child("Response").append_child("Status").append_child(pugi::node_pcdata).set_value("Success");
+	data = skeleton.child("Response").append_child("Data");
+	for (const char* type : PLAYER_INFO_ROWS) {
+		row = data.append_child("Row");
+		row.append_attribute("Type") = type;
+		row.append_child(pugi::node_pcdata).set_value(ResponseTemplate::SLOT_MARKER);
+	}
+	getplayerinfo_success.compile(get_printable_xml(&skeleton));
+
+}
+
+void SocketServer::command_getplayerinfo(RequestContext* context, std::string* response) {
+	/**
+	 *	- The card number and PIN validate_request extracted, as views
+	 *	  into the request buffer
 	 */
-	response.reset();
-	response.append_child("Response");
-	response.child("Response").append_child("Command");
-	response.child("Response").child("Command").append_child(pugi::node_pcdata).set_value("GetPlayerInfo");
-	response.child("Response").append_child("Status");
+	GetPlayerInfoRequest request = RequestSchema::get_player_info(context->values);
 
 	/**
-	 *	- Used to hold the Row node that was just appended to the response
+	 *	- Used to hold the values of the slots of the response template
 	 */
-	std::string card_number = request.child("Request").child("Data").find_child_by_attribute("Row", "Type", "CardNumber").child_value();
-	std::string pin = request.child("Request").child("Data").find_child_by_attribute("Row", "Type", "PIN").child_value();
+	std::string_view values[sizeof(PLAYER_INFO_ROWS) / sizeof(PLAYER_INFO_ROWS[0])];
 
 	/**
 	 *	- Verify valid card number + valid PIN
-	 *	- If valid, construct the response based on test player
-	 */
-	if (card_number == TEST_CARD_NUMBER) {
-		if (pin == TEST_CARD_PIN) {
-			response.child("Response").child("Status").append_child(pugi::node_pcdata).set_value("Success");
-			response.child("Response").append_child("Data");
-			row = response.child("Response").child("Data").append_child("Row");
-			row.append_attribute("Type") = "CardNumber";
-			row = response.child("Response").child("Data").append_child("Row");
-			row.append_attribute("Type") = "FirstName";
-			row = response.child("Response").child("Data").append_child("Row");
-			row.append_attribute("Type") = "LastName";
-			row = response.child("Response").child("Data").append_child("Row");
-			row.append_attribute("Type") = "Address";
-			row = response.child("Response").child("Data").append_child("Row");
-			row.append_attribute("Type") = "City";
-			row = response.child("Response").child("Data").append_child("Row");
-			row.append_attribute("Type") = "State";
-			row = response.child("Response").child("Data").append_child("Row");
-			row.append_attribute("Type") = "ZipCode";
-			response.child("Response").child("Data").find_child_by_attribute("Row", "Type", "CardNumber").append_child(pugi::node_pcdata).set_value(TEST_CARD_NUMBER);
-			response.child("Response").child("Data").find_child_by_attribute("Row", "Type", "FirstName").append_child(pugi::node_pcdata).set_value(TEST_CARD_FIRST_NAME);
-			response.child("Response").child("Data").find_child_by_attribute("Row", "Type", "LastName").append_child(pugi::node_pcdata).set_value(TEST_CARD_LAST_NAME);
-			response.child("Response").child("Data").find_child_by_attribute("Row", "Type", "Address").append_child(pugi::node_pcdata).set_value(TEST_CARD_ADDRESS);
-			response.child("Response").child("Data").find_child_by_attribute("Row", "Type", "City").append_child(pugi::node_pcdata).set_value(TEST_CARD_CITY);
-			response.child("Response").child("Data").find_child_by_attribute("Row", "Type", "State").append_child(pugi::node_pcdata).set_value(TEST_CARD_STATE);
-			response.child("Response").child("Data").find_child_by_attribute("Row", "Type", "ZipCode").append_child(pugi::node_pcdata).set_value(TEST_CARD_ZIP_CODE);
+	 *	- If valid, render the success template with the test player
+	 */
+	if (request.card == TEST_CARD_NUMBER) {
+		if (request.pin == TEST_CARD_PIN) {
+			values[0] = TEST_CARD_NUMBER;
+			values[1] = TEST_CARD_FIRST_NAME;
+			values[2] = TEST_CARD_LAST_NAME;
+			values[3] = TEST_CARD_ADDRESS;
+			values[4] = TEST_CARD_CITY;
+			values[5] = TEST_CARD_STATE;
+			values[6] = TEST_CARD_ZIP_CODE;
+			getplayerinfo_success.render(response, values);
 		}
 
 		/**
 		 *	- Log error message if card number checks out but PIN is invalid
 		 */
 		else {
-			response.child("Response").child("Status").append_child(pugi::node_pcdata).set_value("Fail");
-			response.child("Response").append_child("Data");
-			row = response.child("Response").child("Data").append_child("Row");
-			row.append_attribute("Type") = "ErrorMessage";
-			response.child("Response").child("Data").find_child_by_attribute("Row", "Type", "ErrorMessage").append_child(pugi::node_pcdata).set_value("Invalid PIN");
+			response->append(INVALID_PIN_RESPONSE.view());
 		}
 	}
 
@@ -431,63 +1554,20 @@ void SocketServer::command_getplayerinfo() {
 	 *	- Log error message if card number does not check out
 	 */
 	else {
-		response.child("Response").child("Status").append_child(pugi::node_pcdata).set_value("Fail");
-		response.child("Response").append_child("Data");
-		row = response.child("Response").child("Data").append_child("Row");
-		row.append_attribute("Type") = "ErrorMessage";
-		response.child("Response").child("Data").find_child_by_attribute("Row", "Type", "ErrorMessage").append_child(pugi::node_pcdata).set_value("Invalid Card Number");
-
+		response->append(INVALID_CARD_NUMBER_RESPONSE.view());
 	}
 }
 
-void SocketServer::command_unknown() {
+void SocketServer::command_unknown(std::string* response) {
 	/**
-	 *	- Used to hold the Row node that was just appended to the response
-	 */
-	pugi::xml_node row;
-
-	/**
-	 *	- Clear the response XML tree
-	 *	- Create root node as Response
-	 *	- Build out Command node and set the text field to Unknown
-	 *	- Build out Status node and set the text field to Fail
 	 *	- Log error message for Invalid Command
 	 */
-	response.reset();
-	response.append_child("Response");
-	response.child("Response").append_child("Command");
-	response.child("Response").child("Response").append_child(pugi::node_pcdata).set_value("Unknown");
-	response.child("Response").append_child("Status");
-	response.child("Response").child("Status").append_child(pugi::node_pcdata).set_value("Fail");
-	response.child("Response").append_child("Data");
-	row = response.child("Response").child("Data").append_child("Row");
-	row.append_attribute("Type") = "ErrorMessage";
-	response.child("Response").child("Data").find_child_by_attribute("Row", "Type", "ErrorMessage").append_child(pugi::node_pcdata).set_value("Invalid Command");
-
+	response->append(INVALID_COMMAND_RESPONSE.view());
 }
 
-void SocketServer::request_not_valid() {
+void SocketServer::request_not_valid(std::string* response) {
 	/**
-	 *	- Used to hold the Row node that was just appended to the response
-	 */
-	pugi::xml_node row;
-
-	/**
-	 *	- Clear the response XML tree
-	 *	- Create root node as Response
-	 *	- Build out Command node and set the text field to Unknown
-	 *	- Build out Status node and set the text field to Fail
 	 *	- Log error message for Invalid Request Format
 	 */
-	response.reset();
-	response.append_child("Response");
-	response.child("Response").append_child("Command");
-	response.child("Response").child("Response").append_child(pugi::node_pcdata).set_value("Unknown");
-	response.child("Response").append_child("Status");
-	response.child("Response").child("Status").append_child(pugi::node_pcdata).set_value("Fail");
-	response.child("Response").append_child("Data");
-	row = response.child("Response").child("Data").append_child("Row");
-	row.append_attribute("Type") = "ErrorMessage";
-	response.child("Response").child("Data").find_child_by_attribute("Row", "Type", "ErrorMessage").append_child(pugi::node_pcdata).set_value("Invalid Request Format");
-
+	response->append(INVALID_REQUEST_FORMAT_RESPONSE.view());
 }
@@ -0,0 +1,160 @@
+#include <chrono>
+#include <cstdlib>
+#include <vector>
+
+#include "../include/TimerWheel.h"
+
+TimerWheel::TimerWheel() {
+	for (int level = 0; level < LEVELS; level++) {
+		for (int slot = 0; slot < SLOTS; slot++) {
+			slots[level][slot].prev = &slots[level][slot];
+			slots[level][slot].next = &slots[level][slot];
+			slots[level][slot].owner = NULL;
+		}
+	}
+
+	current_tick = 0;
+	scheduled = 0;
+	start = std::chrono::steady_clock::now();
+}
+
+void TimerWheel::schedule(Timer* timer, std::chrono::steady_clock::time_point deadline) {
+	unsigned long long expiry;
+
+	/**
+	 *	- Round up to a whole tick. The slot of the current tick has
+	 *	  already been expired, so the earliest a timer can expire on is
+	 *	  the next one
+	 */
+	expiry = get_tick(deadline + std::chrono::milliseconds(TICK_MS - 1));
+
+	if (expiry <= current_tick) {
+		expiry = current_tick + 1;
+	}
+	else if (expiry - current_tick >= (1ULL << (SLOT_BITS * LEVELS))) {
+		expiry = current_tick + (1ULL << (SLOT_BITS * LEVELS)) - 1;
+	}
+
+	cancel(timer);
+	timer->expiry = expiry;
+	place(timer);
+	scheduled++;
+}
+
+void TimerWheel::cancel(Timer* timer) {
+	if (timer->next == NULL) {
+		return;
+	}
+
+	timer->prev->next = timer->next;
+	timer->next->prev = timer->prev;
+	timer->prev = NULL;
+	timer->next = NULL;
+	scheduled--;
+}
+
+void TimerWheel::advance(std::chrono::steady_clock::time_point now, std::vector<void*>* expired) {
+	unsigned long long target;
+	Timer* head;
+	Timer* timer;
+	Timer pending;
+
+	target = get_tick(now);
+
+	/**
+	 *	- Nothing to expire or move down, so skip straight to now
+	 */
+	if (scheduled == 0) {
+		if (target > current_tick) {
+			current_tick = target;
+		}
+		return;
+	}
+
+	while (current_tick < target) {
+		current_tick++;
+
+		/**
+		 *	- Each wheel whose lower wheels have all just gone around
+		 *	  moves its current slot down, highest wheel first so its
+		 *	  timers are moved on from the wheels below in the same tick
+		 */
+		for (int level = LEVELS - 1; level > 0; level--) {
+			if ((current_tick & ((1ULL << (SLOT_BITS * level)) - 1)) != 0) {
+				continue;
+			}
+
+			head = &slots[level][(current_tick >> (SLOT_BITS * level)) & (SLOTS - 1)];
+			if (head->next == head) {
+				continue;
+			}
+
+			pending.next = head->next;
+			pending.prev = head->prev;
+			pending.next->prev = &pending;
+			pending.prev->next = &pending;
+			head->next = head;
+			head->prev = head;
+
+			while (pending.next != &pending) {
+				timer = pending.next;
+				pending.next = timer->next;
+				timer->next->prev = &pending;
+				place(timer);
+			}
+		}
+
+		head = &slots[0][current_tick & (SLOTS - 1)];
+		while (head->next != head) {
+			timer = head->next;
+			cancel(timer);
+			expired->push_back(timer->owner);
+		}
+	}
+}
+
+int TimerWheel::get_wait_timeout(std::chrono::steady_clock::time_point now) {
+	long long remaining;
+
+	if (scheduled == 0) {
+		return -1;
+	}
+
+	remaining = (long long)(current_tick + 1) * TICK_MS - std::chrono::duration_cast<std::chrono::milliseconds>(now - start).count();
+
+	if (remaining < 0) {
+		return 0;
+	}
+
+	return (int)remaining;
+}
+
+void TimerWheel::place(Timer* timer) {
+	unsigned long long remaining;
+	Timer* head;
+	int level;
+
+	/**
+	 *	- The lowest wheel whose range covers the ticks left
+	 */
+	remaining = timer->expiry - current_tick;
+
+	level = 0;
+	while (level < LEVELS - 1 && remaining >= (1ULL << (SLOT_BITS * (level + 1)))) {
+		level++;
+	}
+
+	head = &slots[level][(timer->expiry >> (SLOT_BITS * level)) & (SLOTS - 1)];
+	timer->prev = head->prev;
+	timer->next = head;
+	head->prev->next = timer;
+	head->prev = timer;
+}
+
+unsigned long long TimerWheel::get_tick(std::chrono::steady_clock::time_point time) {
+	if (time <= start) {
+		return 0;
+	}
+
+	return std::chrono::duration_cast<std::chrono::milliseconds>(time - start).count() / TICK_MS;
+}
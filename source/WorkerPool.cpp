@@ -0,0 +1,136 @@
+#include <arpa/inet.h>
+#include <chrono>
+#include <condition_variable>
+#include <coroutine>
+#include <cstdint>
+#include <cstdlib>
+#include <deque>
+#include <exception>
+#include <linux/io_uring.h>
+#include <map>
+#include <mutex>
+#include <netdb.h>
+#include <string>
+#include <string_view>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <system_error>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "../include/pugiconfig.hpp"
+#include "../include/pugixml.hpp"
+#include "../include/Connection.h"
+#include "../include/FrameBuffer.h"
+#include "../include/IoUring.h"
+#include "../include/NameResolver.h"
+#include "../include/OutputQueue.h"
+#include "../include/RequestSchema.h"
+#include "../include/RequestReader.h"
+#include "../include/RequestContext.h"
+#include "../include/ResponseTemplate.h"
+#include "../include/TimerWheel.h"
+#include "../include/SocketClient.h"
+#include "../include/WorkerPool.h"
+#include "../include/SocketServer.h"
+
+WorkerPool::WorkerPool() {
+	stopping = false;
+	max_queue_depth = 0;
+	latency_budget = std::chrono::milliseconds(0);
+}
+
+WorkerPool::~WorkerPool() {
+	stop();
+}
+
+int WorkerPool::start(int _workers) {
+	try {
+		for (int i = 0; i < _workers; i++) {
+			threads.emplace_back(&WorkerPool::run_worker, this);
+		}
+	}
+	catch (const std::system_error&) {
+		stop();
+		return EXIT_FAILURE;
+	}
+
+	return EXIT_SUCCESS;
+}
+
+void WorkerPool::stop() {
+	jobs_mutex.lock();
+	stopping = true;
+	jobs_mutex.unlock();
+	jobs_available.notify_all();
+
+	for (std::thread& thread : threads) {
+		thread.join();
+	}
+
+	threads.clear();
+}
+
+int WorkerPool::set_admission_limits(size_t _max_queue_depth, int _latency_budget) {
+	max_queue_depth = _max_queue_depth;
+	latency_budget = std::chrono::milliseconds(_latency_budget);
+
+	return EXIT_SUCCESS;
+}
+
+int WorkerPool::submit(Job* job) {
+	/**
+	 *	- Turn the job away if the queue is too deep, or if the oldest job
+	 *	  in it has already waited past the latency budget: a new job
+	 *	  would only wait longer still
+	 */
+	job->submitted = std::chrono::steady_clock::now();
+
+	jobs_mutex.lock();
+	if ((max_queue_depth > 0 && jobs.size() >= max_queue_depth)
+		|| (latency_budget.count() > 0 && !jobs.empty() && job->submitted - jobs.front()->submitted > latency_budget)) {
+		jobs_mutex.unlock();
+		return EXIT_FAILURE;
+	}
+
+	jobs.push_back(job);
+	jobs_mutex.unlock();
+	jobs_available.notify_one();
+
+	return EXIT_SUCCESS;
+}
+
+int WorkerPool::get_workers() {
+	return threads.size();
+}
+
+void WorkerPool::run_worker() {
+	/**
+	 *	- Each worker parses requests into its own XML document, so no
+	 *	  locking is needed while processing. The document keeps its
+	 *	  memory pages from one request to the next
+	 */
+	RequestContext context;
+	Job* job;
+
+	context.request.reset(true);
+
+	while (1) {
+		{
+			std::unique_lock<std::mutex> lock(jobs_mutex);
+			jobs_available.wait(lock, [this] { return stopping || !jobs.empty(); });
+
+			if (jobs.empty()) {
+				return;
+			}
+
+			job = jobs.front();
+			jobs.pop_front();
+		}
+
+		job->server->handle_request(&context, &job->request[0], job->request.size(), &job->response);
+		job->server->complete_job(job);
+	}
+}
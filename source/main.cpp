@@ -1,15 +1,45 @@
 #include <arpa/inet.h>
+#include <chrono>
+#include <condition_variable>
+#include <coroutine>
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <exception>
+#include <getopt.h>
 #include <iostream>
+#include <linux/io_uring.h>
+#include <map>
+#include <mutex>
 #include <netdb.h>
+#include <pthread.h>
+#include <sched.h>
 #include <string>
 #include <string.h>
+#include <string_view>
 #include <sys/socket.h>
 #include <sys/types.h>
+#include <sys/uio.h>
+#include <thread>
 #include <unistd.h>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
 
 #include "../include/pugiconfig.hpp"
 #include "../include/pugixml.hpp"
+#include "../include/Connection.h"
+#include "../include/FrameBuffer.h"
+#include "../include/IoUring.h"
+#include "../include/NameResolver.h"
+#include "../include/OutputQueue.h"
+#include "../include/RequestSchema.h"
+#include "../include/RequestReader.h"
+#include "../include/RequestContext.h"
+#include "../include/ResponseTemplate.h"
+#include "../include/TimerWheel.h"
 #include "../include/SocketClient.h"
+#include "../include/WorkerPool.h"
 #include "../include/SocketServer.h"
 
 /**
@@ -26,23 +56,116 @@
  */
 #define DEFAULT_SOCKET_SERVER_PORT	(5000)
 
+/**
+ * \def		DEFAULT_SOCKET_SERVER_SHARDS
+ * \brief	To be used as the number of event loops (each with its own
+ *		listener) if no --shards option is given
+ */
+#define DEFAULT_SOCKET_SERVER_SHARDS	(1)
+
+/**
+ * \def		DEFAULT_SOCKET_SERVER_WORKERS
+ * \brief	To be used as the number of worker threads if no --workers
+ *		option is given. Zero handles requests on the event loops
+ */
+#define DEFAULT_SOCKET_SERVER_WORKERS	(0)
+
+/**
+ * \def		DEFAULT_SOCKET_SERVER_DNS_TTL
+ * \brief	To be used as the number of seconds a client host name stays
+ *		cached if no --dns-ttl option is given
+ */
+#define DEFAULT_SOCKET_SERVER_DNS_TTL	(300)
+
+/**
+ * \def		DEFAULT_SOCKET_SERVER_IDLE_TIMEOUT
+ * \brief	To be used as the number of seconds a client may go without
+ *		sending anything if no --idle-timeout option is given
+ */
+#define DEFAULT_SOCKET_SERVER_IDLE_TIMEOUT	(300)
+
+/**
+ * \def		DEFAULT_SOCKET_SERVER_REQUEST_TIMEOUT
+ * \brief	To be used as the number of seconds a client may take to send
+ *		the rest of a request if no --request-timeout option is given
+ */
+#define DEFAULT_SOCKET_SERVER_REQUEST_TIMEOUT	(30)
+
+/**
+ * \def		DEFAULT_SOCKET_SERVER_WRITE_TIMEOUT
+ * \brief	To be used as the number of seconds a client may take to read
+ *		its responses if no --write-timeout option is given
+ */
+#define DEFAULT_SOCKET_SERVER_WRITE_TIMEOUT	(30)
+
 /**
  * \def		MAX_NUM_OF_ARGS
- * \brief	The max number of command-line arguments to expect
+ * \brief	The max number of positional command-line arguments to expect
  */
 #define MAX_NUM_OF_ARGS			(2 + 1)
 
 /**
- * \fn		void main
- * \param	argc	The amount of command-line arguments given during execution
- * \param	argv	Each element of this array points to the string of each
- *			command-line argument
+ * \var		long_options
+ * \brief	Command-line options accepted ahead of the positional
+ *		IP address and port arguments
+ */
+static const option long_options[] = {
+	{ "shards",	required_argument,	NULL,	's' },
+	{ "steer-cpu",	no_argument,		NULL,	'c' },
+	{ "workers",	required_argument,	NULL,	'w' },
+	{ "io-uring",	no_argument,		NULL,	'u' },
+	{ "length-prefix",	no_argument,	NULL,	'l' },
+	{ "document-framing",	no_argument,	NULL,	'd' },
+	{ "coroutines",	no_argument,		NULL,	'o' },
+	{ "streaming-parser",	no_argument,	NULL,	'p' },
+	{ "max-queue",	required_argument,	NULL,	'q' },
+	{ "latency-budget",	required_argument,	NULL,	'b' },
+	{ "idle-timeout",	required_argument,	NULL,	'i' },
+	{ "request-timeout",	required_argument,	NULL,	'r' },
+	{ "write-timeout",	required_argument,	NULL,	'x' },
+	{ "keepalive",	required_argument,	NULL,	'k' },
+	{ "no-resolve",	no_argument,		NULL,	'n' },
+	{ "dns-ttl",	required_argument,	NULL,	't' },
+	{ "help",	no_argument,		NULL,	'h' },
+	{ NULL,		0,			NULL,	0 }
+};
+
+/**
+ * \fn		void print_usage
+ * \param	program	The name the program was executed as
+ * \return	N/A
+ * \brief	Prints the accepted command-line options and arguments
+ */
+void print_usage(char* program) {
+	std::cerr << "Usage: " << program << " [options] [address [port]]" << std::endl;
+	std::cerr << "	-s, --shards N	Run N event loops, each on its own thread with its own SO_REUSEPORT listener" << std::endl;
+	std::cerr << "	-c, --steer-cpu	Pin shard i to CPU i and steer each connection to the shard on the CPU that received it" << std::endl;
+	std::cerr << "	-w, --workers N	Validate and process requests on N worker threads instead of the event loops" << std::endl;
+	std::cerr << "	-u, --io-uring	Drive the event loops with io_uring instead of epoll" << std::endl;
+	std::cerr << "	-l, --length-prefix	Frame requests and responses with a 4-byte length prefix instead of newlines" << std::endl;
+	std::cerr << "	-d, --document-framing	End each request with the end tag of its root element instead of a newline" << std::endl;
+	std::cerr << "	-o, --coroutines	Serve each client with a coroutine on the epoll event loop (not with --workers or --io-uring)" << std::endl;
+	std::cerr << "	-p, --streaming-parser	Validate requests as they are parsed, without building a document for them" << std::endl;
+	std::cerr << "	-q, --max-queue N	(with --workers) Answer Busy without processing once N requests are queued for the workers" << std::endl;
+	std::cerr << "	-b, --latency-budget MS	(with --workers) Answer Busy without processing once the oldest queued request has waited MS milliseconds" << std::endl;
+	std::cerr << "	-i, --idle-timeout S	Disconnect clients that send nothing for S seconds (0 to disable)" << std::endl;
+	std::cerr << "	-r, --request-timeout S	Disconnect clients that take over S seconds to send the rest of a request (0 to disable)" << std::endl;
+	std::cerr << "	-x, --write-timeout S	Disconnect clients that take over S seconds to read their responses (0 to disable)" << std::endl;
+	std::cerr << "	-k, --keepalive I:N:C	Send TCP keepalive probes after I idle seconds, every N seconds, up to C times" << std::endl;
+	std::cerr << "	-n, --no-resolve	Identify clients by IP address without looking up their host names" << std::endl;
+	std::cerr << "	-t, --dns-ttl N	Cache each client host name for N seconds (looked up in the background)" << std::endl;
+	std::cerr << "	-h, --help	Print this message" << std::endl;
+}
+
+/**
+ * \fn		int start_shard
+ * \param	destination	Server object to set up
  * \return	Returns EXIT_FAILURE upon any failures encountered,
  *		and EXIT_SUCCESS otherwise
- * \brief	Creates a socket server, connects with client, and processes XML
- *		requests from client and sends XML responses to client
+ * \brief	Creates, binds and marks passive the server's listener and
+ *		registers it with the server's event loop
  */
-int main(int argc, char* argv[]){
+int start_shard(SocketServer* destination) {
 
 	/**
 	 * \var		return_code
@@ -50,57 +173,24 @@ int main(int argc, char* argv[]){
 	 */
 	int return_code;
 
-	/**
-	 * \var		destination
-	 * \brief	Server object to process commands from client
-	 */
-	SocketServer destination;
-
-	/**
-	 * \var		source
-	 * \brief	Client object sending commands to server via socket
-	 */
-	SocketClient source;
-
-	/**
-	 * Set Socket Server port and address based on command line arguments
-	 *	- Port must be integer so it can be passed to htons
-	 *	- Address must be string so it can be passed to inet_pton
-	 */
-	if (argc > MAX_NUM_OF_ARGS) {
-		std::cerr << "FAILURE: Invalid number of arguments..." << std::endl;
-		return EXIT_FAILURE;
-	}
-	else if (argc == MAX_NUM_OF_ARGS) {
-		destination.set_address(argv[1]);
-		destination.set_port(std::stoi(argv[2]));
-	}
-	else if (argc > 1) {
-		destination.set_address(argv[1]);
-		destination.set_port(DEFAULT_SOCKET_SERVER_PORT);
-	}
-	else {
-		destination.set_address(DEFAULT_SOCKET_SERVER_ADDR);
-		destination.set_port(DEFAULT_SOCKET_SERVER_PORT);
-	}
-
 	/**
 	 * Create server object
 	 */
 	std::cout << "Creating TCP Socket Server in IPv4 domain..." << std::endl;
-	return_code = destination.create_tcp_ipv4();
+	return_code = destination->create_tcp_ipv4();
 	if (return_code != EXIT_SUCCESS) {
-		std::cerr << "FAILURE: Could not create TCP Socket Server in IPv4 domain" << std::endl << "Aborting..." << std::endl;
+		std::cerr << "FAILURE: Could not create TCP Socket Server in IPv4 domain" << std::endl;
 		return EXIT_FAILURE;
 	}
 
 	/**
 	 * Bind the server object to IP and port
 	 */
-	std::cout << "Binding server to " << destination.get_address() << ":" << destination.get_port() << std::endl;
-	return_code = destination.bind_tcp_ipv4();
+	std::cout << "Binding server to " << destination->get_address() << ":" << destination->get_port() << std::endl;
+	return_code = destination->bind_tcp_ipv4();
 	if (return_code != EXIT_SUCCESS) {
-		std::cerr << "FAILURE: Could not bind server to " << destination.get_address() << ":" << destination.get_port() << std::endl << "Aborting..." << std::endl;
+		std::cerr << "FAILURE: Could not bind server to " << destination->get_address() << ":" << destination->get_port() << std::endl;
+		destination->close_file_descriptor();
 		return EXIT_FAILURE;
 	}
 
@@ -109,100 +199,431 @@ int main(int argc, char* argv[]){
 	 * initiate a connection
 	 */
 	std::cout << "Marking server as passive (to listen for clients) with backlog of " << SOMAXCONN << "..." << std::endl;
-	return_code = destination.mark_passive();
+	return_code = destination->mark_passive();
 	if (return_code != EXIT_SUCCESS) {
-		std::cerr << "FAILURE: Could not mark server as passive with backlog of " << SOMAXCONN << std::endl << "Aborting..." << std::endl;
+		std::cerr << "FAILURE: Could not mark server as passive with backlog of " << SOMAXCONN << std::endl;
+		destination->close_file_descriptor();
 		return EXIT_FAILURE;
 	}
 
 	/**
-	 * Once a client attempts to connect, accept the call
+	 * Register the server with an epoll instance (or io_uring instance) so
+	 * that many clients can be served concurrently on one thread
 	 */
-	std::cout << "Listening for clients..." << std::endl;
-	return_code = destination.accept_client(&source);
+	std::cout << "Creating event loop..." << std::endl;
+	return_code = destination->create_event_loop();
 	if (return_code != EXIT_SUCCESS) {
-		std::cerr << "FAILURE: Found a client but could not accept connection" << std::endl << "Aborting..." << std::endl;
+		std::cerr << "FAILURE: Could not create event loop" << std::endl;
+		destination->close_file_descriptor();
 		return EXIT_FAILURE;
 	}
-	else {
-		std::cout << "Server has accepted a client connection!" << std::endl;
+
+	return EXIT_SUCCESS;
+}
+
+/**
+ * \fn		int run_shard
+ * \param	destination	Server object whose event loop to run
+ * \param	cpu		CPU to pin the calling thread to, or -1 to
+ *				let the scheduler place it
+ * \return	Returns EXIT_FAILURE upon any failures encountered,
+ *		and EXIT_SUCCESS otherwise
+ * \brief	Runs the server's event loop on the calling thread and closes
+ *		the server file descriptor once the event loop is done
+ */
+int run_shard(SocketServer* destination, int cpu) {
+
+	/**
+	 * \var		return_code
+	 * \brief	Holds return value of any invocations returned status codes
+	 */
+	int return_code;
+
+	/**
+	 * \var		cpu_set
+	 * \brief	Set holding only the CPU to pin the calling thread to
+	 */
+	cpu_set_t cpu_set;
+
+	/**
+	 * Keep the event loop on the CPU its connections are steered to
+	 */
+	if (cpu >= 0) {
+		CPU_ZERO(&cpu_set);
+		CPU_SET(cpu, &cpu_set);
+		if (pthread_setaffinity_np(pthread_self(), sizeof(cpu_set), &cpu_set) != EXIT_SUCCESS) {
+			std::cerr << "FAILURE: Could not pin event loop to CPU " << cpu << std::endl;
+		}
 	}
 
 	/**
-	 * Grab the hostname (or IP address) + port number the client is
-	 * connecting from
+	 * Server will continue to accept clients and process their requests
+	 * until the event loop fails
 	 */
-	return_code = source.set_name_info();
-	if (return_code == EXIT_SUCCESS) {
-		std::cout << "Established TCP socket connection to client " << source.get_host_name() << ":" << source.get_service() << std::endl;
+	std::cout << "Listening for clients..." << std::endl;
+	return_code = destination->run_event_loop();
+	if (return_code != EXIT_SUCCESS) {
+		std::cerr << "FAILURE: Event loop failed" << std::endl;
 	}
-	else {
-		return_code = source.set_ipv4_info();
 
-		if(return_code != EXIT_SUCCESS) {
-			std::cerr << "FAILURE: Could not establish TCP socket connection to client" << std::endl << "Aborting..." << std::endl;
+	/**
+	 * Close the server file descriptor now that server is done listening
+	 */
+	std::cout << "Closing server file descriptor..." << std::endl;
+	if (destination->close_file_descriptor() != EXIT_SUCCESS) {
+		std::cerr << "FAILURE: Could not close the server file descriptor..." << std::endl;
+		return_code = EXIT_FAILURE;
+	}
+
+	return return_code;
+}
+
+
+/**
+ * \fn		void main
+ * \param	argc	The amount of command-line arguments given during execution
+ * \param	argv	Each element of this array points to the string of each
+ *			command-line argument
+ * \return	Returns EXIT_FAILURE upon any failures encountered,
+ *		and EXIT_SUCCESS otherwise
+ * \brief	Creates one socket server per shard, accepts clients, and
+ *		processes XML requests from clients and sends XML responses
+ *		to clients
+ */
+int main(int argc, char* argv[]){
+
+	/**
+	 * \var		return_code
+	 * \brief	Holds return value of any invocations returned status codes
+	 */
+	int return_code;
+
+	/**
+	 * \var		option
+	 * \brief	Holds the command-line option currently being parsed
+	 */
+	int option;
+
+	/**
+	 * \var		shards
+	 * \brief	Number of event loops to run, each with its own listener
+	 */
+	int shards = DEFAULT_SOCKET_SERVER_SHARDS;
+
+	/**
+	 * \var		steer_cpu
+	 * \brief	Whether to pin each shard to a CPU and steer connections
+	 *		to the shard on the CPU that received them
+	 */
+	bool steer_cpu = false;
+
+	/**
+	 * \var		worker_count
+	 * \brief	Number of worker threads to validate and process requests on
+	 */
+	int worker_count = DEFAULT_SOCKET_SERVER_WORKERS;
+
+	/**
+	 * \var		max_queue
+	 * \brief	Max number of requests queued for the workers, or 0 for
+	 *		no limit
+	 */
+	int max_queue = 0;
+
+	/**
+	 * \var		latency_budget
+	 * \brief	Max milliseconds the oldest request queued for the workers
+	 *		may have waited, or 0 for no limit
+	 */
+	int latency_budget = 0;
+
+	/**
+	 * \var		use_io_uring
+	 * \brief	Whether to drive the event loops with io_uring
+	 */
+	bool use_io_uring = false;
+
+	/**
+	 * \var		framing
+	 * \brief	How requests and responses are delimited
+	 */
+	Framing framing = FRAMING_NEWLINE;
+
+	/**
+	 * \var		use_coroutines
+	 * \brief	Whether to serve each client with a coroutine
+	 */
+	bool use_coroutines = false;
+
+	/**
+	 * \var		use_streaming_parser
+	 * \brief	Whether to read requests without building a document
+	 */
+	bool use_streaming_parser = false;
+
+	/**
+	 * \var		resolve_names
+	 * \brief	Whether to look up client host names
+	 */
+	bool resolve_names = true;
+
+	/**
+	 * \var		dns_ttl
+	 * \brief	Seconds a client host name stays cached
+	 */
+	int dns_ttl = DEFAULT_SOCKET_SERVER_DNS_TTL;
+
+	/**
+	 * \var		idle_timeout, request_timeout, write_timeout
+	 * \brief	Seconds before an idle, slow-sending or slow-reading client
+	 *		is disconnected, or 0 to never disconnect it
+	 */
+	int idle_timeout = DEFAULT_SOCKET_SERVER_IDLE_TIMEOUT;
+	int request_timeout = DEFAULT_SOCKET_SERVER_REQUEST_TIMEOUT;
+	int write_timeout = DEFAULT_SOCKET_SERVER_WRITE_TIMEOUT;
+
+	/**
+	 * \var		keepalive_idle, keepalive_interval, keepalive_count
+	 * \brief	TCP keepalive settings of client sockets. Keepalive is off
+	 *		unless keepalive_idle is set
+	 */
+	int keepalive_idle = 0;
+	int keepalive_interval = 0;
+	int keepalive_count = 0;
+
+	/**
+	 * \var		address
+	 * \brief	IP address every shard binds to
+	 */
+	std::string address = DEFAULT_SOCKET_SERVER_ADDR;
+
+	/**
+	 * \var		port
+	 * \brief	Port every shard binds to
+	 */
+	int port = DEFAULT_SOCKET_SERVER_PORT;
+
+	/**
+	 * Parse command-line options ahead of the positional arguments
+	 */
+	while ((option = getopt_long(argc, argv, "s:cw:q:b:uldopnt:i:r:x:k:h", long_options, NULL)) != -1) {
+		switch (option) {
+		case 's':
+			shards = std::stoi(optarg);
+			if (shards < 1) {
+				std::cerr << "FAILURE: Number of shards must be at least 1..." << std::endl;
+				return EXIT_FAILURE;
+			}
+			break;
+		case 'c':
+			steer_cpu = true;
+			break;
+		case 'w':
+			worker_count = std::stoi(optarg);
+			if (worker_count < 0) {
+				std::cerr << "FAILURE: Number of workers cannot be negative..." << std::endl;
+				return EXIT_FAILURE;
+			}
+			break;
+		case 'q':
+			max_queue = std::stoi(optarg);
+			if (max_queue < 0) {
+				std::cerr << "FAILURE: Max queue depth cannot be negative..." << std::endl;
+				return EXIT_FAILURE;
+			}
+			break;
+		case 'b':
+			latency_budget = std::stoi(optarg);
+			if (latency_budget < 0) {
+				std::cerr << "FAILURE: Latency budget cannot be negative..." << std::endl;
+				return EXIT_FAILURE;
+			}
+			break;
+		case 'u':
+			use_io_uring = true;
+			break;
+		case 'l':
+			framing = FRAMING_LENGTH_PREFIX;
+			break;
+		case 'd':
+			framing = FRAMING_DOCUMENT;
+			break;
+		case 'o':
+			use_coroutines = true;
+			break;
+		case 'p':
+			use_streaming_parser = true;
+			break;
+		case 'i':
+			idle_timeout = std::stoi(optarg);
+			break;
+		case 'r':
+			request_timeout = std::stoi(optarg);
+			break;
+		case 'x':
+			write_timeout = std::stoi(optarg);
+			break;
+		case 'k':
+			if (sscanf(optarg, "%d:%d:%d", &keepalive_idle, &keepalive_interval, &keepalive_count) != 3
+				|| keepalive_idle < 1 || keepalive_interval < 1 || keepalive_count < 1) {
+				std::cerr << "FAILURE: Keepalive must be given as IDLE:INTERVAL:COUNT, each at least 1..." << std::endl;
+				return EXIT_FAILURE;
+			}
+			break;
+		case 'n':
+			resolve_names = false;
+			break;
+		case 't':
+			dns_ttl = std::stoi(optarg);
+			if (dns_ttl < 0) {
+				std::cerr << "FAILURE: DNS TTL cannot be negative..." << std::endl;
+				return EXIT_FAILURE;
+			}
+			break;
+		case 'h':
+			print_usage(argv[0]);
+			return EXIT_SUCCESS;
+		default:
+			print_usage(argv[0]);
 			return EXIT_FAILURE;
 		}
-		else {
-			std::cout << "Established TCP socket connection to client " << source.get_host_name() << ":" << source.get_sin_port() << std::endl;
-		}
+	}
+
+	if (idle_timeout < 0 || request_timeout < 0 || write_timeout < 0) {
+		std::cerr << "FAILURE: Timeouts cannot be negative..." << std::endl;
+		return EXIT_FAILURE;
 	}
 
 	/**
-	 * Close the server file descriptor now that socket connection has been established
+	 * Coroutines are resumed by the epoll event loop and handle requests
+	 * on it, so they cannot be combined with io_uring or worker threads
 	 */
-	std::cout << "Closing server file descriptor..." << std::endl;
-	return_code = destination.close_file_descriptor();
-	if (return_code != EXIT_SUCCESS) {
-		std::cerr << "FAILURE: Could not close the server file descriptor..." << std::endl << "Aborting..." << std::endl;
+	if (use_coroutines && (use_io_uring || worker_count > 0)) {
+		std::cerr << "FAILURE: --coroutines cannot be combined with --io-uring or --workers..." << std::endl;
 		return EXIT_FAILURE;
 	}
 
 	/**
-	 * Server will continue to process requests from client until
-	 * client hangs up
+	 * Set Socket Server port and address based on command line arguments
+	 *	- Port must be integer so it can be passed to htons
+	 *	- Address must be string so it can be passed to inet_pton
+	 */
+	argc -= optind - 1;
+	argv += optind - 1;
+	if (argc > MAX_NUM_OF_ARGS) {
+		std::cerr << "FAILURE: Invalid number of arguments..." << std::endl;
+		return EXIT_FAILURE;
+	}
+	else if (argc == MAX_NUM_OF_ARGS) {
+		address = argv[1];
+		port = std::stoi(argv[2]);
+	}
+	else if (argc > 1) {
+		address = argv[1];
+	}
+
+	/**
+	 * \var		destinations
+	 * \brief	Server objects to process commands from clients, one per
+	 *		shard. Each owns its listener, event loop, buffers and XML
+	 *		documents so shards share nothing on the hot path
+	 */
+	std::vector<SocketServer> destinations(shards);
+
+	/**
+	 * \var		threads
+	 * \brief	Threads running the event loops of every shard but the
+	 *		first, which runs on the main thread
+	 */
+	std::vector<std::thread> threads;
+
+	/**
+	 * \var		workers
+	 * \brief	Worker threads shared by every shard. I/O threads hand
+	 *		complete requests to them so that a slow request never
+	 *		stalls reads and writes for other clients
+	 */
+	WorkerPool workers;
+
+	/**
+	 * \var		resolver
+	 * \brief	Looks up client host names in the background for every
+	 *		shard, so accepting a client never waits on DNS
 	 */
-	while (1) {
+	NameResolver resolver;
 
-		/**
-		 * Clear the buffer and then wait for client to send data. If client has
-		 * hung up then close the client file descriptor and break from loop.
-		 * Otherwise, server will validate and process the request and then
-		 * send the response to the client. Once response is sent, server
-		 * will again clear the buffer and wait for client to send data
-		 */
-		std::cout << "Waiting on client to send request..." << std::endl << std::endl;
-		destination.receive_request_from_client(&source);
-		if (destination.get_bytes_received() < EXIT_SUCCESS) {
-			std::cerr << "FAILURE: Error receiving request from client" << std::endl << "Aborting..." << std::endl;
+	if (worker_count > 0) {
+		workers.set_admission_limits(max_queue, latency_budget);
+
+		std::cout << "Starting " << worker_count << " worker threads..." << std::endl;
+		return_code = workers.start(worker_count);
+		if (return_code != EXIT_SUCCESS) {
+			std::cerr << "FAILURE: Could not start worker threads" << std::endl << "Aborting..." << std::endl;
 			return EXIT_FAILURE;
 		}
-		else if (destination.get_bytes_received() == EXIT_SUCCESS) {
-			std::cout << "Connection to client lost! Closing client file descriptor..." << std::endl;
-			return_code = source.close_file_descriptor();
-			if (return_code != EXIT_SUCCESS) {
-				std::cerr << "FAILURE: Could not close the client file descriptor" << std::endl << "Aborting..." << std::endl;
-				return EXIT_FAILURE;
-			}
+	}
 
-			break;
+	if (resolve_names) {
+		return_code = resolver.start(dns_ttl);
+		if (return_code != EXIT_SUCCESS) {
+			std::cerr << "FAILURE: Could not start name resolver thread" << std::endl << "Aborting..." << std::endl;
+			return EXIT_FAILURE;
 		}
-		else {
-			std::cout << "Validating request from client..." << std::endl;
-			destination.validate_request();
+	}
 
-			std::cout << "Processing request from client..." << std::endl;
-			destination.process_request();
+	/**
+	 * Set up every shard's listener in order. With more than one shard the
+	 * listeners share the address + port through SO_REUSEPORT and the
+	 * kernel spreads incoming connections across them
+	 */
+	for (int shard = 0; shard < shards; shard++) {
+		destinations[shard].set_address(address);
+		destinations[shard].set_port(port);
+		destinations[shard].set_reuse_port(shards > 1);
+		destinations[shard].set_worker_pool(worker_count > 0 ? &workers : NULL);
+		destinations[shard].set_io_uring(use_io_uring);
+		destinations[shard].set_framing(framing);
+		destinations[shard].set_coroutines(use_coroutines);
+		destinations[shard].set_streaming_parser(use_streaming_parser);
+		destinations[shard].set_name_resolver(resolve_names ? &resolver : NULL);
+		destinations[shard].set_timeouts(idle_timeout, request_timeout, write_timeout);
+		destinations[shard].set_keepalive(keepalive_idle, keepalive_interval, keepalive_count);
 
-			std::cout << "Sending response to client..." << std::endl;
-			destination.send_response_to_client(&source);
-			if (destination.get_bytes_sent() < EXIT_SUCCESS) {
-				std::cerr << "FAILURE: Error sending response to client" << std::endl << "Aborting..." << std::endl;
-				return EXIT_FAILURE;
-			}
+		return_code = start_shard(&destinations[shard]);
+		if (return_code != EXIT_SUCCESS) {
+			std::cerr << "Aborting..." << std::endl;
+			return EXIT_FAILURE;
 		}
 	}
 
+	/**
+	 * Listeners join the SO_REUSEPORT group in the order they were marked
+	 * passive, so shard i is the one the steering program picks for CPU i
+	 */
+	if (steer_cpu && shards > 1) {
+		std::cout << "Steering connections to the shard on the CPU that received them..." << std::endl;
+		return_code = destinations[0].steer_to_incoming_cpu(shards);
+		if (return_code != EXIT_SUCCESS) {
+			std::cerr << "FAILURE: Could not attach CPU steering program" << std::endl << "Aborting..." << std::endl;
+			return EXIT_FAILURE;
+		}
+	}
+
+	for (int shard = 1; shard < shards; shard++) {
+		threads.emplace_back(run_shard, &destinations[shard], steer_cpu ? shard : -1);
+	}
+
+	return_code = run_shard(&destinations[0], steer_cpu ? 0 : -1);
+
+	for (std::thread& thread : threads) {
+		thread.join();
+	}
+
+	if (return_code != EXIT_SUCCESS) {
+		std::cerr << "Aborting..." << std::endl;
+		return EXIT_FAILURE;
+	}
+
 	std::cout << "Clean-up complete! Exiting gracefully..." << std::endl;
 
 	return EXIT_SUCCESS;
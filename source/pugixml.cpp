@@ -40,6 +40,12 @@
 // For placement new
 #include <new>
 
+// SIMD kernels: SSE2 wherever it is available, and AVX2 when the CPU running the code supports it
+#if !defined(PUGIXML_NO_SIMD) && !defined(PUGIXML_WCHAR_MODE) && defined(__GNUC__) && defined(__SSE2__) && (defined(__x86_64__) || defined(__i386__))
+#	define PUGI__SIMD
+#	include <immintrin.h>
+#endif
+
 #ifdef _MSC_VER
 #	pragma warning(push)
 #	pragma warning(disable: 4127) // conditional expression is constant
@@ -468,6 +474,7 @@ PUGI__NS_BEGIN
 			result->next = 0;
 			result->busy_size = 0;
 			result->freed_size = 0;
+			result->data_size = 0;
 
 		#ifdef PUGIXML_COMPACT
 			result->compact_string_base = 0;
@@ -486,6 +493,9 @@ PUGI__NS_BEGIN
 		size_t busy_size;
 		size_t freed_size;
 
+		// size of the page data; pages of xml_memory_page_size can be kept for reuse
+		size_t data_size;
+
 	#ifdef PUGIXML_COMPACT
 		char_t* compact_string_base;
 		void* compact_shared_parent;
@@ -509,7 +519,7 @@ PUGI__NS_BEGIN
 
 	struct xml_allocator
 	{
-		xml_allocator(xml_memory_page* root): _root(root), _busy_size(root->busy_size)
+		xml_allocator(xml_memory_page* root): _root(root), _busy_size(root->busy_size), _spare_pages(0), _keep_pages(false)
 		{
 		#ifdef PUGIXML_COMPACT
 			_hash = 0;
@@ -520,9 +530,19 @@ PUGI__NS_BEGIN
 		{
 			size_t size = sizeof(xml_memory_page) + data_size;
 
-			// allocate block with some alignment, leaving memory for worst-case padding
-			void* memory = xml_memory::allocate(size);
-			if (!memory) return 0;
+			// reuse a kept page if this is a regular page, otherwise allocate block with some alignment, leaving memory for worst-case padding
+			void* memory = 0;
+
+			if (_spare_pages && data_size == xml_memory_page_size)
+			{
+				memory = _spare_pages;
+				_spare_pages = _spare_pages->next;
+			}
+			else
+			{
+				memory = xml_memory::allocate(size);
+				if (!memory) return 0;
+			}
 
 			// prepare page structure
 			xml_memory_page* page = xml_memory_page::construct(memory);
@@ -530,6 +550,7 @@ PUGI__NS_BEGIN
 
 			assert(this == _root->allocator);
 			page->allocator = this;
+			page->data_size = data_size;
 
 			return page;
 		}
@@ -539,6 +560,32 @@ PUGI__NS_BEGIN
 			xml_memory::deallocate(page);
 		}
 
+		// keeps page for reuse by allocate_page in keep_pages mode (see xml_document::reset), otherwise deallocates it
+		void release_page(xml_memory_page* page)
+		{
+			if (_keep_pages && page->data_size == xml_memory_page_size)
+			{
+				page->next = _spare_pages;
+				_spare_pages = page;
+			}
+			else
+			{
+				deallocate_page(page);
+			}
+		}
+
+		void deallocate_spare_pages()
+		{
+			while (_spare_pages)
+			{
+				xml_memory_page* next = _spare_pages->next;
+
+				deallocate_page(_spare_pages);
+
+				_spare_pages = next;
+			}
+		}
+
 		void* allocate_memory_oob(size_t size, xml_memory_page*& out_page);
 
 		void* allocate_memory(size_t size, xml_memory_page*& out_page)
@@ -632,7 +679,7 @@ PUGI__NS_BEGIN
 					page->next->prev = page->prev;
 
 					// deallocate
-					deallocate_page(page);
+					release_page(page);
 				}
 			}
 		}
@@ -702,6 +749,10 @@ PUGI__NS_BEGIN
 		xml_memory_page* _root;
 		size_t _busy_size;
 
+		// pages of xml_memory_page_size kept for reuse, linked through next
+		xml_memory_page* _spare_pages;
+		bool _keep_pages;
+
 	#ifdef PUGIXML_COMPACT
 		compact_hash_table* _hash;
 	#endif
@@ -1450,6 +1501,90 @@ PUGI__NS_BEGIN
 	};
 PUGI__NS_END
 
+// SIMD utilities
+#ifdef PUGI__SIMD
+PUGI__NS_BEGIN
+	#define PUGI__TARGET_AVX2 __attribute__((target("avx2")))
+	#define PUGI__NO_SANITIZE_ADDRESS __attribute__((no_sanitize_address))
+
+	PUGI__FN bool simd_has_avx2()
+	{
+		static const bool result = __builtin_cpu_supports("avx2") != 0;
+
+		return result;
+	}
+
+	// Number of whole 32-byte blocks at the start of data that are all ascii
+	PUGI__FN PUGI__TARGET_AVX2 size_t simd_ascii_blocks_avx2(const uint8_t* data, size_t size)
+	{
+		size_t i = 0;
+
+		for (; i + 32 <= size; i += 32)
+			if (_mm256_movemask_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i))))
+				break;
+
+		return i;
+	}
+
+	// Length of the ascii prefix of data
+	PUGI__FN size_t simd_ascii_length(const uint8_t* data, size_t size)
+	{
+		size_t i = simd_has_avx2() ? simd_ascii_blocks_avx2(data, size) : 0;
+
+		for (; i + 16 <= size; i += 16)
+		{
+			unsigned int mask = static_cast<unsigned int>(_mm_movemask_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i))));
+			if (mask) return i + __builtin_ctz(mask);
+		}
+
+		for (; i < size; ++i)
+			if (data[i] > 127)
+				return i;
+
+		return size;
+	}
+
+	// Length of the ascii prefix of data, in code units that are byte-swapped if swap is set
+	PUGI__FN size_t simd_ascii_length(const uint16_t* data, size_t size, bool swap)
+	{
+		// a code unit is ascii if all bits but the low 7 bits of its value are clear
+		const __m128i high = _mm_set1_epi16(static_cast<short>(swap ? 0x80ff : 0xff80));
+		size_t i = 0;
+
+		for (; i + 8 <= size; i += 8)
+		{
+			__m128i v = _mm_and_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i)), high);
+			unsigned int mask = ~static_cast<unsigned int>(_mm_movemask_epi8(_mm_cmpeq_epi16(v, _mm_setzero_si128()))) & 0xffff;
+
+			if (mask) return i + __builtin_ctz(mask) / 2;
+		}
+
+		for (; i < size; ++i)
+			if ((swap ? data[i] & 0x80ff : data[i] & 0xff80) != 0)
+				return i;
+
+		return size;
+	}
+
+	// Narrows size ascii code units, byte-swapped if swap is set, to bytes
+	PUGI__FN void simd_narrow_ascii(uint8_t* result, const uint16_t* data, size_t size, bool swap)
+	{
+		size_t i = 0;
+
+		for (; i + 8 <= size; i += 8)
+		{
+			__m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+			if (swap) v = _mm_srli_epi16(v, 8);
+
+			_mm_storel_epi64(reinterpret_cast<__m128i*>(result + i), _mm_packus_epi16(v, v));
+		}
+
+		for (; i < size; ++i)
+			result[i] = static_cast<uint8_t>(swap ? data[i] >> 8 : data[i]);
+	}
+PUGI__NS_END
+#endif
+
 // Unicode utilities
 PUGI__NS_BEGIN
 	inline uint16_t endian_swap(uint16_t value)
@@ -1915,6 +2050,177 @@ PUGI__NS_BEGIN
 	#define PUGI__IS_CHARTYPE(c, ct) PUGI__IS_CHARTYPE_IMPL(c, ct, chartype_table)
 	#define PUGI__IS_CHARTYPEX(c, ct) PUGI__IS_CHARTYPE_IMPL(c, ct, chartypex_table)
 
+#ifdef PUGI__SIMD
+	// Mask of the bytes of v that are in ct (a ct_parse_* type, optionally combined with ct_space) according to chartype_table
+	template <int ct> PUGI__FN unsigned int simd_match_sse2(__m128i v)
+	{
+		__m128i m = _mm_or_si128(_mm_cmpeq_epi8(v, _mm_setzero_si128()), _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('&')), _mm_cmpeq_epi8(v, _mm_set1_epi8('\r'))));
+
+		if (ct & ct_parse_pcdata)
+			m = _mm_or_si128(m, _mm_cmpeq_epi8(v, _mm_set1_epi8('<')));
+
+		if (ct & (ct_parse_attr | ct_parse_attr_ws))
+			m = _mm_or_si128(m, _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('\'')), _mm_cmpeq_epi8(v, _mm_set1_epi8('"'))));
+
+		if (ct & (ct_parse_attr_ws | ct_space))
+			m = _mm_or_si128(m, _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('\n')), _mm_cmpeq_epi8(v, _mm_set1_epi8('\t'))));
+
+		if (ct & ct_space)
+			m = _mm_or_si128(m, _mm_cmpeq_epi8(v, _mm_set1_epi8(' ')));
+
+		return static_cast<unsigned int>(_mm_movemask_epi8(m));
+	}
+
+	template <int ct> PUGI__FN PUGI__TARGET_AVX2 unsigned int simd_match_avx2(__m256i v)
+	{
+		__m256i m = _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_setzero_si256()), _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('&')), _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\r'))));
+
+		if (ct & ct_parse_pcdata)
+			m = _mm256_or_si256(m, _mm256_cmpeq_epi8(v, _mm256_set1_epi8('<')));
+
+		if (ct & (ct_parse_attr | ct_parse_attr_ws))
+			m = _mm256_or_si256(m, _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('\'')), _mm256_cmpeq_epi8(v, _mm256_set1_epi8('"'))));
+
+		if (ct & (ct_parse_attr_ws | ct_space))
+			m = _mm256_or_si256(m, _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('\n')), _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\t'))));
+
+		if (ct & ct_space)
+			m = _mm256_or_si256(m, _mm256_cmpeq_epi8(v, _mm256_set1_epi8(' ')));
+
+		return static_cast<unsigned int>(_mm256_movemask_epi8(m));
+	}
+
+	// Returns the first character of s that is in ct; s has to be zero-terminated, and zero is in every ct_parse_* type
+	// Scanning functions only use aligned loads, which never cross a page boundary, so they may read past the terminating zero
+	// up to the end of its block; the bytes read there never affect the result
+	template <int ct> PUGI__FN PUGI__NO_SANITIZE_ADDRESS char_t* simd_scan_sse2(char_t* s)
+	{
+		size_t offset = reinterpret_cast<uintptr_t>(s) & 15;
+		char_t* block = s - offset;
+
+		// the first block starts before s, so ignore the bytes in front of it
+		unsigned int mask = simd_match_sse2<ct>(_mm_load_si128(reinterpret_cast<const __m128i*>(block))) >> offset;
+		if (mask) return s + __builtin_ctz(mask);
+
+		for (;;)
+		{
+			block += 16;
+
+			mask = simd_match_sse2<ct>(_mm_load_si128(reinterpret_cast<const __m128i*>(block)));
+			if (mask) return block + __builtin_ctz(mask);
+		}
+	}
+
+	template <int ct> PUGI__FN PUGI__NO_SANITIZE_ADDRESS PUGI__TARGET_AVX2 char_t* simd_scan_avx2(char_t* s)
+	{
+		size_t offset = reinterpret_cast<uintptr_t>(s) & 31;
+		char_t* block = s - offset;
+
+		// the first block starts before s, so ignore the bytes in front of it
+		unsigned int mask = simd_match_avx2<ct>(_mm256_load_si256(reinterpret_cast<const __m256i*>(block))) >> offset;
+		if (mask) return s + __builtin_ctz(mask);
+
+		for (;;)
+		{
+			block += 32;
+
+			mask = simd_match_avx2<ct>(_mm256_load_si256(reinterpret_cast<const __m256i*>(block)));
+			if (mask) return block + __builtin_ctz(mask);
+		}
+	}
+
+	template <int ct> PUGI__FN char_t* simd_scan(char_t* s)
+	{
+		return simd_has_avx2() ? simd_scan_avx2<ct>(s) : simd_scan_sse2<ct>(s);
+	}
+
+	// Mask of the bytes of v that are in ctx (ctx_special_pcdata or ctx_special_attr) according to chartypex_table
+	template <int ctx> PUGI__FN unsigned int simd_match_special_sse2(__m128i v)
+	{
+		// control characters, i.e. bytes up to 31 as unsigned
+		__m128i m = _mm_cmpeq_epi8(_mm_min_epu8(v, _mm_set1_epi8(31)), v);
+
+		m = _mm_or_si128(m, _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('&')), _mm_cmpeq_epi8(v, _mm_set1_epi8('<'))));
+
+		if (ctx == ctx_special_pcdata)
+		{
+			__m128i ws = _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('\t')), _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('\r')), _mm_cmpeq_epi8(v, _mm_set1_epi8('\n'))));
+
+			m = _mm_or_si128(_mm_andnot_si128(ws, m), _mm_cmpeq_epi8(v, _mm_set1_epi8('>')));
+		}
+		else
+			m = _mm_or_si128(m, _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('"')), _mm_cmpeq_epi8(v, _mm_set1_epi8('\''))));
+
+		return static_cast<unsigned int>(_mm_movemask_epi8(m));
+	}
+
+	template <int ctx> PUGI__FN PUGI__TARGET_AVX2 unsigned int simd_match_special_avx2(__m256i v)
+	{
+		// control characters, i.e. bytes up to 31 as unsigned
+		__m256i m = _mm256_cmpeq_epi8(_mm256_min_epu8(v, _mm256_set1_epi8(31)), v);
+
+		m = _mm256_or_si256(m, _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('&')), _mm256_cmpeq_epi8(v, _mm256_set1_epi8('<'))));
+
+		if (ctx == ctx_special_pcdata)
+		{
+			__m256i ws = _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('\t')), _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('\r')), _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\n'))));
+
+			m = _mm256_or_si256(_mm256_andnot_si256(ws, m), _mm256_cmpeq_epi8(v, _mm256_set1_epi8('>')));
+		}
+		else
+			m = _mm256_or_si256(m, _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('"')), _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\''))));
+
+		return static_cast<unsigned int>(_mm256_movemask_epi8(m));
+	}
+
+	// Returns the first character of s that is in ctx; s has to be zero-terminated, and zero is in both ctx types
+	template <int ctx> PUGI__FN PUGI__NO_SANITIZE_ADDRESS const char_t* simd_scan_special_sse2(const char_t* s)
+	{
+		size_t offset = reinterpret_cast<uintptr_t>(s) & 15;
+		const char_t* block = s - offset;
+
+		// the first block starts before s, so ignore the bytes in front of it
+		unsigned int mask = simd_match_special_sse2<ctx>(_mm_load_si128(reinterpret_cast<const __m128i*>(block))) >> offset;
+		if (mask) return s + __builtin_ctz(mask);
+
+		for (;;)
+		{
+			block += 16;
+
+			mask = simd_match_special_sse2<ctx>(_mm_load_si128(reinterpret_cast<const __m128i*>(block)));
+			if (mask) return block + __builtin_ctz(mask);
+		}
+	}
+
+	template <int ctx> PUGI__FN PUGI__NO_SANITIZE_ADDRESS PUGI__TARGET_AVX2 const char_t* simd_scan_special_avx2(const char_t* s)
+	{
+		size_t offset = reinterpret_cast<uintptr_t>(s) & 31;
+		const char_t* block = s - offset;
+
+		// the first block starts before s, so ignore the bytes in front of it
+		unsigned int mask = simd_match_special_avx2<ctx>(_mm256_load_si256(reinterpret_cast<const __m256i*>(block))) >> offset;
+		if (mask) return s + __builtin_ctz(mask);
+
+		for (;;)
+		{
+			block += 32;
+
+			mask = simd_match_special_avx2<ctx>(_mm256_load_si256(reinterpret_cast<const __m256i*>(block)));
+			if (mask) return block + __builtin_ctz(mask);
+		}
+	}
+
+	PUGI__FN const char_t* simd_scan_special(const char_t* s, chartypex_t type)
+	{
+		assert(type == ctx_special_pcdata || type == ctx_special_attr);
+
+		if (type == ctx_special_pcdata)
+			return simd_has_avx2() ? simd_scan_special_avx2<ctx_special_pcdata>(s) : simd_scan_special_sse2<ctx_special_pcdata>(s);
+		else
+			return simd_has_avx2() ? simd_scan_special_avx2<ctx_special_attr>(s) : simd_scan_special_sse2<ctx_special_attr>(s);
+	}
+#endif
+
 	PUGI__FN bool is_little_endian()
 	{
 		unsigned int ui = 1;
@@ -2213,13 +2519,98 @@ PUGI__NS_BEGIN
 		return true;
 	}
 
+#ifdef PUGI__SIMD
+	// utf8_counter and utf8_writer for a run of ascii characters
+	template <typename T> PUGI__FN size_t ascii_run(size_t result, const T*, size_t length, bool)
+	{
+		return result + length;
+	}
+
+	PUGI__FN uint8_t* ascii_run(uint8_t* result, const uint8_t* data, size_t length, bool)
+	{
+		memcpy(result, data, length);
+
+		return result + length;
+	}
+
+	PUGI__FN uint8_t* ascii_run(uint8_t* result, const uint16_t* data, size_t length, bool swap)
+	{
+		simd_narrow_ascii(result, data, length, swap);
+
+		return result + length;
+	}
+
+	PUGI__FN size_t ascii_length(const uint8_t* data, size_t size, bool)
+	{
+		return simd_ascii_length(data, size);
+	}
+
+	PUGI__FN size_t ascii_length(const uint16_t* data, size_t size, bool swap)
+	{
+		return simd_ascii_length(data, size, swap);
+	}
+
+	// Same as D::process, but ascii runs are copied in bulk and only the characters between them go through D; no character
+	// spans an ascii code unit, so splitting the input before each run does not change the result
+	template <typename D, typename Traits> PUGI__FN typename Traits::value_type process_ascii_runs(const typename D::type* data, size_t size, typename Traits::value_type result, Traits traits, bool swap)
+	{
+		while (size)
+		{
+			size_t length = ascii_length(data, size, swap);
+
+			result = ascii_run(result, data, length, swap);
+			data += length;
+			size -= length;
+
+			length = 0;
+			while (length < size && ascii_length(data + length, 1, swap) == 0)
+				++length;
+
+			result = D::process(data, length, result, traits);
+			data += length;
+			size -= length;
+		}
+
+		return result;
+	}
+
+	template <typename D> PUGI__FN bool convert_buffer_ascii_runs(char_t*& out_buffer, size_t& out_length, const void* contents, size_t size, D, bool swap)
+	{
+		const typename D::type* data = static_cast<const typename D::type*>(contents);
+		size_t data_length = size / sizeof(typename D::type);
+
+		// first pass: get length in utf8 units
+		size_t length = process_ascii_runs<D>(data, data_length, 0, utf8_counter(), swap);
+
+		// allocate buffer of suitable length
+		char_t* buffer = static_cast<char_t*>(xml_memory::allocate((length + 1) * sizeof(char_t)));
+		if (!buffer) return false;
+
+		// second pass: convert input to utf8
+		uint8_t* obegin = reinterpret_cast<uint8_t*>(buffer);
+		uint8_t* oend = process_ascii_runs<D>(data, data_length, obegin, utf8_writer(), swap);
+
+		assert(oend == obegin + length);
+		*oend = 0;
+
+		out_buffer = buffer;
+		out_length = length + 1;
+
+		return true;
+	}
+#endif
+
 	PUGI__FN size_t get_latin1_7bit_prefix_length(const uint8_t* data, size_t size)
 	{
+	#ifdef PUGI__SIMD
+		return simd_ascii_length(data, size);
+	#else
 		for (size_t i = 0; i < size; ++i)
 			if (data[i] > 127)
 				return i;
 
 		return size;
+	#endif
 	}
 
 	PUGI__FN bool convert_buffer_latin1(char_t*& out_buffer, size_t& out_length, const void* contents, size_t size, bool is_mutable)
@@ -2238,7 +2629,11 @@ PUGI__NS_BEGIN
 		if (postfix_length == 0) return get_mutable_buffer(out_buffer, out_length, contents, size, is_mutable);
 
 		// first pass: get length in utf8 units
+	#ifdef PUGI__SIMD
+		size_t length = prefix_length + process_ascii_runs<latin1_decoder>(postfix, postfix_length, 0, utf8_counter(), false);
+	#else
 		size_t length = prefix_length + latin1_decoder::process(postfix, postfix_length, 0, utf8_counter());
+	#endif
 
 		// allocate buffer of suitable length
 		char_t* buffer = static_cast<char_t*>(xml_memory::allocate((length + 1) * sizeof(char_t)));
@@ -2248,7 +2643,11 @@ PUGI__NS_BEGIN
 		memcpy(buffer, data, prefix_length);
 
 		uint8_t* obegin = reinterpret_cast<uint8_t*>(buffer);
+	#ifdef PUGI__SIMD
+		uint8_t* oend = process_ascii_runs<latin1_decoder>(postfix, postfix_length, obegin + prefix_length, utf8_writer(), false);
+	#else
 		uint8_t* oend = latin1_decoder::process(postfix, postfix_length, obegin + prefix_length, utf8_writer());
+	#endif
 
 		assert(oend == obegin + length);
 		*oend = 0;
@@ -2270,9 +2669,15 @@ PUGI__NS_BEGIN
 		{
 			xml_encoding native_encoding = is_little_endian() ? encoding_utf16_le : encoding_utf16_be;
 
+		#ifdef PUGI__SIMD
+			return (native_encoding == encoding) ?
+				convert_buffer_ascii_runs(out_buffer, out_length, contents, size, utf16_decoder<opt_false>(), false) :
+				convert_buffer_ascii_runs(out_buffer, out_length, contents, size, utf16_decoder<opt_true>(), true);
+		#else
 			return (native_encoding == encoding) ?
 				convert_buffer_generic(out_buffer, out_length, contents, size, utf16_decoder<opt_false>()) :
 				convert_buffer_generic(out_buffer, out_length, contents, size, utf16_decoder<opt_true>());
+		#endif
 		}
 
 		// source encoding is utf32
@@ -2604,11 +3009,16 @@ PUGI__NS_BEGIN
 	#define PUGI__ENDSWITH(c, e)        ((c) == (e) || ((c) == 0 && endch == (e)))
 	#define PUGI__SKIPWS()              { while (PUGI__IS_CHARTYPE(*s, ct_space)) ++s; }
 	#define PUGI__OPTSET(OPT)           ( optmsk & (OPT) )
-	#define PUGI__PUSHNODE(TYPE)        { cursor = append_new_node(cursor, *alloc, TYPE); if (!cursor) PUGI__THROW_ERROR(status_out_of_memory, s); }
-	#define PUGI__POPNODE()             { cursor = cursor->parent; }
+	#define PUGI__BUILD(CALL, m)        { xml_parse_status status = builder.CALL; if (status != status_ok) PUGI__THROW_ERROR(status, m); }
+	#define PUGI__STOPATEND(c, end)     { if ((c) && PUGI__OPTSET(parse_stop_at_end)) return document_end = (end); }
 	#define PUGI__SCANFOR(X)            { while (*s != 0 && !(X)) ++s; }
 	#define PUGI__SCANWHILE(X)          { while (X) ++s; }
 	#define PUGI__SCANWHILE_UNROLL(X)   { for (;;) { char_t ss = s[0]; if (PUGI__UNLIKELY(!(X))) { break; } ss = s[1]; if (PUGI__UNLIKELY(!(X))) { s += 1; break; } ss = s[2]; if (PUGI__UNLIKELY(!(X))) { s += 2; break; } ss = s[3]; if (PUGI__UNLIKELY(!(X))) { s += 3; break; } s += 4; } }
+#ifdef PUGI__SIMD
+	#define PUGI__SCANUNTIL_CHARTYPE(ct) { s = simd_scan<ct>(s); }
+#else
+	#define PUGI__SCANUNTIL_CHARTYPE(ct) PUGI__SCANWHILE_UNROLL(!PUGI__IS_CHARTYPE(ss, ct))
+#endif
 	#define PUGI__ENDSEG()              { ch = *s; *s = 0; ++s; }
 	#define PUGI__THROW_ERROR(err, m)   return error_offset = m, error_status = err, static_cast<char_t*>(0)
 	#define PUGI__CHECK_ERROR(err, m)   { if (*s == 0) PUGI__THROW_ERROR(err, m); }
@@ -2681,7 +3091,7 @@ PUGI__NS_BEGIN
 
 			while (true)
 			{
-				PUGI__SCANWHILE_UNROLL(!PUGI__IS_CHARTYPE(ss, ct_parse_pcdata));
+				PUGI__SCANUNTIL_CHARTYPE(ct_parse_pcdata);
 
 				if (*s == '<') // PCDATA ends here
 				{
@@ -2761,7 +3171,7 @@ PUGI__NS_BEGIN
 
 			while (true)
 			{
-				PUGI__SCANWHILE_UNROLL(!PUGI__IS_CHARTYPE(ss, ct_parse_attr_ws | ct_space));
+				PUGI__SCANUNTIL_CHARTYPE(ct_parse_attr_ws | ct_space);
 
 				if (*s == end_quote)
 				{
@@ -2802,7 +3212,7 @@ PUGI__NS_BEGIN
 
 			while (true)
 			{
-				PUGI__SCANWHILE_UNROLL(!PUGI__IS_CHARTYPE(ss, ct_parse_attr_ws));
+				PUGI__SCANUNTIL_CHARTYPE(ct_parse_attr_ws);
 
 				if (*s == end_quote)
 				{
@@ -2838,7 +3248,7 @@ PUGI__NS_BEGIN
 
 			while (true)
 			{
-				PUGI__SCANWHILE_UNROLL(!PUGI__IS_CHARTYPE(ss, ct_parse_attr));
+				PUGI__SCANUNTIL_CHARTYPE(ct_parse_attr);
 
 				if (*s == end_quote)
 				{
@@ -2870,7 +3280,7 @@ PUGI__NS_BEGIN
 
 			while (true)
 			{
-				PUGI__SCANWHILE_UNROLL(!PUGI__IS_CHARTYPE(ss, ct_parse_attr));
+				PUGI__SCANUNTIL_CHARTYPE(ct_parse_attr);
 
 				if (*s == end_quote)
 				{
@@ -2889,53 +3299,306 @@ PUGI__NS_BEGIN
 				else ++s;
 			}
 		}
-	};
+	};
+
+	PUGI__FN strconv_attribute_t get_strconv_attribute(unsigned int optmask)
+	{
+		PUGI__STATIC_ASSERT(parse_escapes == 0x10 && parse_eol == 0x20 && parse_wconv_attribute == 0x40 && parse_wnorm_attribute == 0x80);
+
+		switch ((optmask >> 4) & 15) // get bitmask for flags (wnorm wconv eol escapes); this simultaneously checks 4 options from assertion above
+		{
+		case 0:  return strconv_attribute_impl<opt_false>::parse_simple;
+		case 1:  return strconv_attribute_impl<opt_true>::parse_simple;
+		case 2:  return strconv_attribute_impl<opt_false>::parse_eol;
+		case 3:  return strconv_attribute_impl<opt_true>::parse_eol;
+		case 4:  return strconv_attribute_impl<opt_false>::parse_wconv;
+		case 5:  return strconv_attribute_impl<opt_true>::parse_wconv;
+		case 6:  return strconv_attribute_impl<opt_false>::parse_wconv;
+		case 7:  return strconv_attribute_impl<opt_true>::parse_wconv;
+		case 8:  return strconv_attribute_impl<opt_false>::parse_wnorm;
+		case 9:  return strconv_attribute_impl<opt_true>::parse_wnorm;
+		case 10: return strconv_attribute_impl<opt_false>::parse_wnorm;
+		case 11: return strconv_attribute_impl<opt_true>::parse_wnorm;
+		case 12: return strconv_attribute_impl<opt_false>::parse_wnorm;
+		case 13: return strconv_attribute_impl<opt_true>::parse_wnorm;
+		case 14: return strconv_attribute_impl<opt_false>::parse_wnorm;
+		case 15: return strconv_attribute_impl<opt_true>::parse_wnorm;
+		default: assert(false); return 0; // unreachable
+		}
+	}
+
+	inline xml_parse_result make_parse_result(xml_parse_status status, ptrdiff_t offset = 0)
+	{
+		xml_parse_result result;
+		result.status = status;
+		result.offset = offset;
+
+		return result;
+	}
+
+	// Builds the document tree under root out of what xml_parser scans
+	struct xml_tree_builder
+	{
+		xml_allocator* alloc;
+		xml_node_struct* root;
+		xml_node_struct* cursor;
+		xml_attribute_struct* attribute;
+
+		// last child of the root before parsing, so that only the children parsed are looked at by has_element
+		xml_node_struct* last_root_child;
+
+		xml_tree_builder(xml_allocator* alloc_, xml_node_struct* root_): alloc(alloc_), root(root_), cursor(root_), attribute(0), last_root_child(root_->first_child ? root_->first_child->prev_sibling_c + 0 : 0)
+		{
+		}
+
+		xml_node_type current_type() const
+		{
+			return PUGI__NODETYPE(cursor);
+		}
+
+		char_t* current_name() const
+		{
+			return cursor->name;
+		}
+
+		bool at_root() const
+		{
+			return cursor == root;
+		}
+
+		bool at_document() const
+		{
+			return !cursor->parent;
+		}
+
+		bool has_children() const
+		{
+			return cursor->first_child != 0;
+		}
+
+		xml_parse_status open(xml_node_type type, char_t* name)
+		{
+			xml_node_struct* child = append_new_node(cursor, *alloc, type);
+			if (!child) return status_out_of_memory;
+
+			child->name = name;
+			cursor = child;
+
+			return status_ok;
+		}
+
+		void set_value(char_t* value)
+		{
+			cursor->value = value;
+		}
+
+		xml_parse_status close()
+		{
+			cursor = cursor->parent;
+
+			return status_ok;
+		}
+
+		xml_parse_status close_value()
+		{
+			cursor = cursor->parent;
+
+			return status_ok;
+		}
+
+		// stores character data in the element itself (for parse_embed_pcdata) if it is the first thing in it
+		bool embed_value(char_t* value)
+		{
+			if (!cursor->parent || cursor->first_child || cursor->value) return false;
+
+			cursor->value = value;
+
+			return true;
+		}
+
+		xml_parse_status open_attribute(char_t* name)
+		{
+			attribute = append_new_attribute(cursor, *alloc);
+			if (!attribute) return status_out_of_memory;
+
+			attribute->name = name;
+
+			return status_ok;
+		}
+
+		void set_attribute_value(char_t* value)
+		{
+			attribute->value = value;
+		}
+
+		xml_parse_status close_attribute()
+		{
+			return status_ok;
+		}
+
+		bool has_element() const
+		{
+			for (xml_node_struct* node = last_root_child ? last_root_child->next_sibling : root->first_child; node; node = node->next_sibling)
+				if (PUGI__NODETYPE(node) == node_element) return true;
+
+			return false;
+		}
+	};
+
+	// Reports what xml_parser scans to the handler of parse_sax_inplace instead of building a tree
+	struct xml_sax_builder
+	{
+		xml_sax_handler* handler;
+
+		// names of the open elements, needed to match end tags since there is no tree to remember them by
+		char_t* inline_names[32];
+		char_t** names;
+		size_t capacity;
+		size_t depth;
+
+		// character data or CDATA section being scanned, reported once it is zero-terminated
+		xml_node_type value_type;
+		char_t* value;
+
+		char_t* attribute_name;
+		char_t* attribute_value;
+
+		// whether the innermost open element has no children yet (for parse_ws_pcdata_single)
+		bool childless;
+
+		bool element_seen;
+
+		xml_sax_builder(xml_sax_handler* handler_): handler(handler_), names(inline_names), capacity(sizeof(inline_names) / sizeof(inline_names[0])), depth(0), value_type(node_null), value(0), attribute_name(0), attribute_value(0), childless(false), element_seen(false)
+		{
+		}
+
+		~xml_sax_builder()
+		{
+			if (names != inline_names) xml_memory::deallocate(names);
+		}
+
+		xml_node_type current_type() const
+		{
+			return depth ? node_element : node_document;
+		}
+
+		char_t* current_name() const
+		{
+			return depth ? names[depth - 1] : 0;
+		}
+
+		bool at_root() const
+		{
+			return depth == 0;
+		}
+
+		bool at_document() const
+		{
+			return depth == 0;
+		}
+
+		bool has_children() const
+		{
+			return !childless;
+		}
+
+		bool push_name(char_t* name)
+		{
+			if (depth == capacity)
+			{
+				char_t** grown = static_cast<char_t**>(xml_memory::allocate(capacity * 2 * sizeof(char_t*)));
+				if (!grown) return false;
+
+				memcpy(grown, names, depth * sizeof(char_t*));
+
+				if (names != inline_names) xml_memory::deallocate(names);
+
+				names = grown;
+				capacity *= 2;
+			}
+
+			names[depth++] = name;
+			childless = true;
+			element_seen = true;
+
+			return true;
+		}
+
+		// parse_sax strips the options of every node but elements, character data and CDATA sections, so no other type is opened
+		xml_parse_status open(xml_node_type type, char_t* name)
+		{
+			childless = false;
+
+			if (type != node_element)
+			{
+				value_type = type;
+
+				return status_ok;
+			}
+
+			if (!push_name(name)) return status_out_of_memory;
+
+			return handler->start_element(name) ? status_ok : status_aborted;
+		}
+
+		void set_value(char_t* value_)
+		{
+			value = value_;
+		}
+
+		xml_parse_status close()
+		{
+			depth--;
+			childless = false;
+
+			return handler->end_element(names[depth]) ? status_ok : status_aborted;
+		}
+
+		xml_parse_status close_value()
+		{
+			bool proceed = value_type == node_cdata ? handler->cdata(value) : handler->text(value);
+
+			return proceed ? status_ok : status_aborted;
+		}
 
-	PUGI__FN strconv_attribute_t get_strconv_attribute(unsigned int optmask)
-	{
-		PUGI__STATIC_ASSERT(parse_escapes == 0x10 && parse_eol == 0x20 && parse_wconv_attribute == 0x40 && parse_wnorm_attribute == 0x80);
+		bool embed_value(char_t*)
+		{
+			return false;
+		}
 
-		switch ((optmask >> 4) & 15) // get bitmask for flags (wnorm wconv eol escapes); this simultaneously checks 4 options from assertion above
+		xml_parse_status open_attribute(char_t* name)
 		{
-		case 0:  return strconv_attribute_impl<opt_false>::parse_simple;
-		case 1:  return strconv_attribute_impl<opt_true>::parse_simple;
-		case 2:  return strconv_attribute_impl<opt_false>::parse_eol;
-		case 3:  return strconv_attribute_impl<opt_true>::parse_eol;
-		case 4:  return strconv_attribute_impl<opt_false>::parse_wconv;
-		case 5:  return strconv_attribute_impl<opt_true>::parse_wconv;
-		case 6:  return strconv_attribute_impl<opt_false>::parse_wconv;
-		case 7:  return strconv_attribute_impl<opt_true>::parse_wconv;
-		case 8:  return strconv_attribute_impl<opt_false>::parse_wnorm;
-		case 9:  return strconv_attribute_impl<opt_true>::parse_wnorm;
-		case 10: return strconv_attribute_impl<opt_false>::parse_wnorm;
-		case 11: return strconv_attribute_impl<opt_true>::parse_wnorm;
-		case 12: return strconv_attribute_impl<opt_false>::parse_wnorm;
-		case 13: return strconv_attribute_impl<opt_true>::parse_wnorm;
-		case 14: return strconv_attribute_impl<opt_false>::parse_wnorm;
-		case 15: return strconv_attribute_impl<opt_true>::parse_wnorm;
-		default: assert(false); return 0; // unreachable
+			attribute_name = name;
+
+			return status_ok;
 		}
-	}
 
-	inline xml_parse_result make_parse_result(xml_parse_status status, ptrdiff_t offset = 0)
-	{
-		xml_parse_result result;
-		result.status = status;
-		result.offset = offset;
+		void set_attribute_value(char_t* value_)
+		{
+			attribute_value = value_;
+		}
 
-		return result;
-	}
+		xml_parse_status close_attribute()
+		{
+			return handler->attribute(attribute_name, attribute_value) ? status_ok : status_aborted;
+		}
+
+		bool has_element() const
+		{
+			return element_seen;
+		}
+	};
 
+	// Scans a document, and hands each node to a builder: xml_tree_builder or xml_sax_builder
 	struct xml_parser
 	{
-		xml_allocator* alloc;
 		char_t* error_offset;
 		xml_parse_status error_status;
+		char_t* document_end;
 
-		xml_parser(xml_allocator* alloc_): alloc(alloc_), error_offset(0), error_status(status_ok)
+		xml_parser(): error_offset(0), error_status(status_ok), document_end(0)
 		{
 		}
-
 		// DOCTYPE consists of nested sections of the following possible types:
 		// <!-- ... -->, <? ... ?>, "...", '...'
 		// <![...]]>
@@ -3053,7 +3716,7 @@ PUGI__NS_BEGIN
 			return s;
 		}
 
-		char_t* parse_exclamation(char_t* s, xml_node_struct* cursor, unsigned int optmsk, char_t endch)
+		template <typename Builder> char_t* parse_exclamation(char_t* s, Builder& builder, unsigned int optmsk, char_t endch)
 		{
 			// parse node contents, starting with exclamation mark
 			++s;
@@ -3066,17 +3729,19 @@ PUGI__NS_BEGIN
 				{
 					++s;
 
+					char_t* value = s;
+
 					if (PUGI__OPTSET(parse_comments))
 					{
-						PUGI__PUSHNODE(node_comment); // Append a new node on the tree.
-						cursor->value = s; // Save the offset.
+						PUGI__BUILD(open(node_comment, 0), s); // Append a new node on the tree.
+						builder.set_value(s); // Save the offset.
 					}
 
 					if (PUGI__OPTSET(parse_eol) && PUGI__OPTSET(parse_comments))
 					{
 						s = strconv_comment(s, endch);
 
-						if (!s) PUGI__THROW_ERROR(status_bad_comment, cursor->value);
+						if (!s) PUGI__THROW_ERROR(status_bad_comment, value);
 					}
 					else
 					{
@@ -3089,6 +3754,9 @@ PUGI__NS_BEGIN
 
 						s += (s[2] == '>' ? 3 : 2); // Step over the '\0->'.
 					}
+
+					if (PUGI__OPTSET(parse_comments))
+						PUGI__BUILD(close_value(), value);
 				}
 				else PUGI__THROW_ERROR(status_bad_comment, s);
 			}
@@ -3101,14 +3769,16 @@ PUGI__NS_BEGIN
 
 					if (PUGI__OPTSET(parse_cdata))
 					{
-						PUGI__PUSHNODE(node_cdata); // Append a new node on the tree.
-						cursor->value = s; // Save the offset.
+						char_t* value = s;
+
+						PUGI__BUILD(open(node_cdata, 0), s); // Append a new node on the tree.
+						builder.set_value(s); // Save the offset.
 
 						if (PUGI__OPTSET(parse_eol))
 						{
 							s = strconv_cdata(s, endch);
 
-							if (!s) PUGI__THROW_ERROR(status_bad_cdata, cursor->value);
+							if (!s) PUGI__THROW_ERROR(status_bad_cdata, value);
 						}
 						else
 						{
@@ -3118,6 +3788,8 @@ PUGI__NS_BEGIN
 
 							*s++ = 0; // Zero-terminate this segment.
 						}
+
+						PUGI__BUILD(close_value(), value);
 					}
 					else // Flagged for discard, but we still have to scan for the terminator.
 					{
@@ -3136,7 +3808,7 @@ PUGI__NS_BEGIN
 			{
 				s -= 2;
 
-				if (cursor->parent) PUGI__THROW_ERROR(status_bad_doctype, s);
+				if (!builder.at_document()) PUGI__THROW_ERROR(status_bad_doctype, s);
 
 				char_t* mark = s + 9;
 
@@ -3150,9 +3822,11 @@ PUGI__NS_BEGIN
 				{
 					while (PUGI__IS_CHARTYPE(*mark, ct_space)) ++mark;
 
-					PUGI__PUSHNODE(node_doctype);
+					PUGI__BUILD(open(node_doctype, 0), s);
+
+					builder.set_value(mark);
 
-					cursor->value = mark;
+					PUGI__BUILD(close_value(), s);
 				}
 			}
 			else if (*s == 0 && endch == '-') PUGI__THROW_ERROR(status_bad_comment, s);
@@ -3162,10 +3836,8 @@ PUGI__NS_BEGIN
 			return s;
 		}
 
-		char_t* parse_question(char_t* s, xml_node_struct*& ref_cursor, unsigned int optmsk, char_t endch)
+		template <typename Builder> char_t* parse_question(char_t* s, Builder& builder, unsigned int optmsk, char_t endch)
 		{
-			// load into registers
-			xml_node_struct* cursor = ref_cursor;
 			char_t ch = 0;
 
 			// parse node contents, starting with question mark
@@ -3187,17 +3859,15 @@ PUGI__NS_BEGIN
 				if (declaration)
 				{
 					// disallow non top-level declarations
-					if (cursor->parent) PUGI__THROW_ERROR(status_bad_pi, s);
+					if (!builder.at_document()) PUGI__THROW_ERROR(status_bad_pi, s);
 
-					PUGI__PUSHNODE(node_declaration);
+					PUGI__BUILD(open(node_declaration, target), s);
 				}
 				else
 				{
-					PUGI__PUSHNODE(node_pi);
+					PUGI__BUILD(open(node_pi, target), s);
 				}
 
-				cursor->name = target;
-
 				PUGI__ENDSEG();
 
 				// parse value/attributes
@@ -3207,7 +3877,14 @@ PUGI__NS_BEGIN
 					if (!PUGI__ENDSWITH(*s, '>')) PUGI__THROW_ERROR(status_bad_pi, s);
 					s += (*s == '>');
 
-					PUGI__POPNODE();
+					if (declaration)
+					{
+						PUGI__BUILD(close(), target);
+					}
+					else
+					{
+						PUGI__BUILD(close_value(), target);
+					}
 				}
 				else if (PUGI__IS_CHARTYPE(ch, ct_space))
 				{
@@ -3224,15 +3901,15 @@ PUGI__NS_BEGIN
 						// replace ending ? with / so that 'element' terminates properly
 						*s = '/';
 
-						// we exit from this function with cursor at node_declaration, which is a signal to parse() to go to LOC_ATTRIBUTES
+						// we exit from this function with the declaration open, which is a signal to parse_tree() to go to LOC_ATTRIBUTES
 						s = value;
 					}
 					else
 					{
 						// store value and step over >
-						cursor->value = value;
+						builder.set_value(value);
 
-						PUGI__POPNODE();
+						PUGI__BUILD(close_value(), target);
 
 						PUGI__ENDSEG();
 
@@ -3250,19 +3927,15 @@ PUGI__NS_BEGIN
 				s += (s[1] == '>' ? 2 : 1);
 			}
 
-			// store from registers
-			ref_cursor = cursor;
-
 			return s;
 		}
 
-		char_t* parse_tree(char_t* s, xml_node_struct* root, unsigned int optmsk, char_t endch)
+		template <typename Builder> char_t* parse_tree(char_t* s, Builder& builder, unsigned int optmsk, char_t endch)
 		{
 			strconv_attribute_t strconv_attribute = get_strconv_attribute(optmsk);
 			strconv_pcdata_t strconv_pcdata = get_strconv_pcdata(optmsk);
 
 			char_t ch = 0;
-			xml_node_struct* cursor = root;
 			char_t* mark = s;
 
 			while (*s != 0)
@@ -3274,13 +3947,13 @@ PUGI__NS_BEGIN
 				LOC_TAG:
 					if (PUGI__IS_CHARTYPE(*s, ct_start_symbol)) // '<#...'
 					{
-						PUGI__PUSHNODE(node_element); // Append a new node to the tree.
-
-						cursor->name = s;
+						mark = s; // Save the name.
 
 						PUGI__SCANWHILE_UNROLL(PUGI__IS_CHARTYPE(ss, ct_symbol)); // Scan for a terminator.
 						PUGI__ENDSEG(); // Save char in 'ch', terminate & step over.
 
+						PUGI__BUILD(open(node_element, mark), mark); // Append a new node to the tree.
+
 						if (ch == '>')
 						{
 							// end of tag
@@ -3294,10 +3967,9 @@ PUGI__NS_BEGIN
 
 								if (PUGI__IS_CHARTYPE(*s, ct_start_symbol)) // <... #...
 								{
-									xml_attribute_struct* a = append_new_attribute(cursor, *alloc); // Make space for this attribute.
-									if (!a) PUGI__THROW_ERROR(status_out_of_memory, s);
+									char_t* name = s; // Save the offset.
 
-									a->name = s; // Save the offset.
+									PUGI__BUILD(open_attribute(name), name); // Make space for this attribute.
 
 									PUGI__SCANWHILE_UNROLL(PUGI__IS_CHARTYPE(ss, ct_symbol)); // Scan for a terminator.
 									PUGI__ENDSEG(); // Save char in 'ch', terminate & step over.
@@ -3318,16 +3990,21 @@ PUGI__NS_BEGIN
 										{
 											ch = *s; // Save quote char to avoid breaking on "''" -or- '""'.
 											++s; // Step over the quote.
-											a->value = s; // Save the offset.
+
+											char_t* value = s;
+
+											builder.set_attribute_value(value); // Save the offset.
 
 											s = strconv_attribute(s, ch);
 
-											if (!s) PUGI__THROW_ERROR(status_bad_attribute, a->value);
+											if (!s) PUGI__THROW_ERROR(status_bad_attribute, value);
 
 											// After this line the loop continues from the start;
 											// Whitespaces, / and > are ok, symbols and EOF are wrong,
 											// everything else will be detected
 											if (PUGI__IS_CHARTYPE(*s, ct_start_symbol)) PUGI__THROW_ERROR(status_bad_attribute, s);
+
+											PUGI__BUILD(close_attribute(), name);
 										}
 										else PUGI__THROW_ERROR(status_bad_attribute, s);
 									}
@@ -3337,15 +4014,20 @@ PUGI__NS_BEGIN
 								{
 									++s;
 
+									// the attributes may be those of a declaration, which is no document element to stop after
+									bool element = builder.current_type() == node_element;
+
 									if (*s == '>')
 									{
-										PUGI__POPNODE();
+										PUGI__BUILD(close(), s);
+										PUGI__STOPATEND(element && builder.at_root(), s + 1);
 										s++;
 										break;
 									}
 									else if (*s == 0 && endch == '>')
 									{
-										PUGI__POPNODE();
+										PUGI__BUILD(close(), s);
+										PUGI__STOPATEND(element && builder.at_root(), s + 1);
 										break;
 									}
 									else PUGI__THROW_ERROR(status_bad_start_element, s);
@@ -3369,7 +4051,8 @@ PUGI__NS_BEGIN
 						{
 							if (!PUGI__ENDSWITH(*s, '>')) PUGI__THROW_ERROR(status_bad_start_element, s);
 
-							PUGI__POPNODE(); // Pop.
+							PUGI__BUILD(close(), s); // Pop.
+							PUGI__STOPATEND(builder.at_root(), s + 1);
 
 							s += (*s == '>');
 						}
@@ -3388,7 +4071,7 @@ PUGI__NS_BEGIN
 
 						mark = s;
 
-						char_t* name = cursor->name;
+						char_t* name = builder.current_name();
 						if (!name) PUGI__THROW_ERROR(status_end_element_mismatch, mark);
 
 						while (PUGI__IS_CHARTYPE(*s, ct_symbol))
@@ -3402,31 +4085,34 @@ PUGI__NS_BEGIN
 							else PUGI__THROW_ERROR(status_end_element_mismatch, mark);
 						}
 
-						PUGI__POPNODE(); // Pop.
+						PUGI__BUILD(close(), mark); // Pop.
 
 						PUGI__SKIPWS();
 
 						if (*s == 0)
 						{
 							if (endch != '>') PUGI__THROW_ERROR(status_bad_end_element, s);
+
+							PUGI__STOPATEND(builder.at_root(), s + 1);
 						}
 						else
 						{
 							if (*s != '>') PUGI__THROW_ERROR(status_bad_end_element, s);
 							++s;
+
+							PUGI__STOPATEND(builder.at_root(), s);
 						}
 					}
 					else if (*s == '?') // '<?...'
 					{
-						s = parse_question(s, cursor, optmsk, endch);
+						s = parse_question(s, builder, optmsk, endch);
 						if (!s) return s;
 
-						assert(cursor);
-						if (PUGI__NODETYPE(cursor) == node_declaration) goto LOC_ATTRIBUTES;
+						if (builder.current_type() == node_declaration) goto LOC_ATTRIBUTES;
 					}
 					else if (*s == '!') // '<!...'
 					{
-						s = parse_exclamation(s, cursor, optmsk, endch);
+						s = parse_exclamation(s, builder, optmsk, endch);
 						if (!s) return s;
 					}
 					else if (*s == 0 && endch == '?') PUGI__THROW_ERROR(status_bad_pi, s);
@@ -3449,29 +4135,31 @@ PUGI__NS_BEGIN
 						}
 						else if (PUGI__OPTSET(parse_ws_pcdata_single))
 						{
-							if (s[0] != '<' || s[1] != '/' || cursor->first_child) continue;
+							if (s[0] != '<' || s[1] != '/' || builder.has_children()) continue;
 						}
 					}
 
 					if (!PUGI__OPTSET(parse_trim_pcdata))
 						s = mark;
 
-					if (cursor->parent || PUGI__OPTSET(parse_fragment))
+					if (!builder.at_document() || PUGI__OPTSET(parse_fragment))
 					{
-						if (PUGI__OPTSET(parse_embed_pcdata) && cursor->parent && !cursor->first_child && !cursor->value)
+						mark = s; // Save the offset.
+
+						if (PUGI__OPTSET(parse_embed_pcdata) && builder.embed_value(s))
 						{
-							cursor->value = s; // Save the offset.
+							s = strconv_pcdata(s);
 						}
 						else
 						{
-							PUGI__PUSHNODE(node_pcdata); // Append a new node on the tree.
+							PUGI__BUILD(open(node_pcdata, 0), s); // Append a new node on the tree.
 
-							cursor->value = s; // Save the offset.
+							builder.set_value(s);
 
-							PUGI__POPNODE(); // Pop since this is a standalone.
-						}
+							s = strconv_pcdata(s);
 
-						s = strconv_pcdata(s);
+							PUGI__BUILD(close_value(), mark); // Pop since this is a standalone.
+						}
 
 						if (!*s) break;
 					}
@@ -3489,11 +4177,10 @@ PUGI__NS_BEGIN
 			}
 
 			// check that last tag is closed
-			if (cursor != root) PUGI__THROW_ERROR(status_end_element_mismatch, s);
+			if (!builder.at_root()) PUGI__THROW_ERROR(status_end_element_mismatch, s);
 
 			return s;
 		}
-
 	#ifdef PUGIXML_WCHAR_MODE
 		static char_t* parse_skip_bom(char_t* s)
 		{
@@ -3507,29 +4194,14 @@ PUGI__NS_BEGIN
 		}
 	#endif
 
-		static bool has_element_node_siblings(xml_node_struct* node)
-		{
-			while (node)
-			{
-				if (PUGI__NODETYPE(node) == node_element) return true;
-
-				node = node->next_sibling;
-			}
-
-			return false;
-		}
-
-		static xml_parse_result parse(char_t* buffer, size_t length, xml_document_struct* xmldoc, xml_node_struct* root, unsigned int optmsk)
+		template <typename Builder> static xml_parse_result parse_buffer(char_t* buffer, size_t length, Builder& builder, unsigned int optmsk)
 		{
 			// early-out for empty documents
 			if (length == 0)
 				return make_parse_result(PUGI__OPTSET(parse_fragment) ? status_ok : status_no_document_element);
 
-			// get last child of the root before parsing
-			xml_node_struct* last_root_child = root->first_child ? root->first_child->prev_sibling_c + 0 : 0;
-
 			// create parser on stack
-			xml_parser parser(static_cast<xml_allocator*>(xmldoc));
+			xml_parser parser;
 
 			// save last character and make buffer zero-terminated (speeds up parsing)
 			char_t endch = buffer[length - 1];
@@ -3539,21 +4211,27 @@ PUGI__NS_BEGIN
 			char_t* buffer_data = parse_skip_bom(buffer);
 
 			// perform actual parsing
-			parser.parse_tree(buffer_data, root, optmsk, endch);
+			parser.parse_tree(buffer_data, builder, optmsk, endch);
 
 			xml_parse_result result = make_parse_result(parser.error_status, parser.error_offset ? parser.error_offset - buffer : 0);
 			assert(result.offset >= 0 && static_cast<size_t>(result.offset) <= length);
 
-			if (result)
+			if (result && parser.document_end)
+			{
+				// stopped at the end of the document element, so the rest of the buffer (including its last character,
+				// unless the document ends there) is left for whatever follows
+				if (parser.document_end < buffer + length) buffer[length - 1] = endch;
+
+				result.offset = parser.document_end - buffer;
+			}
+			else if (result)
 			{
 				// since we removed last character, we have to handle the only possible false positive (stray <)
 				if (endch == '<')
 					return make_parse_result(status_unrecognized_tag, length - 1);
 
 				// check if there are any element nodes parsed
-				xml_node_struct* first_root_child_parsed = last_root_child ? last_root_child->next_sibling + 0 : root->first_child+ 0;
-
-				if (!PUGI__OPTSET(parse_fragment) && !has_element_node_siblings(first_root_child_parsed))
+				if (!PUGI__OPTSET(parse_fragment) && !builder.has_element())
 					return make_parse_result(status_no_document_element, length - 1);
 			}
 			else
@@ -3565,6 +4243,41 @@ PUGI__NS_BEGIN
 
 			return result;
 		}
+
+		static xml_parse_result parse(char_t* buffer, size_t length, xml_document_struct* xmldoc, xml_node_struct* root, unsigned int optmsk)
+		{
+			xml_tree_builder builder(static_cast<xml_allocator*>(xmldoc), root);
+
+			return parse_buffer(buffer, length, builder, optmsk);
+		}
+
+		static xml_parse_result parse_sax(char_t* buffer, size_t length, xml_sax_handler* handler, unsigned int optmsk)
+		{
+			// nodes that are never reported are skipped as if they were not asked for
+			optmsk &= ~(parse_comments | parse_declaration | parse_doctype | parse_pi);
+
+			xml_sax_builder builder(handler);
+
+			return parse_buffer(buffer, length, builder, optmsk);
+		}
+	};
+
+	// States of xml_incremental_parser; each names what the next byte belongs to
+	enum incremental_state_t
+	{
+		incremental_text,			// Character data, or whitespace outside of the root element
+		incremental_bom,			// UTF-8 BOM
+		incremental_markup,			// First byte after <
+		incremental_bang,			// First byte after <!
+		incremental_comment_open,	// Second dash of <!--
+		incremental_comment,		// Comment
+		incremental_cdata,			// CDATA section
+		incremental_pi,				// Processing instruction or declaration
+		incremental_declaration,	// Document type declaration
+		incremental_start_tag,		// Start tag
+		incremental_end_tag,		// End tag
+		incremental_done,			// The document is complete
+		incremental_failed			// The document cannot be completed
 	};
 
 	// Output facilities
@@ -3927,7 +4640,11 @@ PUGI__NS_BEGIN
 			const char_t* prev = s;
 
 			// While *s is a usual symbol
+		#ifdef PUGI__SIMD
+			s = simd_scan_special(s, type);
+		#else
 			PUGI__SCANWHILE_UNROLL(!PUGI__IS_CHARTYPEX(ss, type));
+		#endif
 
 			writer.write_buffer(prev, static_cast<size_t>(s - prev));
 
@@ -5151,6 +5868,35 @@ namespace pugi
 		return true;
 	}
 
+	PUGI__FN xml_sax_handler::~xml_sax_handler()
+	{
+	}
+
+	PUGI__FN bool xml_sax_handler::start_element(const char_t*)
+	{
+		return true;
+	}
+
+	PUGI__FN bool xml_sax_handler::attribute(const char_t*, const char_t*)
+	{
+		return true;
+	}
+
+	PUGI__FN bool xml_sax_handler::end_element(const char_t*)
+	{
+		return true;
+	}
+
+	PUGI__FN bool xml_sax_handler::text(const char_t*)
+	{
+		return true;
+	}
+
+	PUGI__FN bool xml_sax_handler::cdata(const char_t*)
+	{
+		return true;
+	}
+
 	PUGI__FN xml_attribute::xml_attribute(): _attr(0)
 	{
 	}
@@ -7061,6 +7807,8 @@ namespace pugi
 
 		case status_no_document_element: return "No document element found";
 
+		case status_aborted: return "Parsing was stopped by a callback";
+
 		default: return "Unknown error";
 		}
 	}
@@ -7096,8 +7844,53 @@ namespace pugi
 
 	PUGI__FN void xml_document::reset()
 	{
+		reset(static_cast<impl::xml_document_struct*>(_root)->_keep_pages);
+	}
+
+	PUGI__FN void xml_document::reset(bool keep_pages)
+	{
+		impl::xml_document_struct* doc = static_cast<impl::xml_document_struct*>(_root);
+
+		// detach the spare pages so that _destroy leaves them alone, then add the pages in use to them
+		impl::xml_memory_page* spare_pages = doc->_spare_pages;
+		doc->_spare_pages = 0;
+
+		if (keep_pages)
+		{
+			impl::xml_memory_page* root_page = PUGI__GETPAGE(_root);
+
+			for (impl::xml_memory_page* page = root_page->next; page; )
+			{
+				impl::xml_memory_page* next = page->next;
+
+				if (page->data_size == impl::xml_memory_page_size)
+				{
+					page->next = spare_pages;
+					spare_pages = page;
+				}
+				else
+				{
+					impl::xml_allocator::deallocate_page(page);
+				}
+
+				page = next;
+			}
+
+			root_page->next = 0;
+		}
+		else
+		{
+			doc->_spare_pages = spare_pages;
+			doc->deallocate_spare_pages();
+			spare_pages = 0;
+		}
+
 		_destroy();
 		_create();
+
+		doc = static_cast<impl::xml_document_struct*>(_root);
+		doc->_spare_pages = spare_pages;
+		doc->_keep_pages = keep_pages;
 	}
 
 	PUGI__FN void xml_document::reset(const xml_document& proto)
@@ -7181,6 +7974,9 @@ namespace pugi
 			page = next;
 		}
 
+		// destroy pages kept for reuse
+		static_cast<impl::xml_document_struct*>(_root)->deallocate_spare_pages();
+
 	#ifdef PUGIXML_COMPACT
 		// destroy hash table
 		static_cast<impl::xml_document_struct*>(_root)->hash.clear();
@@ -7230,6 +8026,10 @@ namespace pugi
 			doc->_busy_size = other->_busy_size;
 		}
 
+		// move pages kept for reuse
+		doc->_spare_pages = other->_spare_pages;
+		doc->_keep_pages = other->_keep_pages;
+
 		// move buffer state
 		doc->buffer = other->buffer;
 		doc->extra_buffers = other->extra_buffers;
@@ -7471,6 +8271,224 @@ namespace pugi
 	}
 #endif
 
+	PUGI__FN xml_parse_result PUGIXML_FUNCTION parse_sax_inplace(void* contents, size_t size, xml_sax_handler& handler, unsigned int options, xml_encoding encoding)
+	{
+		// check input buffer
+		if (!contents && size) return impl::make_parse_result(status_io_error);
+
+		// get actual encoding
+		xml_encoding buffer_encoding = impl::get_buffer_encoding(encoding, contents, size);
+
+		// get private buffer; contents itself unless it has to be converted
+		char_t* buffer = 0;
+		size_t length = 0;
+
+		if (!impl::convert_buffer(buffer, length, buffer_encoding, contents, size, true)) return impl::make_parse_result(status_out_of_memory);
+
+		// the converted buffer is only needed while parsing
+		impl::auto_deleter<void> buffer_guard(buffer != contents ? buffer : 0, impl::xml_memory::deallocate);
+
+		// parse
+		xml_parse_result res = impl::xml_parser::parse_sax(buffer, length, &handler, options);
+
+		// remember encoding
+		res.encoding = buffer_encoding;
+
+		return res;
+	}
+
+	PUGI__FN xml_incremental_parser::xml_incremental_parser()
+	{
+		reset();
+	}
+
+	PUGI__FN xml_incremental_status xml_incremental_parser::feed(const void* contents, size_t size, size_t* consumed)
+	{
+		const unsigned char* data = static_cast<const unsigned char*>(contents);
+		const unsigned char* end = data + size;
+		const unsigned char* s = data;
+
+		xml_incremental_status status = incremental_more;
+
+		if (_state == impl::incremental_done) status = incremental_complete;
+		else if (_state == impl::incremental_failed) status = incremental_error;
+		else
+		{
+			// the state is kept in locals while scanning, and stored back once the bytes run out or the document ends
+			int state = _state;
+			unsigned int count = _count;
+			char quote = _quote;
+			size_t depth = _depth;
+
+			while (s < end && status == incremental_more)
+			{
+				unsigned char ch = *s;
+
+				switch (state)
+				{
+				case impl::incremental_text:
+					if (depth == 0)
+					{
+						// outside of the root element, only whitespace and markup are allowed (and the UTF-8 BOM before anything else)
+						if (ch == '<') state = impl::incremental_markup;
+						else if (ch == 0xef && _length + (s - data) == 0) state = impl::incremental_bom;
+						else if (!(impl::chartype_table[ch] & impl::ct_space)) status = incremental_error;
+					}
+					else
+					{
+						// inside of an element, skip character data up to the next tag in one go
+						const unsigned char* lt = static_cast<const unsigned char*>(memchr(s, '<', static_cast<size_t>(end - s)));
+
+						if (!lt)
+						{
+							s = end;
+							continue;
+						}
+
+						s = lt;
+						state = impl::incremental_markup;
+					}
+					break;
+
+				case impl::incremental_bom:
+					// EF BB BF; count tells how many bytes of it are left
+					if (ch != (count == 0 ? 0xbb : 0xbf)) status = incremental_error;
+					else if (count++ == 1)
+					{
+						count = 0;
+						state = impl::incremental_text;
+					}
+					break;
+
+				case impl::incremental_markup:
+					if (ch == '/')
+					{
+						if (depth == 0) status = incremental_error;
+						else state = impl::incremental_end_tag;
+					}
+					else if (ch == '?') state = impl::incremental_pi;
+					else if (ch == '!') state = impl::incremental_bang;
+					else if (ch == '>' || ch == '<' || (impl::chartype_table[ch] & impl::ct_space)) status = incremental_error;
+					else state = impl::incremental_start_tag;
+
+					count = 0;
+					quote = 0;
+					break;
+
+				case impl::incremental_bang:
+					if (ch == '-') state = impl::incremental_comment_open;
+					else if (ch == '[') state = impl::incremental_cdata;
+					else if (ch == '>') state = impl::incremental_text;
+					else state = impl::incremental_declaration;
+					break;
+
+				case impl::incremental_comment_open:
+					if (ch == '-') state = impl::incremental_comment;
+					else status = incremental_error;
+					break;
+
+				case impl::incremental_comment:
+					// ends at -->; count is the number of dashes right before ch
+					if (ch == '>' && count >= 2) state = impl::incremental_text;
+
+					count = (ch == '-') ? count + 1 : 0;
+					break;
+
+				case impl::incremental_cdata:
+					// ends at ]]>; count is the number of brackets right before ch
+					if (ch == '>' && count >= 2) state = impl::incremental_text;
+
+					count = (ch == ']') ? count + 1 : 0;
+					break;
+
+				case impl::incremental_pi:
+					// ends at ?>; count is 1 right after a question mark
+					if (ch == '>' && count) state = impl::incremental_text;
+
+					count = (ch == '?');
+					break;
+
+				case impl::incremental_declaration:
+					// ends at the first > outside of quotes and of the internal subset; count is the bracket depth
+					if (quote)
+					{
+						if (ch == static_cast<unsigned char>(quote)) quote = 0;
+					}
+					else if (ch == '"' || ch == '\'') quote = static_cast<char>(ch);
+					else if (ch == '[') count++;
+					else if (ch == ']' && count) count--;
+					else if (ch == '>' && count == 0) state = impl::incremental_text;
+					break;
+
+				case impl::incremental_start_tag:
+					// ends at the first > outside of quotes; count is 1 right after a slash, which makes the element empty
+					if (quote)
+					{
+						if (ch == static_cast<unsigned char>(quote)) quote = 0;
+					}
+					else if (ch == '"' || ch == '\'') quote = static_cast<char>(ch);
+					else if (ch == '>')
+					{
+						if (!count) depth++;
+						else if (depth == 0) status = incremental_complete;
+
+						state = impl::incremental_text;
+					}
+
+					count = (!quote && ch == '/');
+					break;
+
+				case impl::incremental_end_tag:
+					if (ch == '>')
+					{
+						if (--depth == 0) status = incremental_complete;
+
+						state = impl::incremental_text;
+					}
+					break;
+
+				default:
+					assert(false && "Invalid incremental parser state");
+				}
+
+				// the offending byte is not consumed
+				if (status != incremental_error) s++;
+			}
+
+			if (status == incremental_complete) state = impl::incremental_done;
+			else if (status == incremental_error) state = impl::incremental_failed;
+
+			_state = state;
+			_count = count;
+			_quote = quote;
+			_depth = depth;
+			_length += static_cast<size_t>(s - data);
+		}
+
+		if (consumed) *consumed = static_cast<size_t>(s - data);
+
+		return status;
+	}
+
+	PUGI__FN void xml_incremental_parser::reset()
+	{
+		_state = impl::incremental_text;
+		_count = 0;
+		_quote = 0;
+		_depth = 0;
+		_length = 0;
+	}
+
+	PUGI__FN size_t xml_incremental_parser::length() const
+	{
+		return _length;
+	}
+
+	PUGI__FN size_t xml_incremental_parser::depth() const
+	{
+		return _depth;
+	}
+
 	PUGI__FN void PUGIXML_FUNCTION set_memory_management_functions(allocation_function allocate, deallocation_function deallocate)
 	{
 		impl::xml_memory::allocate = allocate;
@@ -13121,8 +14139,8 @@ namespace pugi
 #undef PUGI__ENDSWITH
 #undef PUGI__SKIPWS
 #undef PUGI__OPTSET
-#undef PUGI__PUSHNODE
-#undef PUGI__POPNODE
+#undef PUGI__BUILD
+#undef PUGI__STOPATEND
 #undef PUGI__SCANFOR
 #undef PUGI__SCANWHILE
 #undef PUGI__SCANWHILE_UNROLL
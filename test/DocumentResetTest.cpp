@@ -0,0 +1,399 @@
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "../include/pugiconfig.hpp"
+#include "../include/pugixml.hpp"
+
+/**
+ * \def		RANDOM_SEED
+ * \brief	Seed of the randomized tests, so a failure can be replayed
+ */
+#define RANDOM_SEED	(20)
+
+/**
+ * \def		RANDOM_ITERATIONS
+ * \brief	Number of random steps taken by test_random_steps
+ */
+#define RANDOM_ITERATIONS	(2000)
+
+/**
+ * \def		LARGE_ITEMS
+ * \brief	Elements of the large document, enough to fill dozens of
+ *		memory pages
+ */
+#define LARGE_ITEMS	(5000)
+
+/**
+ * \def		LARGE_VALUE_SIZE
+ * \brief	Length of a value set on a loaded document, too long for a
+ *		regular memory page, so it gets a page of its own size
+ */
+#define LARGE_VALUE_SIZE	(100000)
+
+/**
+ * \var		size_t allocations
+ * \brief	Allocations made by pugixml since the start
+ */
+static size_t allocations = 0;
+
+/**
+ * \var		std::unordered_map<void*, size_t> live_allocations
+ * \brief	Size of each allocation of pugixml not freed yet
+ */
+static std::unordered_map<void*, size_t> live_allocations;
+
+/**
+ * \fn		void* counting_allocate
+ * \param	size_t size
+ * \return	Returns the memory allocated
+ * \brief	Allocation function of pugixml, counting allocations
+ */
+static void* counting_allocate(size_t size) {
+	void* memory;
+
+	memory = malloc(size);
+	allocations++;
+	live_allocations[memory] = size;
+
+	return memory;
+}
+
+/**
+ * \fn		void counting_deallocate
+ * \param	void *memory
+ * \return	N/A
+ * \brief	Deallocation function of pugixml, counting frees
+ */
+static void counting_deallocate(void* memory) {
+	live_allocations.erase(memory);
+	free(memory);
+}
+
+/**
+ * \fn		size_t get_largest_allocation
+ * \param	N/A
+ * \return	Returns the size of the largest allocation not freed yet
+ * \brief	Used to tell whether a page of an odd size was kept
+ */
+static size_t get_largest_allocation() {
+	size_t largest = 0;
+
+	for (auto& allocation : live_allocations) {
+		largest = std::max(largest, allocation.second);
+	}
+
+	return largest;
+}
+
+/**
+ * \fn		int check
+ * \param	bool condition
+ * \param	const char *message
+ * \return	Returns EXIT_SUCCESS if condition holds, and EXIT_FAILURE
+ *		(after printing message) otherwise
+ * \brief	Reports a failed expectation
+ */
+static int check(bool condition, const char* message) {
+	if (!condition) {
+		std::cerr << "FAILURE: " << message << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	return EXIT_SUCCESS;
+}
+
+/**
+ * \fn		std::vector<std::string> make_documents
+ * \param	N/A
+ * \return	Returns the documents the tests load: a request, a large
+ *		document and a few small ones
+ * \brief	Builds the documents once
+ */
+static std::vector<std::string> make_documents() {
+	std::vector<std::string> documents;
+	std::string large;
+
+	large = "<r>";
+	for (int i = 0; i < LARGE_ITEMS; i++) {
+		large += "<item id='" + std::to_string(i) + "' name='n'>text " + std::to_string(i) + "<!-- c --></item>";
+	}
+	large += "</r>";
+
+	documents.push_back("<Request><Command>GetPlayerInfo</Command><Data><Row Type=\"CardNumber\">6440750000000003</Row><Row Type=\"PIN\">1234</Row></Data></Request>");
+	documents.push_back(large);
+	documents.push_back("<a/>");
+	documents.push_back("<?xml version='1.0'?><r x='&gt;'><![CDATA[c]]><p><?pi ?></p>&amp;</r>");
+
+	return documents;
+}
+
+/**
+ * \fn		std::string serialize
+ * \param	const pugi::xml_document &xml
+ * \return	Returns xml without any formatting
+ * \brief	Used to compare two parsed documents
+ */
+static std::string serialize(const pugi::xml_document& xml) {
+	std::ostringstream output;
+
+	xml.save(output, "", pugi::format_raw);
+	return output.str();
+}
+
+/**
+ * \fn		int check_load
+ * \param	pugi::xml_document *xml
+ * \param	std::string *buffer
+ * \param	const std::string &document
+ * \param	bool reuse
+ * \return	Returns EXIT_FAILURE upon any failed expectation,
+ *		and EXIT_SUCCESS otherwise
+ * \brief	Loads document into xml in place (buffer keeps it), adds a
+ *		node to it, and compares it with a fresh document that had
+ *		the same done to it. With reuse, xml must have all the pages
+ *		this takes kept already, and allocate none
+ */
+static int check_load(pugi::xml_document* xml, std::string* buffer, const std::string& document, bool reuse) {
+	pugi::xml_document fresh;
+	size_t before;
+
+	*buffer = document;
+	before = allocations;
+	if (!xml->load_buffer_inplace(&(*buffer)[0], buffer->size(), pugi::parse_default, pugi::encoding_utf8)) {
+		return check(false, "document did not load after a reset");
+	}
+	xml->document_element().append_child("added").append_attribute("a") = "1";
+
+	if (reuse && allocations != before) {
+		return check(false, "document allocated pages instead of reusing the kept ones");
+	}
+
+	fresh.load_string(document.c_str());
+	fresh.document_element().append_child("added").append_attribute("a") = "1";
+
+	return check(serialize(*xml) == serialize(fresh), "document loaded after a reset differs from a fresh one");
+}
+
+/**
+ * \fn		int test_reuse_after_large
+ * \param	N/A
+ * \return	Returns EXIT_FAILURE upon any failed expectation,
+ *		and EXIT_SUCCESS otherwise
+ * \brief	After reset(true) a large document loads again without a
+ *		single allocation, and small ones load as if fresh. Pages
+ *		of an odd size are never kept, and reset(false) frees the
+ *		kept ones
+ */
+static int test_reuse_after_large() {
+	std::vector<std::string> documents;
+	std::string buffer;
+	int failures;
+
+	failures = 0;
+	documents = make_documents();
+
+	{
+		pugi::xml_document xml;
+
+		failures += check_load(&xml, &buffer, documents[1], false);
+		xml.reset(true);
+		failures += check(!xml.first_child(), "reset left nodes behind");
+
+		failures += check_load(&xml, &buffer, documents[1], true);
+
+		for (const std::string& document : documents) {
+			xml.reset(true);
+			failures += check_load(&xml, &buffer, document, false);
+		}
+
+		/**
+		 *	- A value too long for a regular page, which has to be freed
+		 *	  rather than kept, both when its node is removed and when
+		 *	  the document is reset
+		 */
+		xml.document_element().append_child("big").text().set(std::string(LARGE_VALUE_SIZE, 'y').c_str());
+		failures += check(get_largest_allocation() > LARGE_VALUE_SIZE, "long value did not get a page of its own");
+		xml.document_element().remove_child("big");
+		failures += check(get_largest_allocation() < LARGE_VALUE_SIZE, "page of an odd size was kept once its node was removed");
+
+		xml.document_element().append_child("big").text().set(std::string(LARGE_VALUE_SIZE, 'y').c_str());
+		xml.reset(true);
+		failures += check(get_largest_allocation() < LARGE_VALUE_SIZE, "page of an odd size was kept");
+		failures += check_load(&xml, &buffer, documents[1], false);
+
+		/**
+		 *	- reset() keeps the mode of the last reset
+		 */
+		xml.reset();
+		failures += check_load(&xml, &buffer, documents[1], true);
+
+		xml.reset(false);
+		failures += check(live_allocations.empty(), "reset(false) did not free the kept pages");
+		failures += check_load(&xml, &buffer, documents[0], false);
+	}
+
+	failures += check(live_allocations.empty(), "memory leaked with reset(true)");
+
+	return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+/**
+ * \fn		int test_move_construction
+ * \param	N/A
+ * \return	Returns EXIT_FAILURE upon any failed expectation,
+ *		and EXIT_SUCCESS otherwise
+ * \brief	A document built by moving one with kept pages takes them
+ *		(and the mode) over, and the one moved from still loads
+ */
+static int test_move_construction() {
+	std::vector<std::string> documents;
+	std::string buffer;
+	std::string moved_buffer;
+	int failures;
+
+	failures = 0;
+	documents = make_documents();
+
+	{
+		pugi::xml_document xml;
+
+		failures += check_load(&xml, &buffer, documents[1], false);
+		xml.reset(true);
+
+		pugi::xml_document moved(std::move(xml));
+
+		failures += check_load(&moved, &moved_buffer, documents[1], true);
+
+		moved.reset();
+		failures += check_load(&moved, &moved_buffer, documents[3], false);
+
+		failures += check(!xml.first_child(), "document moved from was not left empty");
+		failures += check_load(&xml, &buffer, documents[0], false);
+		failures += check_load(&xml, &buffer, documents[1], false);
+	}
+
+	failures += check(live_allocations.empty(), "memory leaked with a move construction");
+
+	return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+/**
+ * \fn		int test_move_assignment
+ * \param	N/A
+ * \return	Returns EXIT_FAILURE upon any failed expectation,
+ *		and EXIT_SUCCESS otherwise
+ * \brief	Assigning a document with kept pages to one that holds both
+ *		nodes and kept pages of its own frees the latter, and takes
+ *		the former over
+ */
+static int test_move_assignment() {
+	std::vector<std::string> documents;
+	std::string buffer;
+	std::string target_buffer;
+	int failures;
+
+	failures = 0;
+	documents = make_documents();
+
+	{
+		pugi::xml_document xml;
+		pugi::xml_document target;
+
+		failures += check_load(&xml, &buffer, documents[1], false);
+		xml.reset(true);
+		failures += check_load(&xml, &buffer, documents[3], false);
+
+		failures += check_load(&target, &target_buffer, documents[1], false);
+		target.reset(true);
+		failures += check_load(&target, &target_buffer, documents[0], false);
+
+		target = std::move(xml);
+		failures += check_load(&target, &target_buffer, documents[0], false);
+
+		target.reset();
+		failures += check_load(&target, &target_buffer, documents[1], true);
+
+		failures += check_load(&xml, &buffer, documents[2], false);
+	}
+
+	failures += check(live_allocations.empty(), "memory leaked with a move assignment");
+
+	return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+/**
+ * \fn		int test_random_steps
+ * \param	N/A
+ * \return	Returns EXIT_FAILURE upon any failed expectation,
+ *		and EXIT_SUCCESS otherwise
+ * \brief	Random resets, moves and loads of two documents, each load
+ *		compared with a fresh document
+ */
+static int test_random_steps() {
+	std::mt19937 random(RANDOM_SEED);
+	std::vector<std::string> documents;
+	std::string buffers[2];
+	size_t from;
+	size_t to;
+
+	documents = make_documents();
+
+	{
+		pugi::xml_document xml[2];
+
+		for (int iteration = 0; iteration < RANDOM_ITERATIONS; iteration++) {
+			to = random() % 2;
+			from = 1 - to;
+
+			switch (random() % 6) {
+			case 0:
+				xml[to].reset(true);
+				break;
+			case 1:
+				xml[to].reset(false);
+				break;
+			case 2:
+				xml[to].reset();
+				break;
+			case 3:
+				xml[to] = std::move(xml[from]);
+				std::swap(buffers[to], buffers[from]);
+				break;
+			default:
+				if (check_load(&xml[to], &buffers[to], documents[random() % documents.size()], false) != EXIT_SUCCESS) {
+					return EXIT_FAILURE;
+				}
+				break;
+			}
+		}
+	}
+
+	return check(live_allocations.empty(), "memory leaked with random steps");
+}
+
+int main() {
+	int failures;
+
+	pugi::set_memory_management_functions(counting_allocate, counting_deallocate);
+
+	failures = 0;
+	failures += test_reuse_after_large();
+	failures += test_move_construction();
+	failures += test_move_assignment();
+	failures += test_random_steps();
+
+	if (failures != 0) {
+		std::cerr << "DocumentResetTest: " << failures << " test(s) failed" << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	std::cout << "DocumentResetTest: all tests passed" << std::endl;
+	return EXIT_SUCCESS;
+}
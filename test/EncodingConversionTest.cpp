@@ -0,0 +1,317 @@
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "../include/pugiconfig.hpp"
+#include "../include/pugixml.hpp"
+
+/**
+ * \def		RANDOM_SEED
+ * \brief	Seed of the randomized tests, so a failure can be replayed
+ */
+#define RANDOM_SEED	(22)
+
+/**
+ * \def		RANDOM_ITERATIONS
+ * \brief	Number of random texts converted by each test
+ */
+#define RANDOM_ITERATIONS	(5000)
+
+/**
+ * \def		MAX_RUN_LENGTH
+ * \brief	ASCII runs are shorter than this, so they end anywhere in the
+ *		first two 32-byte blocks
+ */
+#define MAX_RUN_LENGTH	(70)
+
+/**
+ * \def		MAX_NAME_LENGTH
+ * \brief	Element names are up to this long, which shifts the text
+ *		against the blocks it is converted in
+ */
+#define MAX_NAME_LENGTH	(32)
+
+/**
+ * \def		LONE_HIGH
+ * \brief	Code point of test_utf16 that stands for a leading surrogate
+ *		without its trailing one, followed by an x. The decoder drops
+ *		the surrogate and keeps the x
+ */
+#define LONE_HIGH	(0xD800)
+
+/**
+ * \def		LONE_LOW
+ * \brief	Code point of test_utf16 that stands for a trailing surrogate
+ *		without its leading one. The decoder drops it
+ */
+#define LONE_LOW	(0xDC00)
+
+/**
+ * \var		const char ASCII[]
+ * \brief	Characters the ASCII runs are made of, none of which has to
+ *		be escaped or gets converted in character data or attributes
+ */
+static const char ASCII[] = "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789 .,;:!?/=-_+*()[]{}'";
+
+/**
+ * \fn		void append_utf8
+ * \param	std::string *text
+ * \param	uint32_t code_point
+ * \return	N/A
+ * \brief	Reference UTF-8 encoder
+ */
+static void append_utf8(std::string* text, uint32_t code_point) {
+	if (code_point < 0x80) {
+		*text += (char)code_point;
+	}
+	else if (code_point < 0x800) {
+		*text += (char)(0xC0 | (code_point >> 6));
+		*text += (char)(0x80 | (code_point & 0x3F));
+	}
+	else if (code_point < 0x10000) {
+		*text += (char)(0xE0 | (code_point >> 12));
+		*text += (char)(0x80 | ((code_point >> 6) & 0x3F));
+		*text += (char)(0x80 | (code_point & 0x3F));
+	}
+	else {
+		*text += (char)(0xF0 | (code_point >> 18));
+		*text += (char)(0x80 | ((code_point >> 12) & 0x3F));
+		*text += (char)(0x80 | ((code_point >> 6) & 0x3F));
+		*text += (char)(0x80 | (code_point & 0x3F));
+	}
+}
+
+/**
+ * \fn		void append_utf16
+ * \param	std::string *bytes
+ * \param	uint16_t unit
+ * \param	bool big_endian
+ * \return	N/A
+ * \brief	Appends one UTF-16 code unit in the given byte order
+ */
+static void append_utf16(std::string* bytes, uint16_t unit, bool big_endian) {
+	if (big_endian) {
+		*bytes += (char)(unit >> 8);
+		*bytes += (char)(unit & 0xFF);
+	}
+	else {
+		*bytes += (char)(unit & 0xFF);
+		*bytes += (char)(unit >> 8);
+	}
+}
+
+/**
+ * \fn		std::vector<uint32_t> random_text
+ * \param	std::mt19937 *random
+ * \param	uint32_t max_code_point
+ * \return	Returns runs of ASCII characters of random lengths, each
+ *		followed by a code point (or LONE_HIGH or LONE_LOW) up to
+ *		max_code_point
+ * \brief	Builds the texts the conversions are checked with
+ */
+static std::vector<uint32_t> random_text(std::mt19937* random, uint32_t max_code_point) {
+	std::vector<uint32_t> text;
+	uint32_t code_point;
+
+	for (size_t i = (*random)() % 8; i > 0; i--) {
+		for (size_t j = (*random)() % MAX_RUN_LENGTH; j > 0; j--) {
+			text.push_back(ASCII[(*random)() % (sizeof(ASCII) - 1)]);
+		}
+
+		/**
+		 *	- Pick a code point from a random range, so the short
+		 *	  ranges are as likely as the long ones
+		 */
+		switch ((*random)() % 6) {
+		case 0:
+			code_point = 0x80 + (*random)() % 0x80;
+			break;
+		case 1:
+			code_point = 0x100 + (*random)() % 0x700;
+			break;
+		case 2:
+			code_point = 0x800 + (*random)() % (0xD800 - 0x800);
+			break;
+		case 3:
+			code_point = 0x10000 + (*random)() % 0x100000;
+			break;
+		case 4:
+			code_point = LONE_HIGH;
+			break;
+		default:
+			code_point = LONE_LOW;
+			break;
+		}
+
+		if (code_point <= max_code_point) {
+			text.push_back(code_point);
+		}
+	}
+
+	return text;
+}
+
+/**
+ * \fn		int check_document
+ * \param	const std::string &contents
+ * \param	pugi::xml_encoding encoding
+ * \param	const std::string &name
+ * \param	const std::string &expected
+ * \return	Returns EXIT_FAILURE upon any failed expectation,
+ *		and EXIT_SUCCESS otherwise
+ * \brief	contents loads as an element called name, whose attribute and
+ *		character data (between brackets) both convert to expected
+ */
+static int check_document(const std::string& contents, pugi::xml_encoding encoding, const std::string& name, const std::string& expected) {
+	pugi::xml_document xml;
+	pugi::xml_node element;
+
+	if (!xml.load_buffer(contents.data(), contents.size(), pugi::parse_default, encoding)) {
+		std::cerr << "FAILURE: document in encoding " << encoding << " did not load: " << expected << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	element = xml.child(name.c_str());
+	if (element.attribute("a").value() != expected || element.child_value() != "[" + expected + "]") {
+		std::cerr << "FAILURE: document in encoding " << encoding << " converted wrongly: " << expected << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	return EXIT_SUCCESS;
+}
+
+/**
+ * \fn		int test_utf16
+ * \param	N/A
+ * \return	Returns EXIT_FAILURE upon any failed expectation,
+ *		and EXIT_SUCCESS otherwise
+ * \brief	Random texts in UTF-16 of either byte order, with or without
+ *		a BOM, convert to the same UTF-8 as the reference. Lone
+ *		surrogates between ASCII runs are dropped
+ */
+static int test_utf16() {
+	std::mt19937 random(RANDOM_SEED);
+	std::vector<uint32_t> text;
+	std::string name;
+	std::string expected;
+	std::string contents;
+	std::string markup;
+	bool big_endian;
+	bool bom;
+
+	for (int iteration = 0; iteration < RANDOM_ITERATIONS; iteration++) {
+		text = random_text(&random, 0x10FFFF);
+		name = "e" + std::string(random() % MAX_NAME_LENGTH, 'x');
+		big_endian = random() % 2;
+		bom = random() % 2;
+
+		expected.clear();
+		for (uint32_t code_point : text) {
+			if (code_point == LONE_HIGH) {
+				expected += 'x';
+			}
+			else if (code_point != LONE_LOW) {
+				append_utf8(&expected, code_point);
+			}
+		}
+
+		/**
+		 *	- Encode the document. A lone leading surrogate is always
+		 *	  followed by an x, and a lone trailing one can only follow
+		 *	  a character or a pair, so neither ever pairs up
+		 */
+		contents.clear();
+		if (bom) {
+			append_utf16(&contents, 0xFEFF, big_endian);
+		}
+
+		for (int part = 0; part < 2; part++) {
+			markup = part == 0 ? "<" + name + " a=\"" : "\">[";
+			for (char character : markup) {
+				append_utf16(&contents, (uint16_t)character, big_endian);
+			}
+
+			for (uint32_t code_point : text) {
+				if (code_point == LONE_HIGH) {
+					append_utf16(&contents, (uint16_t)(0xD800 + random() % 0x400), big_endian);
+					append_utf16(&contents, 'x', big_endian);
+				}
+				else if (code_point == LONE_LOW) {
+					append_utf16(&contents, (uint16_t)(0xDC00 + random() % 0x400), big_endian);
+				}
+				else if (code_point >= 0x10000) {
+					append_utf16(&contents, (uint16_t)(0xD800 + ((code_point - 0x10000) >> 10)), big_endian);
+					append_utf16(&contents, (uint16_t)(0xDC00 + ((code_point - 0x10000) & 0x3FF)), big_endian);
+				}
+				else {
+					append_utf16(&contents, (uint16_t)code_point, big_endian);
+				}
+			}
+		}
+
+		markup = "]</" + name + ">";
+		for (char character : markup) {
+			append_utf16(&contents, (uint16_t)character, big_endian);
+		}
+
+		if (check_document(contents, bom ? pugi::encoding_auto : (big_endian ? pugi::encoding_utf16_be : pugi::encoding_utf16_le), name, expected) != EXIT_SUCCESS) {
+			return EXIT_FAILURE;
+		}
+	}
+
+	return EXIT_SUCCESS;
+}
+
+/**
+ * \fn		int test_latin1
+ * \param	N/A
+ * \return	Returns EXIT_FAILURE upon any failed expectation,
+ *		and EXIT_SUCCESS otherwise
+ * \brief	Random texts in Latin-1, including pure ASCII ones that are
+ *		used without conversion, convert to the same UTF-8 as the
+ *		reference
+ */
+static int test_latin1() {
+	std::mt19937 random(RANDOM_SEED);
+	std::vector<uint32_t> text;
+	std::string name;
+	std::string expected;
+	std::string encoded;
+
+	for (int iteration = 0; iteration < RANDOM_ITERATIONS; iteration++) {
+		text = random_text(&random, 0xFF);
+		name = "e" + std::string(random() % MAX_NAME_LENGTH, 'x');
+
+		expected.clear();
+		encoded.clear();
+		for (uint32_t code_point : text) {
+			append_utf8(&expected, code_point);
+			encoded += (char)code_point;
+		}
+
+		if (check_document("<" + name + " a=\"" + encoded + "\">[" + encoded + "]</" + name + ">", pugi::encoding_latin1, name, expected) != EXIT_SUCCESS) {
+			return EXIT_FAILURE;
+		}
+	}
+
+	return EXIT_SUCCESS;
+}
+
+int main() {
+	int failures;
+
+	failures = 0;
+	failures += test_utf16();
+	failures += test_latin1();
+
+	if (failures != 0) {
+		std::cerr << "EncodingConversionTest: " << failures << " test(s) failed" << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	std::cout << "EncodingConversionTest: all tests passed" << std::endl;
+	return EXIT_SUCCESS;
+}
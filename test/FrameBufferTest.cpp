@@ -0,0 +1,316 @@
+#include <arpa/inet.h>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+
+#include "../include/pugiconfig.hpp"
+#include "../include/pugixml.hpp"
+#include "../include/FrameBuffer.h"
+
+/**
+ * \def		TEST_MAX_FRAME_SIZE
+ * \brief	Largest frame accepted, the same as the server's
+ *		MAX_REQUEST_SIZE
+ */
+#define TEST_MAX_FRAME_SIZE	(1024 * 1024)
+
+/**
+ * \fn		int check
+ * \param	bool condition
+ * \param	const char *message
+ * \return	Returns EXIT_SUCCESS if condition holds, and EXIT_FAILURE
+ *		(after printing message) otherwise
+ * \brief	Reports a failed expectation
+ */
+static int check(bool condition, const char* message) {
+	if (!condition) {
+		std::cerr << "FAILURE: " << message << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	return EXIT_SUCCESS;
+}
+
+/**
+ * \fn		std::string length_prefix
+ * \param	uint32_t length
+ * \return	Returns length as a 4-byte prefix in network byte order
+ * \brief	Frames requests the way a length-prefixing client does
+ */
+static std::string length_prefix(uint32_t length) {
+	uint32_t prefix;
+
+	prefix = htonl(length);
+	return std::string((const char*)&prefix, sizeof(prefix));
+}
+
+/**
+ * \fn		bool is_frame
+ * \param	FrameBuffer *buffer
+ * \param	const std::string &expected
+ * \return	Returns true if the next frame of buffer is complete and
+ *		holds expected
+ * \brief	Takes the next frame out of buffer and compares it
+ */
+static bool is_frame(FrameBuffer* buffer, const std::string& expected) {
+	char* frame;
+	size_t length;
+
+	return buffer->next_frame(&frame, &length) == FRAME_COMPLETE && std::string(frame, length) == expected;
+}
+
+/**
+ * \fn		int test_split_prefix
+ * \param	N/A
+ * \return	Returns EXIT_FAILURE upon any failed expectation,
+ *		and EXIT_SUCCESS otherwise
+ * \brief	A frame whose length prefix, and then body, arrive a byte at
+ *		a time is only complete once its last byte is buffered
+ */
+static int test_split_prefix() {
+	FrameBuffer buffer;
+	std::string stream;
+	char* frame;
+	size_t length;
+	int failures;
+
+	failures = 0;
+	stream = length_prefix(5) + "<a/>x";
+	buffer.set_framing(FRAMING_LENGTH_PREFIX, TEST_MAX_FRAME_SIZE);
+
+	for (size_t i = 0; i + 1 < stream.size(); i++) {
+		buffer.append(&stream[i], 1);
+		if (buffer.next_frame(&frame, &length) != FRAME_INCOMPLETE) {
+			failures += check(false, "frame was complete before its last byte");
+			break;
+		}
+	}
+
+	buffer.append(&stream.back(), 1);
+	failures += check(is_frame(&buffer, "<a/>x"), "frame split across reads was not put back together");
+	failures += check(buffer.get_length() == 0 && buffer.get_frames() == 1, "frame was not taken out of the buffer");
+
+	return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+/**
+ * \fn		int test_zero_length
+ * \param	N/A
+ * \return	Returns EXIT_FAILURE upon any failed expectation,
+ *		and EXIT_SUCCESS otherwise
+ * \brief	A zero length prefix is an empty frame (answered as an
+ *		invalid request), and the frame after it is unaffected
+ */
+static int test_zero_length() {
+	FrameBuffer buffer;
+	std::string stream;
+	int failures;
+
+	failures = 0;
+	stream = length_prefix(0) + length_prefix(4) + "<a/>";
+	buffer.set_framing(FRAMING_LENGTH_PREFIX, TEST_MAX_FRAME_SIZE);
+	buffer.append(stream.data(), stream.size());
+
+	failures += check(is_frame(&buffer, ""), "zero length prefix was not an empty frame");
+	failures += check(is_frame(&buffer, "<a/>"), "frame after an empty one was lost");
+	failures += check(buffer.get_frames() == 2, "empty frame was not counted");
+
+	return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+/**
+ * \fn		int test_too_large
+ * \param	N/A
+ * \return	Returns EXIT_FAILURE upon any failed expectation,
+ *		and EXIT_SUCCESS otherwise
+ * \brief	A length prefix over the max frame size is rejected as soon
+ *		as the prefix is in, before any of its body is buffered, and
+ *		so are newline and document frames that outgrow it
+ */
+static int test_too_large() {
+	char* frame;
+	size_t length;
+	std::string stream;
+	int failures;
+
+	failures = 0;
+
+	/**
+	 *	- Length prefix, at and just over the limit
+	 */
+	{
+		FrameBuffer buffer;
+
+		stream = length_prefix(TEST_MAX_FRAME_SIZE);
+		buffer.set_framing(FRAMING_LENGTH_PREFIX, TEST_MAX_FRAME_SIZE);
+		buffer.append(stream.data(), stream.size());
+
+		failures += check(buffer.next_frame(&frame, &length) == FRAME_INCOMPLETE, "frame of the max size was rejected");
+	}
+	{
+		FrameBuffer buffer;
+
+		stream = length_prefix(TEST_MAX_FRAME_SIZE + 1);
+		buffer.set_framing(FRAMING_LENGTH_PREFIX, TEST_MAX_FRAME_SIZE);
+		buffer.append(stream.data(), stream.size());
+
+		failures += check(buffer.next_frame(&frame, &length) == FRAME_TOO_LARGE, "frame over the max size was not rejected");
+	}
+	{
+		FrameBuffer buffer;
+
+		stream = length_prefix(UINT32_MAX);
+		buffer.set_framing(FRAMING_LENGTH_PREFIX, TEST_MAX_FRAME_SIZE);
+		buffer.append(stream.data(), stream.size());
+
+		failures += check(buffer.next_frame(&frame, &length) == FRAME_TOO_LARGE, "largest length prefix was not rejected");
+	}
+
+	/**
+	 *	- Newline and document, without the delimiter or the end tag
+	 */
+	{
+		FrameBuffer buffer;
+
+		stream = std::string(TEST_MAX_FRAME_SIZE + 1, 'x');
+		buffer.set_framing(FRAMING_NEWLINE, TEST_MAX_FRAME_SIZE);
+		buffer.append(stream.data(), stream.size());
+
+		failures += check(buffer.next_frame(&frame, &length) == FRAME_TOO_LARGE, "line over the max size was not rejected");
+	}
+	{
+		FrameBuffer buffer;
+
+		stream = "<r>" + std::string(TEST_MAX_FRAME_SIZE, 'x');
+		buffer.set_framing(FRAMING_DOCUMENT, TEST_MAX_FRAME_SIZE);
+		buffer.append(stream.data(), stream.size());
+
+		failures += check(buffer.next_frame(&frame, &length) == FRAME_TOO_LARGE, "document over the max size was not rejected");
+	}
+
+	return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+/**
+ * \fn		int test_frames_in_one_read
+ * \param	N/A
+ * \return	Returns EXIT_FAILURE upon any failed expectation,
+ *		and EXIT_SUCCESS otherwise
+ * \brief	Several frames received at once, followed by part of the
+ *		next, are taken out one at a time under every framing, and
+ *		the part is completed by the next read
+ */
+static int test_frames_in_one_read() {
+	FrameBuffer prefixed;
+	FrameBuffer lines;
+	FrameBuffer documents;
+	std::string stream;
+	char* frame;
+	size_t length;
+	int failures;
+
+	failures = 0;
+
+	stream = length_prefix(4) + "<a/>" + length_prefix(7) + "<b></b>" + length_prefix(4) + "<c/";
+	prefixed.set_framing(FRAMING_LENGTH_PREFIX, TEST_MAX_FRAME_SIZE);
+	prefixed.append(stream.data(), stream.size());
+
+	failures += check(is_frame(&prefixed, "<a/>") && is_frame(&prefixed, "<b></b>"), "length-prefixed frames were not split");
+	failures += check(prefixed.next_frame(&frame, &length) == FRAME_INCOMPLETE && prefixed.get_length() == 7, "partial length-prefixed frame was not kept");
+	prefixed.append(">", 1);
+	failures += check(is_frame(&prefixed, "<c/>"), "partial length-prefixed frame was not completed");
+
+	stream = "<a/>\n<b></b>\r\n\n<c";
+	lines.set_framing(FRAMING_NEWLINE, TEST_MAX_FRAME_SIZE);
+	lines.append(stream.data(), stream.size());
+
+	failures += check(is_frame(&lines, "<a/>") && is_frame(&lines, "<b></b>"), "lines were not split, or kept their carriage return");
+	failures += check(lines.next_frame(&frame, &length) == FRAME_INCOMPLETE && lines.get_length() == 2, "partial line was not kept, or the blank line was");
+	lines.append("/>\n", 3);
+	failures += check(is_frame(&lines, "<c/>"), "partial line was not completed");
+
+	stream = "<a/><b>\n</b>\n <c";
+	documents.set_framing(FRAMING_DOCUMENT, TEST_MAX_FRAME_SIZE);
+	documents.append(stream.data(), stream.size());
+
+	failures += check(is_frame(&documents, "<a/>") && is_frame(&documents, "<b>\n</b>"), "documents were not split");
+	failures += check(documents.next_frame(&frame, &length) == FRAME_INCOMPLETE, "partial document was taken out");
+	documents.append("/>", 2);
+	failures += check(is_frame(&documents, "<c/>"), "partial document was not completed");
+
+	return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+/**
+ * \fn		int test_newline_byte_at_a_time
+ * \param	N/A
+ * \return	Returns EXIT_FAILURE upon any failed expectation,
+ *		and EXIT_SUCCESS otherwise
+ * \brief	Lines received a byte at a time, the way a client types them
+ *		into netcat, are each complete at their newline, however far
+ *		the buffer has had to grow or move them
+ */
+static int test_newline_byte_at_a_time() {
+	FrameBuffer buffer;
+	std::string stream;
+	std::string line;
+	FrameStatus status;
+	char* frame;
+	size_t length;
+	int failures;
+	int found;
+
+	failures = 0;
+	found = 0;
+	line = "<Request><Command>GetPlayerInfo</Command></Request>";
+	for (int i = 0; i < 50; i++) {
+		stream += line + std::string(i, 'x') + (i % 2 ? "\r\n" : "\n");
+	}
+
+	buffer.set_framing(FRAMING_NEWLINE, TEST_MAX_FRAME_SIZE);
+
+	for (size_t i = 0; i < stream.size(); i++) {
+		buffer.append(&stream[i], 1);
+		status = buffer.next_frame(&frame, &length);
+
+		if (stream[i] != '\n') {
+			if (status != FRAME_INCOMPLETE) {
+				failures += check(false, "line was complete before its newline");
+				break;
+			}
+		}
+		else {
+			if (status != FRAME_COMPLETE || std::string(frame, length) != line + std::string(found, 'x')) {
+				failures += check(false, "line fed a byte at a time was not taken out whole at its newline");
+				break;
+			}
+
+			found++;
+		}
+	}
+
+	failures += check(found == 50 && buffer.get_frames() == 50 && buffer.get_length() == 0, "not every line was taken out");
+
+	return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+int main() {
+	int failures;
+
+	failures = 0;
+	failures += test_split_prefix();
+	failures += test_zero_length();
+	failures += test_too_large();
+	failures += test_frames_in_one_read();
+	failures += test_newline_byte_at_a_time();
+
+	if (failures != 0) {
+		std::cerr << "FrameBufferTest: " << failures << " test(s) failed" << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	std::cout << "FrameBufferTest: all tests passed" << std::endl;
+	return EXIT_SUCCESS;
+}
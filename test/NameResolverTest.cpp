@@ -0,0 +1,171 @@
+#include <arpa/inet.h>
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <iostream>
+#include <mutex>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+
+#include "../include/NameResolver.h"
+
+/**
+ * \def		TEST_TTL
+ * \brief	Seconds the resolver under test caches each host name
+ */
+#define TEST_TTL	(1)
+
+/**
+ * \def		TEST_TIMEOUT
+ * \brief	Seconds to wait for the resolver thread to look an address up
+ */
+#define TEST_TIMEOUT	(30)
+
+/**
+ * \fn		sockaddr_in make_address
+ * \param	const char *ip_address
+ * \return	Returns the IPv4 socket address of ip_address
+ * \brief	Builds the address a client would be accepted from
+ */
+static sockaddr_in make_address(const char* ip_address) {
+	sockaddr_in socket_address;
+
+	memset(&socket_address, 0, sizeof(socket_address));
+	socket_address.sin_family = AF_INET;
+	inet_pton(AF_INET, ip_address, &socket_address.sin_addr);
+
+	return socket_address;
+}
+
+/**
+ * \fn		int wait_for_lookup
+ * \param	NameResolver *resolver
+ * \param	const sockaddr_in *socket_address
+ * \param	std::string *host_name
+ * \return	Returns EXIT_SUCCESS (and sets host_name) once the address is
+ *		cached, or EXIT_FAILURE if it is not within TEST_TIMEOUT
+ * \brief	Polls the cache the way accepting clients does
+ */
+static int wait_for_lookup(NameResolver* resolver, const sockaddr_in* socket_address, std::string* host_name) {
+	char buffer[NI_MAXHOST];
+	std::chrono::steady_clock::time_point deadline;
+
+	deadline = std::chrono::steady_clock::now() + std::chrono::seconds(TEST_TIMEOUT);
+	while (std::chrono::steady_clock::now() < deadline) {
+		if (resolver->lookup(socket_address, buffer, sizeof(buffer)) == EXIT_SUCCESS) {
+			*host_name = buffer;
+			return EXIT_SUCCESS;
+		}
+
+		std::this_thread::sleep_for(std::chrono::milliseconds(10));
+	}
+
+	return EXIT_FAILURE;
+}
+
+/**
+ * \fn		int check
+ * \param	bool condition
+ * \param	const char *message
+ * \return	Returns EXIT_SUCCESS if condition holds, and EXIT_FAILURE
+ *		(after printing message) otherwise
+ * \brief	Reports a failed expectation
+ */
+static int check(bool condition, const char* message) {
+	if (!condition) {
+		std::cerr << "FAILURE: " << message << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	return EXIT_SUCCESS;
+}
+
+/**
+ * \fn		int test_ttl_expiry
+ * \param	N/A
+ * \return	Returns EXIT_FAILURE upon any failed expectation,
+ *		and EXIT_SUCCESS otherwise
+ * \brief	A host name is only served from the cache until its TTL runs
+ *		out, and is then looked up again in the background
+ */
+static int test_ttl_expiry() {
+	NameResolver resolver;
+	sockaddr_in socket_address;
+	char buffer[NI_MAXHOST];
+	std::string host_name;
+	int failures;
+
+	failures = 0;
+	socket_address = make_address("127.0.0.1");
+
+	failures += check(resolver.start(TEST_TTL) == EXIT_SUCCESS, "resolver did not start");
+	failures += check(resolver.lookup(&socket_address, buffer, sizeof(buffer)) == EXIT_FAILURE, "first lookup was served before being resolved");
+	failures += check(wait_for_lookup(&resolver, &socket_address, &host_name) == EXIT_SUCCESS, "loopback address was never cached");
+	failures += check(!host_name.empty(), "cached host name is empty");
+
+	std::this_thread::sleep_for(std::chrono::milliseconds(TEST_TTL * 1000 + 200));
+
+	failures += check(resolver.lookup(&socket_address, buffer, sizeof(buffer)) == EXIT_FAILURE, "lookup was served after its TTL ran out");
+	failures += check(wait_for_lookup(&resolver, &socket_address, &host_name) == EXIT_SUCCESS, "expired address was not looked up again");
+
+	resolver.stop();
+
+	return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+/**
+ * \fn		int test_failed_lookup_cache
+ * \param	N/A
+ * \return	Returns EXIT_FAILURE upon any failed expectation,
+ *		and EXIT_SUCCESS otherwise
+ * \brief	An address without a host name (TEST-NET-1 has none) is cached
+ *		as itself, so it is served from the cache until it expires
+ *		instead of being looked up for every client
+ */
+static int test_failed_lookup_cache() {
+	NameResolver resolver;
+	sockaddr_in socket_address;
+	char buffer[NI_MAXHOST];
+	std::string host_name;
+	int failures;
+
+	failures = 0;
+	socket_address = make_address("192.0.2.1");
+
+	failures += check(resolver.start(TEST_TTL * 60) == EXIT_SUCCESS, "resolver did not start");
+	failures += check(wait_for_lookup(&resolver, &socket_address, &host_name) == EXIT_SUCCESS, "unresolvable address was never cached");
+	failures += check(host_name == "192.0.2.1", "unresolvable address was not cached as itself");
+
+	for (int i = 0; i < 100; i++) {
+		if (resolver.lookup(&socket_address, buffer, sizeof(buffer)) != EXIT_SUCCESS || host_name != buffer) {
+			failures += check(false, "cached failed lookup was not served from the cache");
+			break;
+		}
+	}
+
+	resolver.stop();
+
+	return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+int main() {
+	int failures;
+
+	failures = 0;
+	failures += test_ttl_expiry();
+	failures += test_failed_lookup_cache();
+
+	if (failures != 0) {
+		std::cerr << "NameResolverTest: " << failures << " test(s) failed" << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	std::cout << "NameResolverTest: all tests passed" << std::endl;
+	return EXIT_SUCCESS;
+}
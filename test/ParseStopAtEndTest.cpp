@@ -0,0 +1,335 @@
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "../include/pugiconfig.hpp"
+#include "../include/pugixml.hpp"
+
+/**
+ * \def		RANDOM_SEED
+ * \brief	Seed of the randomized tests, so a failure can be replayed
+ */
+#define RANDOM_SEED	(5)
+
+/**
+ * \def		RANDOM_ITERATIONS
+ * \brief	Number of random buffers parsed by test_random_buffers
+ */
+#define RANDOM_ITERATIONS	(5000)
+
+/**
+ * \def		STOP_OPTIONS
+ * \brief	Options every document of a buffer is parsed with
+ */
+#define STOP_OPTIONS	(pugi::parse_default | pugi::parse_stop_at_end)
+
+/**
+ * \var		const char* DOCUMENTS[]
+ * \brief	Documents the randomized tests build their buffers from
+ */
+static const char* DOCUMENTS[] = {
+	"<a/>",
+	"<a></a>",
+	"<?xml version='1.0'?><r x='&gt;' y=\"/&lt;\"><b/>text &amp; more<c a='1'/></r>",
+	"<!-- c --><r><!-- <x> --><![CDATA[ </r> ]]><p><?pi ?></p></r >",
+	"<!DOCTYPE r [ <!ELEMENT r ANY> ]><r>x</r>",
+	"<Request><Command>GetPlayerInfo</Command><Data><Row Type=\"CardNumber\">1</Row></Data></Request>",
+	"<r\n a = '1'\n/>",
+	"<a><b><c></c></b><d/></a>",
+	"<r>&#65;</r>"
+};
+
+/**
+ * \class	EventRecorder
+ * \brief	Used to write down the events of a SAX parse as a string, so
+ *		two parses can be compared
+ */
+class EventRecorder : public pugi::xml_sax_handler {
+public:
+	std::string events;
+
+	bool start_element(const char* name) {
+		events += "<" + std::string(name);
+		return true;
+	}
+
+	bool attribute(const char* name, const char* value) {
+		events += " " + std::string(name) + "=" + value;
+		return true;
+	}
+
+	bool end_element(const char* name) {
+		events += "</" + std::string(name);
+		return true;
+	}
+
+	bool text(const char* value) {
+		events += "T" + std::string(value);
+		return true;
+	}
+
+	bool cdata(const char* value) {
+		events += "C" + std::string(value);
+		return true;
+	}
+};
+
+/**
+ * \fn		int check
+ * \param	bool condition
+ * \param	const char *message
+ * \return	Returns EXIT_SUCCESS if condition holds, and EXIT_FAILURE
+ *		(after printing message) otherwise
+ * \brief	Reports a failed expectation
+ */
+static int check(bool condition, const char* message) {
+	if (!condition) {
+		std::cerr << "FAILURE: " << message << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	return EXIT_SUCCESS;
+}
+
+/**
+ * \fn		std::string serialize
+ * \param	const pugi::xml_document &xml
+ * \return	Returns xml without any formatting
+ * \brief	Used to compare two parsed documents
+ */
+static std::string serialize(const pugi::xml_document& xml) {
+	std::ostringstream output;
+
+	xml.save(output, "", pugi::format_raw);
+	return output.str();
+}
+
+/**
+ * \fn		int test_back_to_back_dom
+ * \param	N/A
+ * \return	Returns EXIT_FAILURE upon any failed expectation,
+ *		and EXIT_SUCCESS otherwise
+ * \brief	Two documents with nothing between them are loaded in place
+ *		one at a time. The first leaves the second untouched, and the
+ *		second ends exactly at the end of the buffer
+ */
+static int test_back_to_back_dom() {
+	std::string original;
+	std::string buffer;
+	pugi::xml_document xml;
+	pugi::xml_parse_result result;
+	size_t first;
+	int failures;
+
+	failures = 0;
+	original = "<a x='1'>text</a><b><c/></b>";
+	buffer = original;
+	first = strlen("<a x='1'>text</a>");
+
+	result = xml.load_buffer_inplace(&buffer[0], buffer.size(), STOP_OPTIONS, pugi::encoding_utf8);
+	failures += check(result && (size_t)result.offset == first, "first document did not stop at its end");
+	failures += check(xml.child("a").attribute("x").as_int() == 1 && strcmp(xml.child("a").child_value(), "text") == 0, "first document was not loaded");
+	failures += check(!xml.child("b"), "second document was loaded with the first");
+	failures += check(buffer.compare(first, std::string::npos, original, first) == 0, "bytes after the first document were modified");
+
+	result = xml.load_buffer_inplace(&buffer[first], buffer.size() - first, STOP_OPTIONS, pugi::encoding_utf8);
+	failures += check(result && (size_t)result.offset == buffer.size() - first, "second document did not end at the end of the buffer");
+	failures += check(xml.child("b").child("c") && !xml.child("a"), "second document was not loaded");
+
+	return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+/**
+ * \fn		int test_back_to_back_sax
+ * \param	N/A
+ * \return	Returns EXIT_FAILURE upon any failed expectation,
+ *		and EXIT_SUCCESS otherwise
+ * \brief	The same as test_back_to_back_dom, through parse_sax_inplace.
+ *		The first parse borrows the last byte of the buffer, which
+ *		has to be back in place for the second
+ */
+static int test_back_to_back_sax() {
+	std::string original;
+	std::string buffer;
+	EventRecorder first_events;
+	EventRecorder second_events;
+	pugi::xml_parse_result result;
+	size_t first;
+	int failures;
+
+	failures = 0;
+	original = "<a x='1'>text</a><b><c/></b>";
+	buffer = original;
+	first = strlen("<a x='1'>text</a>");
+
+	result = pugi::parse_sax_inplace(&buffer[0], buffer.size(), first_events, STOP_OPTIONS, pugi::encoding_utf8);
+	failures += check(result && (size_t)result.offset == first, "first document did not stop at its end");
+	failures += check(first_events.events == "<a x=1Ttext</a", "first document was not reported");
+	failures += check(buffer.compare(first, std::string::npos, original, first) == 0, "bytes after the first document were modified");
+
+	result = pugi::parse_sax_inplace(&buffer[first], buffer.size() - first, second_events, STOP_OPTIONS, pugi::encoding_utf8);
+	failures += check(result && (size_t)result.offset == buffer.size() - first, "second document did not end at the end of the buffer");
+	failures += check(second_events.events == "<b<c</c</b", "second document was not reported");
+
+	return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+/**
+ * \fn		int test_whole_buffer
+ * \param	N/A
+ * \return	Returns EXIT_FAILURE upon any failed expectation,
+ *		and EXIT_SUCCESS otherwise
+ * \brief	A document that ends exactly at the end of the buffer loads
+ *		the same with or without the flag, an unfinished one still
+ *		fails, and trailing whitespace is left for the next parse
+ */
+static int test_whole_buffer() {
+	std::string buffer;
+	pugi::xml_document stopped;
+	pugi::xml_document whole;
+	pugi::xml_parse_result result;
+	int failures;
+
+	failures = 0;
+
+	buffer = "<r a='1'>x<![CDATA[y]]></r>";
+	result = stopped.load_buffer(buffer.data(), buffer.size(), STOP_OPTIONS);
+	failures += check(result && (size_t)result.offset == buffer.size(), "document at the end of the buffer did not end there");
+	failures += check(whole.load_buffer(buffer.data(), buffer.size()) && serialize(stopped) == serialize(whole), "document loaded differently with the flag");
+
+	buffer = "<r>";
+	failures += check(!stopped.load_buffer(buffer.data(), buffer.size(), STOP_OPTIONS), "unfinished document was loaded");
+
+	buffer = "<r/> \n";
+	result = stopped.load_buffer(buffer.data(), buffer.size(), STOP_OPTIONS);
+	failures += check(result && result.offset == 4, "document did not stop before trailing whitespace");
+	result = stopped.load_buffer(buffer.data() + 4, buffer.size() - 4, STOP_OPTIONS);
+	failures += check(result.status == pugi::status_no_document_element, "trailing whitespace was taken for a document");
+
+	return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+/**
+ * \fn		int test_declaration
+ * \param	N/A
+ * \return	Returns EXIT_FAILURE upon any failed expectation,
+ *		and EXIT_SUCCESS otherwise
+ * \brief	A declaration loaded as a node (whose attributes are parsed
+ *		like an element's) is not taken for the end of the document
+ */
+static int test_declaration() {
+	std::string buffer;
+	pugi::xml_document xml;
+	pugi::xml_parse_result result;
+	int failures;
+
+	failures = 0;
+	buffer = "<?xml version='1.0'?><a/><b/>";
+
+	result = xml.load_buffer_inplace(&buffer[0], buffer.size(), STOP_OPTIONS | pugi::parse_declaration, pugi::encoding_utf8);
+	failures += check(result && (size_t)result.offset == strlen("<?xml version='1.0'?><a/>"), "document stopped at the declaration");
+	failures += check(xml.first_child().type() == pugi::node_declaration && xml.first_child().attribute("version") && xml.child("a") && !xml.child("b"), "declaration and document were not loaded");
+
+	return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+/**
+ * \fn		int test_random_buffers
+ * \param	N/A
+ * \return	Returns EXIT_FAILURE upon any failed expectation,
+ *		and EXIT_SUCCESS otherwise
+ * \brief	Buffers of back-to-back DOCUMENTS, with random whitespace
+ *		between them, are parsed in place one document at a time,
+ *		into a tree and as events. Each document is parsed as if it
+ *		were alone, and never touches the bytes after it
+ */
+static int test_random_buffers() {
+	std::mt19937 random(RANDOM_SEED);
+	std::vector<std::string> documents;
+	std::string original;
+	std::string buffer;
+	std::string expected;
+	std::string actual;
+	pugi::xml_parse_result result;
+	size_t position;
+	size_t whitespace;
+
+	for (int iteration = 0; iteration < RANDOM_ITERATIONS; iteration++) {
+		documents.clear();
+		original.clear();
+
+		for (size_t i = 1 + random() % 4; i > 0; i--) {
+			documents.push_back(DOCUMENTS[random() % (sizeof(DOCUMENTS) / sizeof(*DOCUMENTS))]);
+			original.append(random() % 3, ' ');
+			original += documents.back();
+		}
+
+		for (int sax = 0; sax < 2; sax++) {
+			buffer = original;
+			position = 0;
+
+			for (size_t i = 0; i < documents.size(); i++) {
+				expected = documents[i];
+
+				if (sax) {
+					EventRecorder stopped;
+					EventRecorder alone;
+
+					result = pugi::parse_sax_inplace(&buffer[position], buffer.size() - position, stopped, STOP_OPTIONS, pugi::encoding_utf8);
+					pugi::parse_sax_inplace(&expected[0], expected.size(), alone, pugi::parse_default, pugi::encoding_utf8);
+					actual = stopped.events;
+					expected = alone.events;
+				}
+				else {
+					pugi::xml_document stopped;
+					pugi::xml_document alone;
+
+					result = stopped.load_buffer_inplace(&buffer[position], buffer.size() - position, STOP_OPTIONS, pugi::encoding_utf8);
+					alone.load_string(expected.c_str());
+					actual = serialize(stopped);
+					expected = serialize(alone);
+				}
+
+				whitespace = original.find_first_not_of(' ', position) - position;
+
+				if (!result || (size_t)result.offset != whitespace + documents[i].size()) {
+					return check(false, ("document did not stop at its end: " + original).c_str());
+				}
+				if (actual != expected) {
+					return check(false, ("document was parsed differently from alone: " + original).c_str());
+				}
+
+				position += result.offset;
+
+				if (buffer.compare(position, std::string::npos, original, position) != 0) {
+					return check(false, ("bytes after a document were modified: " + original).c_str());
+				}
+			}
+		}
+	}
+
+	return EXIT_SUCCESS;
+}
+
+int main() {
+	int failures;
+
+	failures = 0;
+	failures += test_back_to_back_dom();
+	failures += test_back_to_back_sax();
+	failures += test_whole_buffer();
+	failures += test_declaration();
+	failures += test_random_buffers();
+
+	if (failures != 0) {
+		std::cerr << "ParseStopAtEndTest: " << failures << " test(s) failed" << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	std::cout << "ParseStopAtEndTest: all tests passed" << std::endl;
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,326 @@
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "../include/pugiconfig.hpp"
+#include "../include/pugixml.hpp"
+#include "../include/RequestSchema.h"
+#include "../include/RequestReader.h"
+
+/**
+ * \def		RANDOM_SEED
+ * \brief	Seed of the randomized tests, so a failure can be replayed
+ */
+#define RANDOM_SEED	(14)
+
+/**
+ * \def		RANDOM_ITERATIONS
+ * \brief	Number of random requests read by test_random_requests
+ */
+#define RANDOM_ITERATIONS	(20000)
+
+/**
+ * \var		const char* COMMAND
+ * \brief	A valid Command
+ */
+static const char* COMMAND = "<Command>GetPlayerInfo</Command>";
+
+/**
+ * \var		const char* DATA
+ * \brief	A valid Data for GetPlayerInfo
+ */
+static const char* DATA = "<Data><Row Type=\"CardNumber\">6440750000000003</Row><Row Type=\"PIN\">1234</Row></Data>";
+
+/**
+ * \struct	RequestCase
+ * \brief	A request, and whether it is valid
+ */
+struct RequestCase {
+	std::string request;
+	bool valid;
+};
+
+/**
+ * \fn		std::string make_request
+ * \param	const std::string &command
+ * \param	const std::string &data
+ * \return	Returns a Request holding command and data
+ * \brief	Builds the requests of CASES
+ */
+static std::string make_request(const std::string& command, const std::string& data) {
+	return "<Request>" + command + data + "</Request>";
+}
+
+/**
+ * \var		const std::vector<RequestCase> CASES
+ * \brief	Requests both paths are checked against, valid and invalid
+ */
+static const std::vector<RequestCase> CASES = {
+	/**
+	 *	- Valid, however the envelope is laid out
+	 */
+	{ make_request(COMMAND, DATA), true },
+	{ make_request(DATA, COMMAND), true },
+	{ make_request(COMMAND, "<Data><Row Type=\"PIN\">1234</Row><Row Type=\"CardNumber\">6440750000000003</Row></Data>"), true },
+	{ "<?xml version=\"1.0\"?>\n<Request>\n\t" + std::string(COMMAND) + "\n\t" + DATA + "\n</Request>\n", true },
+	{ make_request(COMMAND, "<Data><Row Type='CardNumber'>&lt;6440&amp;</Row><Row Type='PIN'>&#49;234</Row></Data>"), true },
+	{ make_request(COMMAND, "<Data>\n<Row Type=\"CardNumber\">6440750000000003</Row>\n<Row Type=\"PIN\"></Row>\n</Data>"), true },
+	{ make_request(COMMAND, "<Data><Row Type=\"CardNumber\">6440750000000003</Row><Row Type=\"PIN\"/></Data>"), true },
+
+	/**
+	 *	- Comments and processing instructions are skipped
+	 */
+	{ "<!-- before --><Request><!-- c -->" + std::string(COMMAND) + "<?pi x?>" + DATA + "</Request><!-- after -->", true },
+	{ make_request(COMMAND, DATA) + "\ntext after the document is dropped", true },
+	{ make_request("<Command>Get<!-- c -->PlayerInfo</Command>", DATA), false },
+
+	/**
+	 *	- An unknown command is valid, with no command, if its Rows would
+	 *	  be for GetPlayerInfo
+	 */
+	{ make_request("<Command>Unknown</Command>", DATA), true },
+	{ make_request("<Command/>", DATA), true },
+	{ make_request("<Command>getplayerinfo</Command>", DATA), true },
+	{ make_request("<Command>Unknown</Command>", "<Data><Row Type=\"Other\">1</Row></Data>"), false },
+
+	/**
+	 *	- Duplicates
+	 */
+	{ make_request(std::string(COMMAND) + COMMAND, DATA), false },
+	{ make_request(std::string(COMMAND) + "<Command/>", DATA), false },
+	{ make_request("<Command/>" + std::string(COMMAND), DATA), false },
+	{ make_request(COMMAND, std::string(DATA) + "<Data/>"), false },
+	{ make_request(COMMAND, std::string(DATA) + DATA), false },
+	{ make_request(COMMAND, "<Data><Row Type=\"CardNumber\">1</Row><Row Type=\"PIN\">2</Row><Row Type=\"PIN\">3</Row></Data>"), false },
+	{ make_request(COMMAND, "<Data><Row Type=\"CardNumber\">1</Row><Row Type=\"CardNumber\">1</Row><Row Type=\"PIN\">2</Row></Data>"), false },
+	{ make_request(COMMAND, DATA) + make_request(COMMAND, DATA), false },
+	{ make_request(COMMAND, DATA) + "<Request/>", false },
+	{ make_request(COMMAND, "<Data><Row Type=\"Other\" Type=\"CardNumber\">1</Row><Row Type=\"PIN\">2</Row></Data>"), false },
+
+	/**
+	 *	- CDATA, where only text is allowed
+	 */
+	{ make_request("<Command><![CDATA[GetPlayerInfo]]></Command>", DATA), false },
+	{ make_request(COMMAND, "<Data><Row Type=\"CardNumber\"><![CDATA[6440750000000003]]></Row><Row Type=\"PIN\">1234</Row></Data>"), false },
+	{ make_request(COMMAND, "<Data><Row Type=\"CardNumber\">6440<![CDATA[75]]></Row><Row Type=\"PIN\">1234</Row></Data>"), false },
+	{ make_request(std::string(COMMAND) + "<![CDATA[x]]>", DATA), false },
+
+	/**
+	 *	- Trailing siblings, and anything else out of place
+	 */
+	{ make_request(COMMAND, DATA) + "<Extra/>", false },
+	{ make_request(COMMAND, DATA) + "<!-- c --><Extra></Extra>", false },
+	{ make_request(COMMAND, DATA) + "<![CDATA[x]]>", false },
+	{ make_request(COMMAND, std::string(DATA) + "<Extra/>"), false },
+	{ make_request(COMMAND, "<Data><Row Type=\"CardNumber\">1</Row><Row Type=\"PIN\">2</Row><Extra/></Data>"), false },
+	{ make_request(COMMAND, "<Data>x<Row Type=\"CardNumber\">1</Row><Row Type=\"PIN\">2</Row></Data>"), false },
+	{ make_request(COMMAND, "<Data><Row Type=\"CardNumber\">1<b/></Row><Row Type=\"PIN\">2</Row></Data>"), false },
+	{ make_request("<Command>GetPlayerInfo<b/></Command>", DATA), false },
+	{ "<Request>text" + std::string(COMMAND) + DATA + "</Request>", false },
+	{ "<Other>" + std::string(COMMAND) + DATA + "</Other>", false },
+
+	/**
+	 *	- Empty or missing Rows
+	 */
+	{ make_request(COMMAND, "<Data><Row/><Row Type=\"CardNumber\">1</Row><Row Type=\"PIN\">2</Row></Data>"), false },
+	{ make_request(COMMAND, "<Data><Row></Row><Row Type=\"CardNumber\">1</Row><Row Type=\"PIN\">2</Row></Data>"), false },
+	{ make_request(COMMAND, "<Data><Row Type=\"CardNumber\">1</Row></Data>"), false },
+	{ make_request(COMMAND, "<Data/>"), false },
+	{ make_request(COMMAND, "<Data><Row Type=\"CardNumber\">1</Row><Row Type=\"PIN\">2</Row><Row Type=\"Other\">3</Row></Data>"), false },
+
+	/**
+	 *	- Attributes
+	 */
+	{ "<Request a=\"1\">" + std::string(COMMAND) + DATA + "</Request>", false },
+	{ make_request("<Command a=\"1\">GetPlayerInfo</Command>", DATA), false },
+	{ make_request(COMMAND, "<Data a=\"1\"><Row Type=\"CardNumber\">1</Row><Row Type=\"PIN\">2</Row></Data>"), false },
+	{ make_request(COMMAND, "<Data><Row Type=\"CardNumber\" a=\"1\">1</Row><Row Type=\"PIN\">2</Row></Data>"), false },
+	{ make_request(COMMAND, "<Data><Row a=\"1\" Type=\"CardNumber\">1</Row><Row Type=\"PIN\">2</Row></Data>"), false },
+
+	/**
+	 *	- Missing parts, and malformed XML
+	 */
+	{ make_request(COMMAND, ""), false },
+	{ make_request("", DATA), false },
+	{ "<Request/>", false },
+	{ "", false },
+	{ "   ", false },
+	{ "<Request>" + std::string(COMMAND) + DATA, false },
+	{ make_request(COMMAND, DATA).substr(0, 40), false },
+	{ "<Request>" + std::string(COMMAND) + DATA + "</Reqest>", false },
+	{ make_request("<Command>GetPlayerInfo</Data>", DATA), false }
+};
+
+/**
+ * \var		const char* PIECES[]
+ * \brief	Pieces test_random_requests puts together at random, weighted
+ *		towards the ones of a valid request
+ */
+static const char* PIECES[] = {
+	"<Request>", "<Request>", "</Request>", "</Request>",
+	"<Command>", "</Command>", "GetPlayerInfo", "GetPlayerInfo", "Unknown", "<Command/>",
+	"<Data>", "<Data>", "</Data>", "</Data>", "<Data/>",
+	"<Row Type=\"CardNumber\">", "<Row Type=\"PIN\">", "<Row Type=\"PIN\">", "<Row Type=\"CardNumber\">", "<Row Type=\"Other\">", "<Row>", "<Row/>", "<Row Type=\"PIN\"/>",
+	"</Row>", "</Row>", "</Row>", "1234", "6440750000000003",
+	"<![CDATA[1]]>", "<!-- c -->", "<?pi ?>", " ", "\n", "&amp;", "<x/>", "<Row Type=\"PIN\" a=\"1\">", "<Request a=\"1\">"
+};
+
+/**
+ * \fn		int check_request
+ * \param	const std::string &request
+ * \param	bool *valid
+ * \return	Returns EXIT_FAILURE upon any failed expectation,
+ *		and EXIT_SUCCESS otherwise
+ * \brief	request is read by RequestReader and loaded and validated by
+ *		RequestSchema, both in place as the server does, and both
+ *		give the same verdict (returned in valid), the same command,
+ *		and for a valid request the same values
+ */
+static int check_request(const std::string& request, bool* valid) {
+	static RequestReader reader;
+	pugi::xml_document xml;
+	std::string dom_buffer;
+	std::string sax_buffer;
+	const CommandSchema* dom_command;
+	const CommandSchema* sax_command;
+	std::string_view dom_values[RequestSchema::MAX_ROWS];
+	std::string_view sax_values[RequestSchema::MAX_ROWS];
+	bool dom_valid;
+	bool sax_valid;
+
+	/**
+	 *	- As SocketServer::handle_request does, a request that is not
+	 *	  well-formed is not validated
+	 */
+	dom_buffer = request;
+	dom_command = NULL;
+	dom_valid = xml.load_buffer_inplace(&dom_buffer[0], dom_buffer.size()) && RequestSchema::validate(xml, &dom_command, dom_values);
+
+	sax_buffer = request;
+	sax_valid = reader.read(&sax_buffer[0], sax_buffer.size(), &sax_command, sax_values);
+
+	if (dom_valid != sax_valid || dom_command != sax_command) {
+		std::cerr << "FAILURE: request was " << (dom_valid ? "valid" : "invalid") << " in a document, but " << (sax_valid ? "valid" : "invalid") << " when read, or got another command: " << request << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	if (dom_valid) {
+		for (size_t i = 0; i < RequestSchema::MAX_ROWS; i++) {
+			if (dom_values[i] != sax_values[i]) {
+				std::cerr << "FAILURE: value " << i << " was " << dom_values[i] << " in a document, but " << sax_values[i] << " when read: " << request << std::endl;
+				return EXIT_FAILURE;
+			}
+		}
+	}
+
+	*valid = dom_valid;
+
+	return EXIT_SUCCESS;
+}
+
+/**
+ * \fn		int test_cases
+ * \param	N/A
+ * \return	Returns EXIT_FAILURE upon any failed expectation,
+ *		and EXIT_SUCCESS otherwise
+ * \brief	Every request of CASES gets the same verdict from both paths,
+ *		and the one expected. Valid GetPlayerInfo requests have their
+ *		command and values set
+ */
+static int test_cases() {
+	std::string buffer;
+	const CommandSchema* command;
+	std::string_view values[RequestSchema::MAX_ROWS];
+	RequestReader reader;
+	GetPlayerInfoRequest request;
+	bool valid;
+	int failures;
+
+	failures = 0;
+
+	for (const RequestCase& request_case : CASES) {
+		if (check_request(request_case.request, &valid) != EXIT_SUCCESS) {
+			failures++;
+		}
+		else if (valid != request_case.valid) {
+			std::cerr << "FAILURE: request was " << (valid ? "valid" : "invalid") << ": " << request_case.request << std::endl;
+			failures++;
+		}
+	}
+
+	buffer = make_request(COMMAND, DATA);
+	if (!reader.read(&buffer[0], buffer.size(), &command, values) || command == NULL || strcmp(command->command, "GetPlayerInfo") != 0) {
+		std::cerr << "FAILURE: GetPlayerInfo was not found" << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	request = RequestSchema::get_player_info(values);
+	if (request.card != "6440750000000003" || request.pin != "1234") {
+		std::cerr << "FAILURE: values of GetPlayerInfo were not read" << std::endl;
+		failures++;
+	}
+
+	return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+/**
+ * \fn		int test_random_requests
+ * \param	N/A
+ * \return	Returns EXIT_FAILURE upon any failed expectation,
+ *		and EXIT_SUCCESS otherwise
+ * \brief	Requests made of random PIECES get the same verdict, command
+ *		and values from both paths. Some of them are valid
+ */
+static int test_random_requests() {
+	std::mt19937 random(RANDOM_SEED);
+	std::string request;
+	size_t valid_count;
+	bool valid;
+
+	valid_count = 0;
+
+	for (int iteration = 0; iteration < RANDOM_ITERATIONS; iteration++) {
+		/**
+		 *	- Start from a valid request half the time, and put pieces
+		 *	  in, so most requests are nearly valid
+		 */
+		request = random() % 2 ? make_request(COMMAND, DATA) : "";
+
+		for (size_t i = random() % 16; i > 0; i--) {
+			request.insert(request.empty() ? 0 : random() % request.size(), PIECES[random() % (sizeof(PIECES) / sizeof(*PIECES))]);
+		}
+
+		if (check_request(request, &valid) != EXIT_SUCCESS) {
+			return EXIT_FAILURE;
+		}
+
+		valid_count += valid;
+	}
+
+	if (valid_count == 0) {
+		std::cerr << "FAILURE: no random request was valid" << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	return EXIT_SUCCESS;
+}
+
+int main() {
+	int failures;
+
+	failures = 0;
+	failures += test_cases();
+	failures += test_random_requests();
+
+	if (failures != 0) {
+		std::cerr << "RequestReaderTest: " << failures << " test(s) failed" << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	std::cout << "RequestReaderTest: all tests passed" << std::endl;
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,288 @@
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+
+#include "../include/pugiconfig.hpp"
+#include "../include/pugixml.hpp"
+
+/**
+ * \def		RANDOM_SEED
+ * \brief	Seed of the randomized tests, so a failure can be replayed
+ */
+#define RANDOM_SEED	(23)
+
+/**
+ * \def		RANDOM_ITERATIONS
+ * \brief	Number of random texts written by test_random_texts, under
+ *		every entry of FLAGS
+ */
+#define RANDOM_ITERATIONS	(3000)
+
+/**
+ * \def		MAX_LENGTH
+ * \brief	Texts are up to this long, so they end anywhere in the first
+ *		two 32-byte blocks and just past them
+ */
+#define MAX_LENGTH	(70)
+
+/**
+ * \def		ALIGNMENTS
+ * \brief	Texts start at every offset of a 32-byte block
+ */
+#define ALIGNMENTS	(32)
+
+/**
+ * \def		PARSE_OPTIONS
+ * \brief	Options the texts are loaded with: character data that is
+ *		only whitespace is kept, and nothing but the predefined
+ *		entities is converted
+ */
+#define PARSE_OPTIONS	(pugi::parse_minimal | pugi::parse_escapes | pugi::parse_ws_pcdata)
+
+/**
+ * \var		const unsigned int FLAGS[]
+ * \brief	Flags the texts are written with, besides format_raw and
+ *		format_no_declaration
+ */
+static const unsigned int FLAGS[] = {
+	0,
+	pugi::format_skip_control_chars,
+	pugi::format_attribute_single_quote,
+	pugi::format_skip_control_chars | pugi::format_attribute_single_quote
+};
+
+/**
+ * \var		const char SPECIALS[]
+ * \brief	Characters that are escaped (or, between them, are not) in
+ *		either character data or attribute values
+ */
+static const char SPECIALS[] = "&<>\"'\t\n\r\x01\x1f\x7f\x80 ";
+
+/**
+ * \fn		std::string escape
+ * \param	const std::string &text
+ * \param	bool attribute
+ * \param	unsigned int flags
+ * \return	Returns text as written into an attribute value, or as
+ *		character data
+ * \brief	Reference for the escaping, one character at a time
+ */
+static std::string escape(const std::string& text, bool attribute, unsigned int flags) {
+	std::string escaped;
+	unsigned char character;
+
+	for (char c : text) {
+		character = (unsigned char)c;
+
+		if (character == '&') {
+			escaped += "&amp;";
+		}
+		else if (character == '<') {
+			escaped += "&lt;";
+		}
+		else if (character == '>' && !attribute) {
+			escaped += "&gt;";
+		}
+		else if (character == '"' && attribute && !(flags & pugi::format_attribute_single_quote)) {
+			escaped += "&quot;";
+		}
+		else if (character == '\'' && attribute && (flags & pugi::format_attribute_single_quote)) {
+			escaped += "&apos;";
+		}
+		else if (character < 32 && (attribute || (character != '\t' && character != '\n' && character != '\r'))) {
+			if (!(flags & pugi::format_skip_control_chars)) {
+				escaped += "&#" + std::to_string(character / 10) + std::to_string(character % 10) + ";";
+			}
+		}
+		else {
+			escaped += c;
+		}
+	}
+
+	return escaped;
+}
+
+/**
+ * \fn		std::string unparse
+ * \param	const std::string &text
+ * \return	Returns text as it has to be in a document for PARSE_OPTIONS
+ *		to load it back unchanged, in character data or in a value
+ *		between double quotes
+ * \brief	Builds the documents the texts are loaded from
+ */
+static std::string unparse(const std::string& text) {
+	std::string source;
+
+	for (char c : text) {
+		if (c == '&') {
+			source += "&amp;";
+		}
+		else if (c == '<') {
+			source += "&lt;";
+		}
+		else if (c == '"') {
+			source += "&quot;";
+		}
+		else {
+			source += c;
+		}
+	}
+
+	return source;
+}
+
+/**
+ * \fn		int check_text
+ * \param	const std::string &text
+ * \param	size_t alignment
+ * \param	bool attribute
+ * \return	Returns EXIT_FAILURE upon any failed expectation,
+ *		and EXIT_SUCCESS otherwise
+ * \brief	text is loaded in place as the value of an attribute, or as
+ *		character data, starting at alignment in a 32-byte block (so
+ *		the scan starts there too), and written with every entry of
+ *		FLAGS. Each time the output matches the reference
+ */
+static int check_text(const std::string& text, size_t alignment, bool attribute) {
+	pugi::xml_document xml;
+	std::string buffer;
+	std::string prefix;
+	std::string expected;
+	const char* value;
+	size_t padding;
+	char quote;
+
+	/**
+	 *	- Pad the document with leading whitespace until the text starts
+	 *	  at alignment
+	 */
+	prefix = attribute ? "<e a=\"" : "<e>";
+	buffer.reserve(ALIGNMENTS + prefix.size() + text.size() * 6 + 8);
+	padding = (ALIGNMENTS + alignment - ((uintptr_t)buffer.data() + prefix.size()) % ALIGNMENTS) % ALIGNMENTS;
+	buffer.assign(padding, ' ');
+	buffer += prefix + unparse(text) + (attribute ? "\"/>" : "</e>");
+
+	if (!xml.load_buffer_inplace(&buffer[0], buffer.size(), PARSE_OPTIONS, pugi::encoding_utf8)) {
+		std::cerr << "FAILURE: document did not load: " << buffer << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	value = attribute ? xml.child("e").attribute("a").value() : xml.child("e").text().get();
+	if (value != text || (!text.empty() && (uintptr_t)value % ALIGNMENTS != alignment)) {
+		std::cerr << "FAILURE: text was not loaded in place at alignment " << alignment << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	for (unsigned int flags : FLAGS) {
+		std::ostringstream output;
+
+		xml.save(output, "", pugi::format_raw | pugi::format_no_declaration | flags);
+
+		quote = (flags & pugi::format_attribute_single_quote) ? '\'' : '"';
+		if (attribute) {
+			expected = "<e a=" + std::string(1, quote) + escape(text, true, flags) + quote + "/>";
+		}
+		else {
+			expected = text.empty() ? "<e/>" : "<e>" + escape(text, false, flags) + "</e>";
+		}
+
+		if (output.str() != expected) {
+			std::cerr << "FAILURE: " << (attribute ? "attribute value" : "character data") << " of length " << text.size() << " at alignment " << alignment << " escaped wrongly with flags " << flags << ": " << output.str() << std::endl;
+			return EXIT_FAILURE;
+		}
+	}
+
+	return EXIT_SUCCESS;
+}
+
+/**
+ * \fn		int test_every_length_and_alignment
+ * \param	N/A
+ * \return	Returns EXIT_FAILURE upon any failed expectation,
+ *		and EXIT_SUCCESS otherwise
+ * \brief	Texts of every length up to MAX_LENGTH, at every alignment,
+ *		are written the same as the reference with no special
+ *		character in them, and with one at every position
+ */
+static int test_every_length_and_alignment() {
+	std::string text;
+
+	for (size_t length = 0; length <= MAX_LENGTH; length++) {
+		for (size_t alignment = 0; alignment < ALIGNMENTS; alignment++) {
+			for (size_t position = 0; position <= length; position++) {
+				text = std::string(length, 'x');
+
+				/**
+				 *	- position == length is the text without a special
+				 *	  character
+				 */
+				if (position < length) {
+					text[position] = SPECIALS[(position + alignment) % (sizeof(SPECIALS) - 1)];
+				}
+
+				for (bool attribute : { false, true }) {
+					if (check_text(text, alignment, attribute) != EXIT_SUCCESS) {
+						return EXIT_FAILURE;
+					}
+				}
+			}
+		}
+	}
+
+	return EXIT_SUCCESS;
+}
+
+/**
+ * \fn		int test_random_texts
+ * \param	N/A
+ * \return	Returns EXIT_FAILURE upon any failed expectation,
+ *		and EXIT_SUCCESS otherwise
+ * \brief	Texts of any byte but zero, and of runs of plain characters
+ *		between SPECIALS, at random lengths and alignments, are
+ *		written the same as the reference
+ */
+static int test_random_texts() {
+	std::mt19937 random(RANDOM_SEED);
+	std::string text;
+
+	for (int iteration = 0; iteration < RANDOM_ITERATIONS; iteration++) {
+		text.clear();
+
+		if (random() % 2) {
+			for (size_t i = random() % (MAX_LENGTH * 2); i > 0; i--) {
+				text += (char)(1 + random() % 255);
+			}
+		}
+		else {
+			for (size_t i = random() % 8; i > 0; i--) {
+				text.append(random() % 40, 'x');
+				text += SPECIALS[random() % (sizeof(SPECIALS) - 1)];
+			}
+		}
+
+		if (check_text(text, random() % ALIGNMENTS, random() % 2) != EXIT_SUCCESS) {
+			return EXIT_FAILURE;
+		}
+	}
+
+	return EXIT_SUCCESS;
+}
+
+int main() {
+	int failures;
+
+	failures = 0;
+	failures += test_every_length_and_alignment();
+	failures += test_random_texts();
+
+	if (failures != 0) {
+		std::cerr << "TextEscapeTest: " << failures << " test(s) failed" << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	std::cout << "TextEscapeTest: all tests passed" << std::endl;
+	return EXIT_SUCCESS;
+}
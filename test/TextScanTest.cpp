@@ -0,0 +1,261 @@
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <string>
+
+#include "../include/pugiconfig.hpp"
+#include "../include/pugixml.hpp"
+
+/**
+ * \def		RANDOM_SEED
+ * \brief	Seed of the randomized tests, so a failure can be replayed
+ */
+#define RANDOM_SEED	(21)
+
+/**
+ * \def		RANDOM_ITERATIONS
+ * \brief	Number of random texts parsed by test_random_texts, under
+ *		every entry of OPTIONS
+ */
+#define RANDOM_ITERATIONS	(3000)
+
+/**
+ * \def		MAX_OFFSET
+ * \brief	test_every_byte puts each byte at every offset below this,
+ *		which covers every position in two 32-byte blocks
+ */
+#define MAX_OFFSET	(67)
+
+/**
+ * \def		MAX_NAME_LENGTH
+ * \brief	Element names are up to this long, which shifts the text
+ *		against the blocks it is scanned in
+ */
+#define MAX_NAME_LENGTH	(32)
+
+/**
+ * \var		const unsigned int OPTIONS[]
+ * \brief	Options the texts are parsed with. Between them they pick
+ *		every kind of character data and attribute value conversion
+ */
+static const unsigned int OPTIONS[] = {
+	pugi::parse_minimal,
+	pugi::parse_escapes,
+	pugi::parse_eol,
+	pugi::parse_eol | pugi::parse_escapes,
+	pugi::parse_wconv_attribute,
+	pugi::parse_default,
+	pugi::parse_wnorm_attribute,
+	pugi::parse_wnorm_attribute | pugi::parse_escapes | pugi::parse_eol | pugi::parse_trim_pcdata
+};
+
+/**
+ * \var		const char* TOKENS[]
+ * \brief	Pieces the random texts are made of, weighted towards the
+ *		characters the scans stop at
+ */
+static const char* TOKENS[] = {
+	"a", " ", "\t", "\n", "\r", "\r\n", "  \t ", "&", "&amp;", "&lt;", "&gt;", "&quot;", "&apos;", "'", ">", "]", "\x7f", "\x80", "\xc3\xa9", "\xff"
+};
+
+/**
+ * \fn		bool is_space
+ * \param	char character
+ * \return	Returns true if character is XML whitespace
+ * \brief	The whitespace attribute value normalization works on
+ */
+static bool is_space(char character) {
+	return character == ' ' || character == '\t' || character == '\n' || character == '\r';
+}
+
+/**
+ * \fn		std::string unescape
+ * \param	const std::string &raw
+ * \return	Returns raw with its predefined entities replaced
+ * \brief	Reference for parse_escapes. An & that starts no entity is
+ *		kept, the way pugixml keeps it
+ */
+static std::string unescape(const std::string& raw) {
+	static const char* ENTITIES[][2] = { { "&amp;", "&" }, { "&lt;", "<" }, { "&gt;", ">" }, { "&quot;", "\"" }, { "&apos;", "'" } };
+	std::string text;
+	bool replaced;
+
+	for (size_t i = 0; i < raw.size(); ) {
+		replaced = false;
+
+		for (auto& entity : ENTITIES) {
+			if (raw.compare(i, strlen(entity[0]), entity[0]) == 0) {
+				text += entity[1];
+				i += strlen(entity[0]);
+				replaced = true;
+				break;
+			}
+		}
+
+		if (!replaced) {
+			text += raw[i++];
+		}
+	}
+
+	return text;
+}
+
+/**
+ * \fn		std::string expected_text
+ * \param	const std::string &raw
+ * \param	unsigned int options
+ * \param	bool attribute
+ * \return	Returns what pugixml should make of raw as the value of an
+ *		attribute, or as character data
+ * \brief	Reference for the conversions, one character at a time.
+ *		The predefined entities never produce whitespace, so they
+ *		are replaced first
+ */
+static std::string expected_text(const std::string& raw, unsigned int options, bool attribute) {
+	std::string source;
+	std::string text;
+
+	source = (options & pugi::parse_escapes) ? unescape(raw) : raw;
+
+	for (size_t i = 0; i < source.size(); i++) {
+		if (attribute && (options & pugi::parse_wnorm_attribute)) {
+			if (!is_space(source[i])) {
+				text += source[i];
+			}
+			else if (!text.empty() && text.back() != ' ') {
+				text += ' ';
+			}
+		}
+		else if (attribute && (options & pugi::parse_wconv_attribute) && is_space(source[i])) {
+			text += ' ';
+			i += (source[i] == '\r' && i + 1 < source.size() && source[i + 1] == '\n');
+		}
+		else if ((options & pugi::parse_eol) && source[i] == '\r') {
+			text += '\n';
+			i += (i + 1 < source.size() && source[i + 1] == '\n');
+		}
+		else {
+			text += source[i];
+		}
+	}
+
+	/**
+	 *	- Normalization also drops the whitespace at the end
+	 */
+	if (attribute && (options & pugi::parse_wnorm_attribute) && !text.empty() && text.back() == ' ') {
+		text.pop_back();
+	}
+
+	return text;
+}
+
+/**
+ * \fn		int check_text
+ * \param	const std::string &raw
+ * \param	size_t name_length
+ * \param	unsigned int options
+ * \return	Returns EXIT_FAILURE upon any failed expectation,
+ *		and EXIT_SUCCESS otherwise
+ * \brief	raw is parsed as character data (between brackets, so it is
+ *		never whitespace only) and as an attribute value of an element
+ *		whose name is name_length long, and matches the reference
+ */
+static int check_text(const std::string& raw, size_t name_length, unsigned int options) {
+	std::string name;
+	std::string document;
+	pugi::xml_document xml;
+
+	name = "e" + std::string(name_length, 'x');
+
+	document = "<" + name + ">[" + raw + "]</" + name + ">";
+	if (!xml.load_buffer(document.data(), document.size(), options, pugi::encoding_utf8) || xml.child(name.c_str()).child_value() != "[" + expected_text(raw, options, false) + "]") {
+		std::cerr << "FAILURE: character data converted wrongly with options " << options << ": " << document << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	document = "<" + name + " a=\"" + raw + "\"/>";
+	if (!xml.load_buffer(document.data(), document.size(), options, pugi::encoding_utf8) || xml.child(name.c_str()).attribute("a").value() != expected_text(raw, options, true)) {
+		std::cerr << "FAILURE: attribute value converted wrongly with options " << options << ": " << document << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	return EXIT_SUCCESS;
+}
+
+/**
+ * \fn		int test_every_byte
+ * \param	N/A
+ * \return	Returns EXIT_FAILURE upon any failed expectation,
+ *		and EXIT_SUCCESS otherwise
+ * \brief	Every byte that may appear unescaped in both places is found
+ *		(or skipped) by the scans at every offset of a block, with
+ *		the text starting at varying offsets in the buffer
+ */
+static int test_every_byte() {
+	std::string raw;
+
+	for (int byte = 1; byte < 256; byte++) {
+		if (byte == '<' || byte == '"') {
+			continue;
+		}
+
+		for (size_t offset = 0; offset < MAX_OFFSET; offset++) {
+			raw = std::string(offset, 'x') + (char)byte + std::string(5, 'x');
+
+			for (unsigned int options : OPTIONS) {
+				if (check_text(raw, (byte + offset) % MAX_NAME_LENGTH, options) != EXIT_SUCCESS) {
+					return EXIT_FAILURE;
+				}
+			}
+		}
+	}
+
+	return EXIT_SUCCESS;
+}
+
+/**
+ * \fn		int test_random_texts
+ * \param	N/A
+ * \return	Returns EXIT_FAILURE upon any failed expectation,
+ *		and EXIT_SUCCESS otherwise
+ * \brief	Texts of TOKENS between runs of plain characters, long and
+ *		short enough to end anywhere in a block, match the reference
+ */
+static int test_random_texts() {
+	std::mt19937 random(RANDOM_SEED);
+	std::string raw;
+
+	for (int iteration = 0; iteration < RANDOM_ITERATIONS; iteration++) {
+		raw.clear();
+
+		for (size_t i = random() % 12; i > 0; i--) {
+			raw.append(random() % 40, 'x');
+			raw += TOKENS[random() % (sizeof(TOKENS) / sizeof(*TOKENS))];
+		}
+
+		for (unsigned int options : OPTIONS) {
+			if (check_text(raw, random() % MAX_NAME_LENGTH, options) != EXIT_SUCCESS) {
+				return EXIT_FAILURE;
+			}
+		}
+	}
+
+	return EXIT_SUCCESS;
+}
+
+int main() {
+	int failures;
+
+	failures = 0;
+	failures += test_every_byte();
+	failures += test_random_texts();
+
+	if (failures != 0) {
+		std::cerr << "TextScanTest: " << failures << " test(s) failed" << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	std::cout << "TextScanTest: all tests passed" << std::endl;
+	return EXIT_SUCCESS;
+}
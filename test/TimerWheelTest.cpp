@@ -0,0 +1,344 @@
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <set>
+#include <vector>
+
+#include "../include/TimerWheel.h"
+
+/**
+ * \def		MAX_TICKS
+ * \brief	Ticks covered by the four wheels of 64 slots. A timer is
+ *		never scheduled further out than this
+ */
+#define MAX_TICKS	(1ULL << 24)
+
+/**
+ * \var		const unsigned long long OFFSETS[]
+ * \brief	Ticks from the current tick that timers are scheduled at:
+ *		either side of every wheel's range and slot boundaries, and
+ *		the last tick covered
+ */
+static const unsigned long long OFFSETS[] = {
+	1, 2, 3, 62, 63, 64, 65, 66, 127, 128, 129, 1000,
+	4095, 4096, 4097, 4160, 8191, 8192, 100000,
+	262143, 262144, 262145, 266240, 524288, 5000000,
+	MAX_TICKS - 2, MAX_TICKS - 1
+};
+
+/**
+ * \class	WheelClock
+ * \brief	Used to name times by their tick. origin is taken just
+ *		before the wheel is made, so its tick 0 starts up to a
+ *		fraction of a tick after origin: a deadline a whole number
+ *		of ticks after origin rounds up to that tick, and the time
+ *		half a tick into a tick falls in it
+ */
+class WheelClock {
+public:
+	std::chrono::steady_clock::time_point origin;
+
+	WheelClock() {
+		origin = std::chrono::steady_clock::now();
+	}
+
+	std::chrono::steady_clock::time_point deadline(unsigned long long tick) {
+		return origin + std::chrono::milliseconds(tick * TimerWheel::TICK_MS);
+	}
+
+	std::chrono::steady_clock::time_point during(unsigned long long tick) {
+		return origin + std::chrono::milliseconds(tick * TimerWheel::TICK_MS + TimerWheel::TICK_MS / 2);
+	}
+};
+
+/**
+ * \fn		int check
+ * \param	bool condition
+ * \param	const char *message
+ * \return	Returns EXIT_SUCCESS if condition holds, and EXIT_FAILURE
+ *		(after printing message) otherwise
+ * \brief	Reports a failed expectation
+ */
+static int check(bool condition, const char* message) {
+	if (!condition) {
+		std::cerr << "FAILURE: " << message << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	return EXIT_SUCCESS;
+}
+
+/**
+ * \fn		void init_timers
+ * \param	std::vector<Timer> *timers
+ * \param	size_t count
+ * \return	N/A
+ * \brief	Makes count unscheduled timers, each its own owner
+ */
+static void init_timers(std::vector<Timer>* timers, size_t count) {
+	timers->assign(count, Timer());
+
+	for (Timer& timer : *timers) {
+		timer.prev = NULL;
+		timer.next = NULL;
+		timer.owner = &timer;
+	}
+}
+
+/**
+ * \fn		int expire_all
+ * \param	TimerWheel *wheel
+ * \param	WheelClock *clock
+ * \param	std::vector<Timer> *timers
+ * \param	const std::vector<unsigned long long> &expected
+ * \param	unsigned long long from
+ * \return	Returns EXIT_FAILURE upon any failed expectation,
+ *		and EXIT_SUCCESS otherwise
+ * \brief	Advances wheel from tick from, stopping on each tick in
+ *		expected and the one before it. Every timer has to expire
+ *		exactly once, on its tick in expected (0 for a timer that
+ *		must never expire), and no timer may expire on any other
+ */
+static int expire_all(TimerWheel* wheel, WheelClock* clock, std::vector<Timer>* timers, const std::vector<unsigned long long>& expected, unsigned long long from) {
+	std::set<unsigned long long> ticks;
+	std::multiset<size_t> due;
+	std::multiset<size_t> fired;
+	std::vector<void*> expired;
+
+	for (unsigned long long tick : expected) {
+		if (tick != 0) {
+			ticks.insert(tick);
+		}
+	}
+
+	for (unsigned long long tick : ticks) {
+		if (tick - 1 > from) {
+			expired.clear();
+			wheel->advance(clock->during(tick - 1), &expired);
+
+			if (!expired.empty()) {
+				return check(false, "timer expired before its tick");
+			}
+		}
+
+		expired.clear();
+		wheel->advance(clock->during(tick), &expired);
+
+		due.clear();
+		fired.clear();
+		for (size_t i = 0; i < expected.size(); i++) {
+			if (expected[i] == tick) {
+				due.insert(i);
+			}
+		}
+		for (void* owner : expired) {
+			fired.insert((Timer*)owner - timers->data());
+		}
+
+		if (due != fired) {
+			std::cerr << "FAILURE: timers expired wrongly on tick " << tick << " (" << fired.size() << " expired, " << due.size() << " due)" << std::endl;
+			return EXIT_FAILURE;
+		}
+
+		from = tick;
+	}
+
+	/**
+	 *	- Go around the whole hierarchy once more, so a timer that was
+	 *	  cancelled or lost would have had its chance to expire
+	 */
+	expired.clear();
+	wheel->advance(clock->during(from + MAX_TICKS), &expired);
+
+	if (check(expired.empty(), "timer expired after every timer was due") != EXIT_SUCCESS) {
+		return EXIT_FAILURE;
+	}
+
+	return check(wheel->get_wait_timeout(clock->during(from + MAX_TICKS)) == -1, "timer left scheduled after every timer was due");
+}
+
+/**
+ * \fn		int test_every_level
+ * \param	N/A
+ * \return	Returns EXIT_FAILURE upon any failed expectation,
+ *		and EXIT_SUCCESS otherwise
+ * \brief	Timers at OFFSETS from the start, and from a tick that is
+ *		on no slot boundary, cascade down and each expire exactly
+ *		once on their tick
+ */
+static int test_every_level() {
+	std::vector<Timer> timers;
+	std::vector<unsigned long long> expected;
+	std::vector<void*> expired;
+	unsigned long long base;
+	int failures;
+
+	failures = 0;
+
+	for (unsigned long long start : { 0ULL, 4000ULL, 262143ULL }) {
+		WheelClock clock;
+		TimerWheel wheel;
+
+		/**
+		 *	- Move to start first; with nothing scheduled the wheel
+		 *	  skips there at once
+		 */
+		wheel.advance(clock.during(start), &expired);
+		base = start;
+
+		size_t count = sizeof(OFFSETS) / sizeof(*OFFSETS);
+		init_timers(&timers, count * 2);
+		expected.clear();
+
+		for (size_t i = 0; i < count; i++) {
+			wheel.schedule(&timers[i], clock.deadline(base + OFFSETS[i]));
+			expected.push_back(base + OFFSETS[i]);
+		}
+
+		/**
+		 *	- A second timer on every tick, scheduled in reverse, so
+		 *	  slots hold several timers in either order
+		 */
+		for (size_t i = count; i-- > 0; ) {
+			wheel.schedule(&timers[count + i], clock.deadline(base + OFFSETS[i]));
+		}
+		expected.insert(expected.end(), expected.begin(), expected.end());
+
+		failures += expire_all(&wheel, &clock, &timers, expected, base);
+	}
+
+	return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+/**
+ * \fn		int test_cancel_and_reschedule
+ * \param	N/A
+ * \return	Returns EXIT_FAILURE upon any failed expectation,
+ *		and EXIT_SUCCESS otherwise
+ * \brief	Once the wheel has moved (so some timers have cascaded down a
+ *		wheel) a third of the timers are cancelled and a third are
+ *		moved, both nearer and further out. Cancelled timers never
+ *		expire, and moved ones only expire on their new tick
+ */
+static int test_cancel_and_reschedule() {
+	WheelClock clock;
+	TimerWheel wheel;
+	std::vector<Timer> timers;
+	std::vector<unsigned long long> expected;
+	std::vector<void*> expired;
+	std::set<void*> due;
+	Timer* cancelled;
+	unsigned long long now;
+	size_t count;
+	size_t pending;
+
+	count = sizeof(OFFSETS) / sizeof(*OFFSETS);
+	init_timers(&timers, count);
+
+	for (size_t i = 0; i < count; i++) {
+		wheel.schedule(&timers[i], clock.deadline(OFFSETS[i]));
+		expected.push_back(OFFSETS[i]);
+	}
+
+	/**
+	 *	- Move past the first cascade out of the third wheel (tick 4096),
+	 *	  so the timers still pending are in every wheel, some of them
+	 *	  moved down already
+	 */
+	now = 4100;
+	wheel.advance(clock.during(now), &expired);
+
+	for (size_t i = 0; i < count; i++) {
+		if (expected[i] <= now) {
+			due.insert(&timers[i]);
+			expected[i] = 0;
+		}
+	}
+
+	if (check(std::set<void*>(expired.begin(), expired.end()) == due && expired.size() == due.size(), "timers did not expire on the way to the cascade") != EXIT_SUCCESS) {
+		return EXIT_FAILURE;
+	}
+
+	/**
+	 *	- Cancel every third timer left, and move every third one to a
+	 *	  tick picked out of OFFSETS, nearer or further than before
+	 */
+	cancelled = NULL;
+	pending = 0;
+
+	for (size_t i = 0; i < count; i++) {
+		if (expected[i] == 0) {
+			continue;
+		}
+
+		if (pending % 3 == 0) {
+			wheel.cancel(&timers[i]);
+			expected[i] = 0;
+			cancelled = &timers[i];
+		}
+		else if (pending % 3 == 1) {
+			expected[i] = now + OFFSETS[(i * 7) % count];
+			wheel.schedule(&timers[i], clock.deadline(expected[i]));
+		}
+
+		pending++;
+	}
+
+	/**
+	 *	- Cancelling twice, or a timer that was never scheduled, does
+	 *	  nothing
+	 */
+	wheel.cancel(cancelled);
+
+	Timer unscheduled;
+	unscheduled.prev = NULL;
+	unscheduled.next = NULL;
+	wheel.cancel(&unscheduled);
+
+	return expire_all(&wheel, &clock, &timers, expected, now);
+}
+
+/**
+ * \fn		int test_clamped_deadlines
+ * \param	N/A
+ * \return	Returns EXIT_FAILURE upon any failed expectation,
+ *		and EXIT_SUCCESS otherwise
+ * \brief	A deadline already past, or in the current tick (whose slot
+ *		has already been expired), expires on the next tick, and one
+ *		beyond the range of the wheels on the last tick covered
+ */
+static int test_clamped_deadlines() {
+	WheelClock clock;
+	TimerWheel wheel;
+	std::vector<Timer> timers;
+	std::vector<unsigned long long> expected;
+	std::vector<void*> expired;
+
+	wheel.advance(clock.during(10), &expired);
+	init_timers(&timers, 4);
+
+	wheel.schedule(&timers[0], clock.deadline(3));
+	wheel.schedule(&timers[1], clock.deadline(10));
+	wheel.schedule(&timers[2], clock.deadline(10 + MAX_TICKS));
+	wheel.schedule(&timers[3], clock.deadline(10 + MAX_TICKS * 5));
+	expected = { 11, 11, 10 + MAX_TICKS - 1, 10 + MAX_TICKS - 1 };
+
+	return expire_all(&wheel, &clock, &timers, expected, 10);
+}
+
+int main() {
+	int failures;
+
+	failures = 0;
+	failures += test_every_level();
+	failures += test_cancel_and_reschedule();
+	failures += test_clamped_deadlines();
+
+	if (failures != 0) {
+		std::cerr << "TimerWheelTest: " << failures << " test(s) failed" << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	std::cout << "TimerWheelTest: all tests passed" << std::endl;
+	return EXIT_SUCCESS;
+}
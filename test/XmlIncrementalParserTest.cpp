@@ -0,0 +1,396 @@
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "../include/pugiconfig.hpp"
+#include "../include/pugixml.hpp"
+
+/**
+ * \def		RANDOM_SEED
+ * \brief	Seed of the randomized tests, so a failure can be replayed
+ */
+#define RANDOM_SEED	(3)
+
+/**
+ * \def		RANDOM_ITERATIONS
+ * \brief	Number of random streams fed by test_random_streams
+ */
+#define RANDOM_ITERATIONS	(5000)
+
+/**
+ * \def		MAX_CHUNK_SIZE
+ * \brief	Largest chunk the randomized tests feed at once
+ */
+#define MAX_CHUNK_SIZE	(7)
+
+/**
+ * \var		const char* DOCUMENTS[]
+ * \brief	Documents the randomized tests build their streams from. Each
+ *		hides markup characters where only the full markup rules
+ *		tell they do not end the document
+ */
+static const char* DOCUMENTS[] = {
+	"<a/>",
+	"<a></a>",
+	"<?xml version='1.0'?><r x='>' y=\"/>\"><b/>text &amp; > more<c a='1'/></r>",
+	"<!-- c -- > --><r><!-- <x> --><![CDATA[ </r> ]] ]]> ]]><p><?pi ?> ?></p></r>",
+	"<!DOCTYPE r [ <!ELEMENT r ANY> <!ENTITY e \">\"> ]><r>&e;</r>",
+	"\xef\xbb\xbf<r/>",
+	"<Request><Command>GetPlayerInfo</Command><Data><Row Type=\"CardNumber\">1</Row></Data></Request>",
+	"<r\n a = '1'\n/>",
+	"<a><b><c></c></b><d/></a>",
+	"<!---->\n<r/>",
+	"<!--->--><r>--></r>"
+};
+
+/**
+ * \fn		int check
+ * \param	bool condition
+ * \param	const char *message
+ * \return	Returns EXIT_SUCCESS if condition holds, and EXIT_FAILURE
+ *		(after printing message) otherwise
+ * \brief	Reports a failed expectation
+ */
+static int check(bool condition, const char* message) {
+	if (!condition) {
+		std::cerr << "FAILURE: " << message << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	return EXIT_SUCCESS;
+}
+
+/**
+ * \fn		pugi::xml_incremental_status feed_bytes
+ * \param	pugi::xml_incremental_parser *parser
+ * \param	const std::string &stream
+ * \param	size_t *position
+ * \return	Returns the status of the feed that ended the document (or
+ *		failed), or incremental_more if stream ran out first
+ * \brief	Feeds stream to parser one byte at a time from position,
+ *		the way it would arrive from the slowest client. position is
+ *		moved past every byte parser consumed
+ */
+static pugi::xml_incremental_status feed_bytes(pugi::xml_incremental_parser* parser, const std::string& stream, size_t* position) {
+	pugi::xml_incremental_status status;
+	size_t consumed;
+
+	status = pugi::incremental_more;
+	while (*position < stream.size() && status == pugi::incremental_more) {
+		status = parser->feed(stream.data() + *position, 1, &consumed);
+		*position += consumed;
+	}
+
+	return status;
+}
+
+/**
+ * \fn		int check_document
+ * \param	const std::string &document
+ * \return	Returns EXIT_FAILURE upon any failed expectation,
+ *		and EXIT_SUCCESS otherwise
+ * \brief	document, fed one byte at a time, is only complete once its
+ *		last byte is fed, and pugixml agrees it is well-formed
+ */
+static int check_document(const std::string& document) {
+	pugi::xml_incremental_parser parser;
+	pugi::xml_document xml;
+	size_t position;
+	int failures;
+
+	failures = 0;
+	position = 0;
+
+	failures += check(feed_bytes(&parser, document, &position) == pugi::incremental_complete, ("document never completed: " + document).c_str());
+	failures += check(position == document.size() && parser.length() == document.size(), ("document completed before its end: " + document).c_str());
+	failures += check(parser.depth() == 0, ("elements left open at the end: " + document).c_str());
+	failures += check(xml.load_buffer(document.data(), document.size()), ("document is not well-formed: " + document).c_str());
+
+	return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+/**
+ * \fn		int test_quotes_in_start_tags
+ * \param	N/A
+ * \return	Returns EXIT_FAILURE upon any failed expectation,
+ *		and EXIT_SUCCESS otherwise
+ * \brief	>, /> and </ inside quoted attribute values do not end a tag,
+ *		an empty element, or the document
+ */
+static int test_quotes_in_start_tags() {
+	int failures;
+
+	failures = 0;
+	failures += check_document("<r x='>' y=\"/>\"><b a=\"</r>\"/></r>");
+	failures += check_document("<r a='\"/>' b=\"'>\"/>");
+	failures += check_document("<r a=\"/\"></r>");
+
+	return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+/**
+ * \fn		int test_quotes_in_doctype
+ * \param	N/A
+ * \return	Returns EXIT_FAILURE upon any failed expectation,
+ *		and EXIT_SUCCESS otherwise
+ * \brief	> and ] inside quoted literals of the document type
+ *		declaration, in or out of its internal subset, do not end it
+ */
+static int test_quotes_in_doctype() {
+	int failures;
+
+	failures = 0;
+	failures += check_document("<!DOCTYPE r SYSTEM \"r>.dtd\"><r/>");
+	failures += check_document("<!DOCTYPE r [ <!ENTITY e \"]>\"> <!ENTITY f '>'> ]><r>&e;&f;</r>");
+	failures += check_document("<!DOCTYPE r PUBLIC '-//>//EN' \"r.dtd\" [ <!ELEMENT r ANY> ]><r/>");
+
+	return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+/**
+ * \fn		int test_comment_open
+ * \param	N/A
+ * \return	Returns EXIT_FAILURE upon any failed expectation,
+ *		and EXIT_SUCCESS otherwise
+ * \brief	The dashes that open a comment do not count towards the -->
+ *		that closes it, so <!--> and <!---> leave it open
+ */
+static int test_comment_open() {
+	int failures;
+
+	failures = 0;
+	failures += check_document("<!-->--><r/>");
+	failures += check_document("<!--->--><r/>");
+	failures += check_document("<r><!-->--></r>");
+	failures += check_document("<r><!--></r>--></r>");
+
+	return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+/**
+ * \fn		int test_split_cdata_end
+ * \param	N/A
+ * \return	Returns EXIT_FAILURE upon any failed expectation,
+ *		and EXIT_SUCCESS otherwise
+ * \brief	A CDATA section ends at ]]> wherever the feeds split it,
+ *		and not at ]> or ] ]>
+ */
+static int test_split_cdata_end() {
+	std::string document;
+	pugi::xml_incremental_status status;
+	size_t consumed;
+	int failures;
+
+	failures = 0;
+	document = "<r><![CDATA[ ]> ] ]> </r> ]]]></r>";
+
+	failures += check_document(document);
+
+	for (size_t split = 0; split <= document.size(); split++) {
+		pugi::xml_incremental_parser parser;
+
+		status = parser.feed(document.data(), split, &consumed);
+		if (split < document.size()) {
+			failures += check(status == pugi::incremental_more && consumed == split, "first feed ended the document early");
+			status = parser.feed(document.data() + split, document.size() - split, &consumed);
+		}
+
+		failures += check(status == pugi::incremental_complete && parser.length() == document.size(), "document split in two feeds did not complete at its end");
+	}
+
+	return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+/**
+ * \fn		int test_bom
+ * \param	N/A
+ * \return	Returns EXIT_FAILURE upon any failed expectation,
+ *		and EXIT_SUCCESS otherwise
+ * \brief	The UTF-8 BOM is only allowed as the very first bytes of a
+ *		document, not after leading whitespace
+ */
+static int test_bom() {
+	pugi::xml_incremental_parser parser;
+	std::string stream;
+	size_t position;
+	int failures;
+
+	failures = 0;
+	failures += check_document("\xef\xbb\xbf<r/>");
+
+	stream = " \xef\xbb\xbf<r/>";
+	position = 0;
+
+	failures += check(feed_bytes(&parser, stream, &position) == pugi::incremental_error, "BOM after whitespace was accepted");
+	failures += check(position == 1, "BOM after whitespace was not the offending byte");
+
+	return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+/**
+ * \fn		int test_error_not_consumed
+ * \param	N/A
+ * \return	Returns EXIT_FAILURE upon any failed expectation,
+ *		and EXIT_SUCCESS otherwise
+ * \brief	On error, consumed and length stop at the offending byte,
+ *		and later feeds consume nothing until the parser is reset
+ */
+static int test_error_not_consumed() {
+	pugi::xml_incremental_parser parser;
+	pugi::xml_incremental_status status;
+	std::string stream;
+	size_t position;
+	size_t consumed;
+	int failures;
+
+	failures = 0;
+
+	/**
+	 *	- Offending byte in the middle of a single feed
+	 */
+	stream = "  x<r/>";
+	status = parser.feed(stream.data(), stream.size(), &consumed);
+
+	failures += check(status == pugi::incremental_error && consumed == 2 && parser.length() == 2, "error byte was consumed in one feed");
+
+	status = parser.feed("<r/>", 4, &consumed);
+	failures += check(status == pugi::incremental_error && consumed == 0 && parser.length() == 2, "feed after an error consumed bytes");
+
+	/**
+	 *	- Offending byte fed on its own
+	 */
+	parser.reset();
+	stream = "<a><b/></a>x";
+	position = 0;
+
+	failures += check(feed_bytes(&parser, stream, &position) == pugi::incremental_complete && position == 11, "document before the stray byte did not complete");
+
+	parser.reset();
+	failures += check(feed_bytes(&parser, stream, &position) == pugi::incremental_error && position == 11 && parser.length() == 0, "stray byte after a document was consumed");
+
+	parser.reset();
+	stream = "</a>";
+	position = 0;
+
+	failures += check(feed_bytes(&parser, stream, &position) == pugi::incremental_error && position == 1, "end tag outside of the root element was consumed");
+
+	return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+/**
+ * \fn		int test_random_streams
+ * \param	N/A
+ * \return	Returns EXIT_FAILURE upon any failed expectation,
+ *		and EXIT_SUCCESS otherwise
+ * \brief	Streams of back-to-back DOCUMENTS, fed in random chunks of up
+ *		to MAX_CHUNK_SIZE bytes with whitespace skipped between them,
+ *		are split exactly where each document ends
+ */
+static int test_random_streams() {
+	std::mt19937 random(RANDOM_SEED);
+	std::string stream;
+	std::string document;
+	std::vector<size_t> ends;
+	std::vector<size_t> found;
+	pugi::xml_incremental_status status;
+	pugi::xml_document xml;
+	size_t position;
+	size_t start;
+	size_t chunk;
+	size_t consumed;
+	size_t count;
+
+	count = sizeof(DOCUMENTS) / sizeof(*DOCUMENTS);
+
+	for (int iteration = 0; iteration < RANDOM_ITERATIONS; iteration++) {
+		stream.clear();
+		ends.clear();
+		found.clear();
+
+		/**
+		 *	- Build the stream. Only its first document may start with
+		 *	  the BOM
+		 */
+		for (size_t i = 1 + random() % 5; i > 0; i--) {
+			document = DOCUMENTS[random() % count];
+			if (!stream.empty() && document[0] == '\xef') {
+				document.erase(0, 3);
+			}
+
+			stream += document;
+			ends.push_back(stream.size());
+			stream.append(random() % 3, '\n');
+		}
+
+		/**
+		 *	- Feed it, skipping the whitespace between documents as the
+		 *	  framing does
+		 */
+		pugi::xml_incremental_parser parser;
+		position = 0;
+		start = 0;
+
+		while (position < stream.size()) {
+			if (parser.length() == 0) {
+				while (position < stream.size() && stream[position] == '\n') {
+					position++;
+				}
+
+				start = position;
+				if (position == stream.size()) {
+					break;
+				}
+			}
+
+			chunk = std::min<size_t>(1 + random() % MAX_CHUNK_SIZE, stream.size() - position);
+			status = parser.feed(stream.data() + position, chunk, &consumed);
+			position += consumed;
+
+			if (status == pugi::incremental_error) {
+				return check(false, ("random stream failed: " + stream).c_str());
+			}
+			else if (status == pugi::incremental_complete) {
+				if (!xml.load_buffer(stream.data() + start, position - start)) {
+					return check(false, ("random stream was split inside a document: " + stream).c_str());
+				}
+
+				found.push_back(position);
+				parser.reset();
+			}
+			else if (consumed != chunk) {
+				return check(false, ("bytes of an incomplete document were left: " + stream).c_str());
+			}
+		}
+
+		if (found != ends) {
+			return check(false, ("random stream was split in the wrong places: " + stream).c_str());
+		}
+	}
+
+	return EXIT_SUCCESS;
+}
+
+int main() {
+	int failures;
+
+	failures = 0;
+	failures += test_quotes_in_start_tags();
+	failures += test_quotes_in_doctype();
+	failures += test_comment_open();
+	failures += test_split_cdata_end();
+	failures += test_bom();
+	failures += test_error_not_consumed();
+	failures += test_random_streams();
+
+	if (failures != 0) {
+		std::cerr << "XmlIncrementalParserTest: " << failures << " test(s) failed" << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	std::cout << "XmlIncrementalParserTest: all tests passed" << std::endl;
+	return EXIT_SUCCESS;
+}